@@ -9,7 +9,6 @@
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/account_object.hpp>
-#include <eosio/chain/fioaction_object.hpp>
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <boost/container/flat_set.hpp>
@@ -46,7 +45,6 @@ namespace eosio {
 
         void apply_context::exec_one() {
             auto start = fc::time_point::now();
-            int32_t HF1_BLOCK_TIME = 1600876800; //Wed Sep 23 16:00:00 UTC 2020
 
             action_receipt r;
             r.receiver = receiver;
@@ -55,7 +53,6 @@ namespace eosio {
             const auto &cfg = control.get_global_properties().configuration;
             const account_metadata_object *receiver_account = nullptr;
             const account_metadata_object *receiver_tmp = nullptr;
-            const fioaction_object *fioaction_item = nullptr;
 
             try {
                 try {
@@ -65,14 +62,12 @@ namespace eosio {
                     auto native = control.find_apply_handler(receiver, act->account, act->name);
                     if (act->name != name("nonce")) {
                         //Special note, this is the hardfork to integrate the whitelist in state.
-                        if (control.head_block_time().sec_since_epoch() > HF1_BLOCK_TIME) {
-                            action_name  thename = act->name;
-                            fioaction_item = db.find<fioaction_object, by_actionname>(thename);
-                            EOS_ASSERT(fioaction_item != nullptr, action_validate_exception,
+                        if (control.head_block_time().sec_since_epoch() > fioio::HF1_BLOCK_TIME) {
+                            EOS_ASSERT(control.is_fio_action_registered(act->name), action_validate_exception,
                                        "Unknown action ${action} in contract ${contract}",
                                        ("action", act->name)("contract", act->account));
                         }else {
-                            EOS_ASSERT(act->account.to_string() == fioio::map_to_contract(act->name.to_string()), action_validate_exception,
+                            EOS_ASSERT(act->account.value == fioio::map_to_contract(act->name.value), action_validate_exception,
                                        "Unknown action ${action} in contract ${contract}",
                                        ("action", act->name)("contract", act->account));
                         }
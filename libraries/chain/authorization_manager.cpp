@@ -15,6 +15,8 @@
 #include <boost/tuple/tuple_io.hpp>
 #include <eosio/chain/database_utils.hpp>
 
+#include <tuple>
+
 
 namespace eosio {
     namespace chain {
@@ -25,8 +27,98 @@ namespace eosio {
                 permission_link_index
         >;
 
+        /**
+         * What's cached must not outlive the state it was derived from. Everything derived from an account's permissions
+         * is dropped when they change; the change may still be undone by its transaction failing, so nothing about the
+         * account is cached again for the rest of the block. Aborted and popped blocks are forgotten along with the
+         * whole cache when the next block starts.
+         */
+        struct authorization_manager::authorization_cache {
+            // The inputs of a check other than the permission and delay: these are the same for all the permissions a
+            // transaction declares.
+            struct signers {
+                flat_set<public_key_type> keys;
+                flat_set<permission_level> permissions;
+                uint16_t depth_limit = 0;
+            };
+
+            using signers_ref = std::tuple<const flat_set<public_key_type> &, const flat_set<permission_level> &,
+                                           const uint16_t &>;
+
+            struct signers_less {
+                using is_transparent = void;
+
+                static signers_ref as_tuple(const signers &s) { return signers_ref(s.keys, s.permissions, s.depth_limit); }
+
+                static const signers_ref &as_tuple(const signers_ref &s) { return s; }
+
+                template<typename L, typename R>
+                bool operator()(const L &lhs, const R &rhs) const { return as_tuple(lhs) < as_tuple(rhs); }
+            };
+
+            struct satisfaction {
+                bool satisfied = false;
+                vector<bool> used_keys;
+                // the accounts whose permissions the check looked up
+                flat_set<account_name> accounts;
+            };
+
+            using satisfactions = map<std::pair<permission_level, fc::microseconds>, satisfaction>;
+
+            map<permission_level, authority> authorities;
+            map<signers, satisfactions, signers_less> results;
+            flat_set<account_name> changed_accounts;
+
+            void clear() {
+                authorities.clear();
+                results.clear();
+                changed_accounts.clear();
+            }
+
+            void permissions_changed(account_name account) {
+                changed_accounts.insert(account);
+
+                auto itr = authorities.lower_bound(permission_level{account, permission_name()});
+                while (itr != authorities.end() && itr->first.actor == account)
+                    itr = authorities.erase(itr);
+
+                for (auto &r : results) {
+                    for (auto itr = r.second.begin(); itr != r.second.end();) {
+                        if (itr->second.accounts.count(account))
+                            itr = r.second.erase(itr);
+                        else
+                            ++itr;
+                    }
+                }
+            }
+        };
+
         authorization_manager::authorization_manager(controller &c, database &d)
-                : _control(c), _db(d) {}
+                : _control(c), _db(d), _cache(std::make_unique<authorization_cache>()) {}
+
+        authorization_manager::~authorization_manager() {}
+
+        void authorization_manager::reset_authorization_cache() {
+            _cache->clear();
+        }
+
+        void authorization_manager::permissions_changed(account_name account) {
+            _cache->permissions_changed(account);
+        }
+
+        const authority &authorization_manager::cached_authority(const permission_level &level,
+                                                                 std::deque<authority> &uncached) const {
+            auto itr = _cache->authorities.find(level);
+            if (itr != _cache->authorities.end())
+                return itr->second;
+
+            authority auth = get_permission(level).auth;
+            if (_cache->changed_accounts.count(level.actor)) {
+                uncached.emplace_back(std::move(auth));
+                return uncached.back();
+            }
+            return _cache->authorities.emplace(level, std::move(auth)).first->second;
+        }
 
         void authorization_manager::add_indices() {
             authorization_index_set::add_indices(_db);
@@ -126,6 +218,7 @@ namespace eosio {
         }
 
         void authorization_manager::read_from_snapshot(const snapshot_reader_ptr &snapshot) {
+            _cache->clear();
             authorization_index_set::walk_indices([this, &snapshot](auto utils) {
                 using section_t = typename decltype(utils)::index_t::value_type;
 
@@ -168,6 +261,7 @@ namespace eosio {
                 p.last_updated = creation_time;
                 p.auth = auth;
             });
+            permissions_changed(account);
             return perm;
         }
 
@@ -194,6 +288,7 @@ namespace eosio {
                 p.last_updated = creation_time;
                 p.auth = std::move(auth);
             });
+            permissions_changed(account);
             return perm;
         }
 
@@ -202,6 +297,7 @@ namespace eosio {
                 po.auth = auth;
                 po.last_updated = _control.pending_block_time();
             });
+            permissions_changed(permission.owner);
         }
 
         void authorization_manager::remove_permission(const permission_object &permission) {
@@ -210,8 +306,10 @@ namespace eosio {
             EOS_ASSERT(range.first == range.second, action_validate_exception,
                        "Cannot remove a permission which has children. Remove the children first.");
 
+            const account_name owner = permission.owner;
             _db.get_mutable_index<permission_usage_index>().remove_object(permission.usage_id._id);
             _db.remove(permission);
+            permissions_changed(owner);
         }
 
         void authorization_manager::update_permission_usage(const permission_object &permission) {
@@ -452,14 +550,55 @@ namespace eosio {
             auto effective_provided_delay = (provided_delay >= delay_max_limit) ? fc::microseconds::maximum()
                                                                                 : provided_delay;
 
-            auto checker = make_auth_checker([&](const permission_level &p) { return get_permission(p).auth; },
-                                             _control.get_global_properties().configuration.max_authority_depth,
+            const uint16_t depth_limit = _control.get_global_properties().configuration.max_authority_depth;
+
+            // the accounts whose permissions the check in progress looked up
+            flat_set<account_name> looked_up_accounts;
+            std::deque<authority> uncached_authorities;
+            auto checker = make_auth_checker([&](const permission_level &p) -> const authority & {
+                                                 looked_up_accounts.insert(p.actor);
+                                                 return cached_authority(p, uncached_authorities);
+                                             },
+                                             depth_limit,
                                              provided_keys,
                                              provided_permissions,
                                              effective_provided_delay,
                                              checktime
             );
 
+            // Whether a permission is satisfied, and the keys satisfying it uses, only depend on the inputs of the
+            // check and on the permissions of the accounts it looked up.
+            auto signers = _cache->results.find(
+                    authorization_cache::signers_ref(provided_keys, provided_permissions, depth_limit));
+            auto satisfied = [&](const permission_level &permission, fc::microseconds delay) {
+                if (signers != _cache->results.end()) {
+                    auto itr = signers->second.find({permission, delay});
+                    if (itr != signers->second.end()) {
+                        if (itr->second.satisfied)
+                            checker.use_keys(itr->second.used_keys);
+                        return itr->second.satisfied;
+                    }
+                }
+
+                looked_up_accounts.clear();
+                authorization_cache::satisfaction result;
+                result.satisfied = checker.satisfied(permission, delay, result.used_keys);
+
+                for (const auto &a : looked_up_accounts) {
+                    if (_cache->changed_accounts.count(a))
+                        return result.satisfied;
+                }
+                if (signers == _cache->results.end()) {
+                    signers = _cache->results.emplace(
+                            authorization_cache::signers{provided_keys, provided_permissions, depth_limit},
+                            authorization_cache::satisfactions()).first;
+                }
+                const bool is_satisfied = result.satisfied;
+                result.accounts = std::move(looked_up_accounts);
+                signers->second.emplace(std::make_pair(permission, delay), std::move(result));
+                return is_satisfied;
+            };
+
             map<permission_level, fc::microseconds> permissions_to_satisfy;
 
             for (const auto &act : actions) {
@@ -522,7 +661,7 @@ namespace eosio {
             // ascending order of the actor name with ties broken by ascending order of the permission name.
             for (const auto &p : permissions_to_satisfy) {
                 checktime(); // TODO: this should eventually move into authority_checker instead
-                EOS_ASSERT(checker.satisfied(p.first, p.second), unsatisfied_authorization,
+                EOS_ASSERT(satisfied(p.first, p.second), unsatisfied_authorization,
                            "transaction declares authority '${auth}', "
                            "but does not have signatures for it under a provided delay of ${provided_delay} ms, "
                            "provided permissions ${provided_permissions}, provided keys ${provided_keys}, "
@@ -4,8 +4,13 @@
  */
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <atomic>
+#include <cstring>
 #include <fstream>
+#include <mutex>
 #include <fc/io/raw.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
@@ -25,10 +30,37 @@ namespace eosio {
         const uint32_t block_log::max_supported_version = 2;
 
         namespace detail {
+            /**
+             * Read-only mapping of a log file as it was when mapped. Appends do not move existing bytes, so a
+             * view stays valid for everything it covers; readers keep it alive while they unpack from it.
+             */
+            class mapped_view {
+            public:
+                mapped_view(const fc::path &file, uint64_t size) {
+                    if (size > 0) {
+                        mapping = boost::interprocess::file_mapping(file.generic_string().c_str(),
+                                                                    boost::interprocess::read_only);
+                        region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only, 0,
+                                                                    size);
+                    }
+                }
+
+                const char *data() const { return static_cast<const char *>(region.get_address()); }
+
+                uint64_t size() const { return region.get_size(); }
+
+            private:
+                boost::interprocess::file_mapping mapping;
+                boost::interprocess::mapped_region region;
+            };
+
+            using mapped_view_ptr = std::shared_ptr<const mapped_view>;
+
             class block_log_impl {
             public:
                 signed_block_ptr head;
                 block_id_type head_id;
+                std::atomic<uint32_t> head_num{0}; ///< 0 when the log has no blocks
                 std::fstream block_stream;
                 std::fstream index_stream;
                 fc::path block_file;
@@ -37,6 +69,34 @@ namespace eosio {
                 bool genesis_written_to_block_log = false;
                 uint32_t version = 0;
                 uint32_t first_block_num = 0;
+                /// guards the streams and the views below; recursive as appending may reopen, which closes, the files
+                std::recursive_mutex mtx;
+                mapped_view_ptr block_view;
+                mapped_view_ptr index_view;
+
+                /**
+                 * @return a view of file covering at least [0, end), remapping if the current one is too short,
+                 *         or a view that is still too short if the file itself is
+                 */
+                mapped_view_ptr get_view(mapped_view_ptr &view, const fc::path &file, uint64_t end) {
+                    std::lock_guard<std::recursive_mutex> g(mtx);
+                    if (!view || view->size() < end) {
+                        // appends happen under mtx, so the size seen here always ends on a block boundary
+                        if (open_files) {
+                            block_stream.flush();
+                            index_stream.flush();
+                        }
+                        view = std::make_shared<const mapped_view>(file, fc::file_size(file));
+                    }
+                    return view;
+                }
+
+                void drop_views() {
+                    // readers hold on to the views they got, the mappings go away with the last of them
+                    std::lock_guard<std::recursive_mutex> g(mtx);
+                    block_view.reset();
+                    index_view.reset();
+                }
 
                 inline void check_open_files() {
                     if (!open_files) {
@@ -47,6 +107,8 @@ namespace eosio {
                 void reopen();
 
                 void close() {
+                    std::lock_guard<std::recursive_mutex> g(mtx);
+                    drop_views();
                     if (block_stream.is_open())
                         block_stream.close();
                     if (index_stream.is_open())
@@ -56,6 +118,7 @@ namespace eosio {
             };
 
             void block_log_impl::reopen() {
+                std::lock_guard<std::recursive_mutex> g(mtx);
                 close();
 
                 // open to create files if they don't exist
@@ -152,6 +215,7 @@ namespace eosio {
                 } else {
                     my->head_id = {};
                 }
+                my->head_num = my->head ? my->head->block_num() : 0;
 
                 if (index_size) {
                     ilog("Index is nonempty");
@@ -187,6 +251,8 @@ namespace eosio {
                 EOS_ASSERT(my->genesis_written_to_block_log, block_log_append_fail,
                            "Cannot append to block log until the genesis is first written");
 
+                auto data = fc::raw::pack(*b);
+                std::lock_guard<std::recursive_mutex> g(my->mtx);
                 my->check_open_files();
 
                 my->block_stream.seekp(0, std::ios::end);
@@ -197,14 +263,15 @@ namespace eosio {
                            "Append to index file occuring at wrong position.",
                            ("position", (uint64_t) my->index_stream.tellp())
                                    ("expected", (b->block_num() - my->first_block_num) * sizeof(uint64_t)));
-                auto data = fc::raw::pack(*b);
                 my->block_stream.write(data.data(), data.size());
                 my->block_stream.write((char *) &pos, sizeof(pos));
                 my->index_stream.write((char *) &pos, sizeof(pos));
                 my->head = b;
                 my->head_id = b->id();
+                my->head_num = b->block_num();
 
-                flush();
+                my->block_stream.flush();
+                my->index_stream.flush();
 
                 return pos;
             }
@@ -242,6 +309,7 @@ namespace eosio {
             } else {
                 my->head.reset();
                 my->head_id = {};
+                my->head_num = 0;
             }
 
             auto pos = my->block_stream.tellp();
@@ -255,13 +323,15 @@ namespace eosio {
         }
 
         std::pair<signed_block_ptr, uint64_t> block_log::read_block(uint64_t pos) const {
-            my->check_open_files();
+            const auto view = my->get_view(my->block_view, my->block_file, pos + 1);
+            EOS_ASSERT(pos < view->size(), block_log_exception, "Block position ${pos} is past the end of the block log",
+                       ("pos", pos));
 
-            my->block_stream.seekg(pos);
             std::pair<signed_block_ptr, uint64_t> result;
             result.first = std::make_shared<signed_block>();
-            fc::raw::unpack(my->block_stream, *result.first);
-            result.second = uint64_t(my->block_stream.tellg()) + 8;
+            fc::datastream<const char *> ds(view->data() + pos, view->size() - pos);
+            fc::raw::unpack(ds, *result.first);
+            result.second = pos + ds.tellp() + 8;
             return result;
         }
 
@@ -279,28 +349,45 @@ namespace eosio {
             } FC_LOG_AND_RETHROW()
         }
 
+        std::vector<char> block_log::read_block_raw_by_num(uint32_t block_num) const {
+            std::vector<char> raw;
+            const uint64_t pos = get_block_pos(block_num);
+            if (pos == npos) return raw;
+
+            const auto view = my->get_view(my->block_view, my->block_file, pos + 1);
+            uint64_t end = get_block_pos(block_num + 1);
+            if (end == npos || end > view->size()) {
+                end = view->size();
+            }
+            // each block is followed by its own position
+            EOS_ASSERT(end >= pos + sizeof(uint64_t), block_log_exception,
+                       "Block ${n} has invalid extent in block log", ("n", block_num));
+            raw.assign(view->data() + pos, view->data() + end - sizeof(uint64_t));
+            return raw;
+        }
+
         uint64_t block_log::get_block_pos(uint32_t block_num) const {
-            my->check_open_files();
-            if (!(my->head && block_num <= block_header::num_from_id(my->head_id) && block_num >= my->first_block_num))
+            if (!(my->head_num && block_num <= my->head_num && block_num >= my->first_block_num))
+                return npos;
+            const uint64_t offset = sizeof(uint64_t) * (block_num - my->first_block_num);
+            const auto view = my->get_view(my->index_view, my->index_file, offset + sizeof(uint64_t));
+            if (view->size() < offset + sizeof(uint64_t))
                 return npos;
-            my->index_stream.seekg(sizeof(uint64_t) * (block_num - my->first_block_num));
             uint64_t pos;
-            my->index_stream.read((char *) &pos, sizeof(pos));
+            memcpy(&pos, view->data() + offset, sizeof(pos));
             return pos;
         }
 
         signed_block_ptr block_log::read_head() const {
-            my->check_open_files();
+            const auto view = my->get_view(my->block_view, my->block_file, fc::file_size(my->block_file));
 
             uint64_t pos;
 
             // Check that the file is not empty
-            my->block_stream.seekg(0, std::ios::end);
-            if (my->block_stream.tellg() <= sizeof(pos))
+            if (view->size() <= sizeof(pos))
                 return {};
 
-            my->block_stream.seekg(-sizeof(pos), std::ios::end);
-            my->block_stream.read((char *) &pos, sizeof(pos));
+            memcpy(&pos, view->data() + view->size() - sizeof(pos), sizeof(pos));
             if (pos != npos) {
                 return read_block(pos).first;
             } else {
@@ -361,6 +448,7 @@ namespace eosio {
                     ilog("Block log index reconstructed for block ${n}", ("n", tmp.block_num()));
                 my->index_stream.write((char *) &pos, sizeof(pos));
             }
+            my->drop_views();
         } // construct_index
 
         fc::path block_log::repair_log(const fc::path &data_dir, uint32_t truncate_at_block) {
@@ -7,6 +7,7 @@
 
 #include <eosio/chain/account_object.hpp>
 #include <eosio/chain/fioaction_object.hpp>
+#include <eosio/chain/replay_pipeline.hpp>
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/block_summary_object.hpp>
 #include <eosio/chain/eosio_contract.hpp>
@@ -248,6 +249,41 @@ namespace eosio {
     */
             unapplied_transactions_type unapplied_transactions;
 
+            /**
+             * Action names registered in fioaction_index, probed by apply_context::exec_one for every action
+             * after HF1. addaction/remaction drop it. An undo that changes the registry is caught by comparing
+             * the highest id and size it was built from: undoing a create lowers the highest id, since ids are
+             * not reused going forward, and undoing a remove raises the size.
+             */
+            struct fioaction_cache_type {
+                flat_set<uint64_t> names;
+                int64_t highest_id = -1;
+                uint64_t size = 0;
+                bool valid = false;
+            } fioaction_cache;
+
+            const flat_set<uint64_t> &registered_fio_actions() {
+                const auto &idx = db.get_index<fioaction_index, by_id>();
+                const int64_t highest_id = idx.empty() ? -1 : idx.rbegin()->id._id;
+                if (!fioaction_cache.valid || fioaction_cache.highest_id != highest_id ||
+                    fioaction_cache.size != idx.size()) {
+                    fioaction_cache.names.clear();
+                    fioaction_cache.names.reserve(idx.size());
+                    for (const auto &a : idx) {
+                        fioaction_cache.names.insert(a.actionname.value);
+                    }
+                    fioaction_cache.highest_id = highest_id;
+                    fioaction_cache.size = idx.size();
+                    fioaction_cache.valid = true;
+                }
+                return fioaction_cache.names;
+            }
+
+            bool is_fio_action_registered(const action_name &act) {
+                const auto &names = registered_fio_actions();
+                return names.find(act.value) != names.end();
+            }
+
             void pop_block() {
                 auto prev = fork_db.get_block(head->header.previous);
 
@@ -311,7 +347,7 @@ namespace eosio {
                                         cfg.reversible_cache_size, false, cfg.db_map_mode, cfg.db_hugepage_paths),
                       blog(cfg.blocks_dir),
                       fork_db(cfg.state_dir),
-                      wasmif(cfg.wasm_runtime, db),
+                      wasmif(cfg.wasm_runtime, db, cfg.wasm_cache_dir),
                       resource_limits(db),
                       authorization(s, db),
                       protocol_features(std::move(pfs)),
@@ -493,62 +529,32 @@ namespace eosio {
                     ilog("existing block log, attempting to replay from ${s} to ${n} blocks",
                          ("s", start_block_num)("n", blog_head->block_num()));
                     try {
-                      bool go = true;
-                      int count = 500;
-                      std::array<signed_block_ptr, 500> blks;
-                      std::array<signed_block_ptr, 500> blks_fut;
-
-                      for (int i = 0; i < 500; i++) {
-                        auto next = blog.read_block_by_num( head->block_num + 1 + i);
-                        if (next) {
-                          blks[i] = next;
-                        } else {
-                          go = false;
-                          count = i;
-                          break;
-                        }
-                      }
-                      if (!go) {
-                        for (int i = 0; i < count; i++) {
-                          replay_push_block( (blks[i]), controller::block_status::irreversible );
+                        replay_pipeline pipeline(blog, start_block_num, blog_head->block_num(),
+                                                 conf.replay_pipeline_depth, conf.replay_threads, chain_id,
+                                                 conf.force_all_checks);
+                        fc::microseconds apply_time;
+                        auto report = [&]() {
+                            const auto stats = pipeline.get_stats();
+                            const double secs = std::max<int64_t>(apply_time.count(), 1) / 1000000.0;
+                            ilog("${n} of ${head}: read ${r} ms (${mb} MiB), unpack ${u} ms over ${t} threads, "
+                                 "apply waited ${w} ms, apply ${a} ms (${bps} blocks/s)",
+                                 ("n", head->block_num)("head", blog_head->block_num())
+                                         ("r", stats.read_time.count() / 1000)("mb", stats.bytes / (1024 * 1024))
+                                         ("u", stats.unpack_time.count() / 1000)("t", conf.replay_threads)
+                                         ("w", stats.wait_time.count() / 1000)("a", apply_time.count() / 1000)
+                                         ("bps", uint64_t(stats.blocks / secs)));
+                        };
+
+                        while (auto next = pipeline.next()) {
+                            auto apply_start = fc::time_point::now();
+                            replay_push_block(next->block, controller::block_status::irreversible,
+                                              std::move(next->trxs));
+                            apply_time += fc::time_point::now() - apply_start;
+
+                            if (head->block_num % 10000 == 0) report();
+                            if (shutdown()) break;
                         }
-                      }
-
-                      while( go ) {
-                         auto load = fc::time_point::now();
-                         auto fillhead = head->block_num + 500;
-                         std::future<int> res = async_thread_pool( thread_pool.get_executor(), [&blks_fut, fillhead, t=this]() {
-                           int nextcount = 500;
-                           for (int i = 0; i < 500; i++) {
-                             auto next = t->blog.read_block_by_num(fillhead + 1 + i);
-                             if (next) {
-                               blks_fut[i] = next;
-                             } else {
-                               nextcount = i;
-                               break;
-                             }
-                           }
-                           return nextcount;
-                         });
-                         auto loaded = fc::time_point::now();
-
-                         for (int i = 0; i < count; i++) {
-                           replay_push_block( (blks[i]), controller::block_status::irreversible );
-                         }
-                         auto processed = fc::time_point::now();
-                         count = res.get();
-                         auto gathered = fc::time_point::now();
-                         if (count != 500) {
-                           for (int i = 0; i < count; i++) {
-                             replay_push_block( (blks_fut[i]), controller::block_status::irreversible );
-                           }
-                           go = false;
-                         } else {
-                           std::swap(blks, blks_fut);
-                           ilog( "${n} of ${head}, thread launch: ${l} ms, wait: ${g} ms, processing: ${p} ms", ("n", (blks[count-1])->block_num()) ("head", blog_head->block_num()) ("l", (loaded-load).count()/1000) ("g", (processed-gathered).count()/1000) ("p", (processed-loaded).count()/1000));
-                         }
-                         if( shutdown() ) break;
-                       }
+                        report();
                     } catch (const database_guard_exception &e) {
                         except_ptr = std::current_exception();
                     }
@@ -1529,6 +1535,8 @@ namespace eosio {
                 pending->_block_status = s;
                 pending->_producer_block_id = producer_block_id;
 
+                authorization.reset_authorization_cache();
+
                 auto &bb = pending->_block_stage.get<building_block>();
                 const auto &pbhs = bb._pending_block_header_state;
 
@@ -1832,7 +1840,12 @@ namespace eosio {
                 }
             }
 
-            void apply_block(const block_state_ptr &bsp, controller::block_status s) {
+            /**
+             * @param prepared_trxs metadata for the packed transactions of bsp, in order, if already built
+             *                      by the caller (replay_pipeline); built here when empty
+             */
+            void apply_block(const block_state_ptr &bsp, controller::block_status s,
+                             std::vector<transaction_metadata_ptr> prepared_trxs = {}) {
                 try {
                     try {
                         const signed_block_ptr &b = bsp->block;
@@ -1843,18 +1856,20 @@ namespace eosio {
                         auto producer_block_id = b->id();
                         start_block(b->timestamp, b->confirmed, new_protocol_feature_activations, s, producer_block_id);
 
-                        std::vector<transaction_metadata_ptr> packed_transactions;
-                        packed_transactions.reserve(b->transactions.size());
-                        for (const auto &receipt : b->transactions) {
-                            if (receipt.trx.contains<packed_transaction>()) {
-                                auto &pt = receipt.trx.get<packed_transaction>();
-                                auto mtrx = std::make_shared<transaction_metadata>(
-                                        std::make_shared<packed_transaction>(pt));
-                                if (!self.skip_auth_check()) {
-                                    transaction_metadata::start_recover_keys(mtrx, thread_pool.get_executor(), chain_id,
-                                                                             microseconds::maximum());
+                        std::vector<transaction_metadata_ptr> packed_transactions = std::move(prepared_trxs);
+                        if (packed_transactions.empty()) {
+                            packed_transactions.reserve(b->transactions.size());
+                            for (const auto &receipt : b->transactions) {
+                                if (receipt.trx.contains<packed_transaction>()) {
+                                    auto &pt = receipt.trx.get<packed_transaction>();
+                                    auto mtrx = std::make_shared<transaction_metadata>(
+                                            std::make_shared<packed_transaction>(pt));
+                                    if (!self.skip_auth_check()) {
+                                        transaction_metadata::start_recover_keys(mtrx, thread_pool.get_executor(),
+                                                                                 chain_id, microseconds::maximum());
+                                    }
+                                    packed_transactions.emplace_back(std::move(mtrx));
                                 }
-                                packed_transactions.emplace_back(std::move(mtrx));
                             }
                         }
 
@@ -1987,7 +2002,8 @@ namespace eosio {
                 } FC_LOG_AND_RETHROW()
             }
 
-            void replay_push_block(const signed_block_ptr &b, controller::block_status s) {
+            void replay_push_block(const signed_block_ptr &b, controller::block_status s,
+                                   std::vector<transaction_metadata_ptr> prepared_trxs = {}) {
                 self.validate_db_available_size();
                 self.validate_reversible_available_size();
 
@@ -2020,7 +2036,7 @@ namespace eosio {
                     emit(self.accepted_block_header, bsp);
 
                     if (s == controller::block_status::irreversible) {
-                        apply_block(bsp, s);
+                        apply_block(bsp, s, std::move(prepared_trxs));
                         head = bsp;
 
                         // On replay, log_irreversible is not called and so no irreversible_block signal is emittted.
@@ -2166,6 +2182,8 @@ namespace eosio {
                         db.modify(permission, [&](auto &po) {
                             po.auth = auth;
                         });
+                        // modified in place to keep last_updated, the authorization cache still has to forget it
+                        authorization.permissions_changed(permission.owner);
                     }
                 };
 
@@ -2872,6 +2890,28 @@ namespace eosio {
             } FC_CAPTURE_AND_RETHROW((block_num))
         }
 
+        std::vector<char> controller::fetch_block_raw_by_number(uint32_t block_num) const {
+            try {
+                return my->blog.read_block_raw_by_num(block_num);
+            } FC_CAPTURE_AND_RETHROW((block_num))
+        }
+
+        std::vector<std::vector<char>>
+        controller::fetch_blocks_raw_by_number(uint32_t first_num, uint32_t last_num, size_t max_bytes) const {
+            try {
+                std::vector<std::vector<char>> blocks;
+                size_t bytes = 0;
+                for (uint32_t num = first_num; num <= last_num && bytes < max_bytes; ++num) {
+                    auto raw = my->blog.read_block_raw_by_num(num);
+                    if (raw.empty()) break;
+                    bytes += raw.size();
+                    blocks.emplace_back(std::move(raw));
+                    if (num == std::numeric_limits<uint32_t>::max()) break;
+                }
+                return blocks;
+            } FC_CAPTURE_AND_RETHROW((first_num)(last_num))
+        }
+
         block_state_ptr controller::fetch_block_state_by_id(block_id_type id) const {
             auto state = my->fork_db.get_block(id);
             return state;
@@ -3101,6 +3141,18 @@ namespace eosio {
             return nullptr;
         }
 
+        bool controller::is_fio_action_registered(const action_name &act) const {
+            return my->is_fio_action_registered(act);
+        }
+
+        flat_set<uint64_t> controller::registered_fio_actions() const {
+            return my->registered_fio_actions();
+        }
+
+        void controller::invalidate_fio_action_cache() {
+            my->fioaction_cache.valid = false;
+        }
+
         wasm_interface &controller::get_wasm_interface() {
             return my->wasmif;
         }
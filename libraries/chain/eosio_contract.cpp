@@ -112,6 +112,7 @@ namespace eosio {
                     a.contractname = create.contract;
                     a.blocktimestamp = context.control.pending_block_time().time_since_epoch().count();
                 });
+                context.control.invalidate_fio_action_cache();
 
 
             } FC_CAPTURE_AND_RETHROW((create))
@@ -154,6 +155,7 @@ namespace eosio {
 
 
                 db.remove(*fioaction_name);
+                context.control.invalidate_fio_action_cache();
 
             } FC_CAPTURE_AND_RETHROW((rem))
         }
@@ -301,6 +303,7 @@ namespace eosio {
                         o.vm_version = act.vmversion;
                     });
                 }
+                context.control.get_wasm_interface().compile_in_background(code_hash, act.vmtype, act.vmversion);
             }
 
             db.modify(account, [&](auto &a) {
@@ -139,6 +139,34 @@ namespace eosio {
                 return satisfied(authority, *cached_perms, 0);
             }
 
+            /**
+             * Like satisfied(), but also reports the provided keys that satisfying the permission used, in the order of
+             * the provided keys. Keys earlier checks used are only reported if this check uses them too.
+             */
+            bool satisfied(const permission_level &permission,
+                           fc::microseconds override_provided_delay,
+                           vector<bool> &keys_used
+            ) {
+                vector<bool> keys_used_before(_used_keys.size(), false);
+                _used_keys.swap(keys_used_before);
+                auto merge_used_keys = fc::make_scoped_exit([&]() {
+                    keys_used = _used_keys;
+                    _used_keys.swap(keys_used_before);
+                    use_keys(keys_used);
+                });
+
+                return satisfied(permission, override_provided_delay);
+            }
+
+            /// Marks provided keys as used, in the order of the provided keys, as satisfying a permission with them would
+            void use_keys(const vector<bool> &keys) {
+                EOS_ASSERT(keys.size() == _used_keys.size(), authorization_exception, "mismatched number of keys");
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    if (keys[i])
+                        _used_keys[i] = true;
+                }
+            }
+
             bool all_keys_used() const { return boost::algorithm::all_of_equal(_used_keys, true); }
 
             flat_set<public_key_type> used_keys() const {
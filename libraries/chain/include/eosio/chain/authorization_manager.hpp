@@ -10,6 +10,7 @@
 
 #include <utility>
 #include <functional>
+#include <memory>
 
 namespace eosio {
     namespace chain {
@@ -28,6 +29,8 @@ namespace eosio {
 
             explicit authorization_manager(controller &c, chainbase::database &d);
 
+            ~authorization_manager();
+
             void add_indices();
 
             void initialize_database();
@@ -122,11 +125,30 @@ namespace eosio {
             ) const;
 
 
+            /**
+             * Transactions of a block are often signed by the same few accounts, so the authorities of permissions and
+             * whether sets of keys satisfy them are cached while a block is built or applied. The controller calls
+             * this whenever it starts a block, which also makes the cache forget the state of blocks that were
+             * aborted or popped.
+             */
+            void reset_authorization_cache();
+
+            /**
+             * Drops what the authorization cache holds about the permissions of an account. Called by the permission
+             * methods above; code that modifies a permission_object directly must call it too.
+             */
+            void permissions_changed(account_name account);
+
             static std::function<void()> _noop_checktime;
 
         private:
+            struct authorization_cache;
+
             const controller &_control;
             chainbase::database &_db;
+            std::unique_ptr<authorization_cache> _cache;
+
+            const authority &cached_authority(const permission_level &level, std::deque<authority> &uncached) const;
 
             void check_updateauth_authorization(const updateauth &update, const vector<permission_level> &auths) const;
 
@@ -36,6 +36,9 @@ namespace eosio {
          *
          * The main file is the only file that needs to persist. The index file can be reconstructed during a
          * linear scan of the main file.
+         *
+         * Reads go through read-only memory maps of both files, so they can run from any thread concurrently
+         * with each other and with append, which still writes through the file streams.
          */
 
         class block_log {
@@ -60,6 +63,11 @@ namespace eosio {
                 return read_block_by_num(block_header::num_from_id(id));
             }
 
+            /**
+             * Return the packed signed_block as stored in the log, or an empty vector if it does not exist.
+             */
+            std::vector<char> read_block_raw_by_num(uint32_t block_num) const;
+
             /**
              * Return offset of block in file, or block_log::npos if it does not exist.
              */
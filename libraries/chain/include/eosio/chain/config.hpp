@@ -26,6 +26,7 @@ namespace eosio {
             const static auto default_state_dir_name = "state";
             const static auto default_history_dir_name   = "history";
             const static auto default_history_index_dir_name = "history_index";
+            const static auto default_wasm_cache_dir_name = "wasm-cache";
             const static auto forkdb_filename = "fork_db.dat";
             const static auto default_state_size = 1 * 1024 * 1024 * 1024ll;
             const static auto default_state_guard_size = 128 * 1024 * 1024ll;
@@ -99,6 +100,8 @@ namespace eosio {
             const static uint32_t default_sig_cpu_bill_pct =
                     50 * percent_1; // billable percentage of signature recovery
             const static uint16_t default_controller_thread_pool_size = 2;
+            const static uint32_t default_replay_pipeline_depth = 1000; ///< blocks read ahead of the one being replayed
+            const static uint16_t default_replay_threads = 2;
 
             const static uint32_t min_net_usage_delta_between_base_and_max_for_trx = 10 * 1024;
 // Should be large enough to allow recovery from badly set blockchain parameters without a hard fork
@@ -81,6 +81,7 @@ namespace eosio {
                 path state_dir = chain::config::default_state_dir_name;
                 path history_dir = chain::config::default_history_dir_name;
                 path history_index_dir = chain::config::default_history_index_dir_name;
+                path wasm_cache_dir; ///< persistent cache of compiled contracts, none if empty
                 uint64_t state_size = chain::config::default_state_size;
                 uint64_t state_guard_size = chain::config::default_state_guard_size;
                 uint64_t history_size = chain::config::default_history_size;
@@ -92,6 +93,8 @@ namespace eosio {
                 uint64_t reversible_guard_size = chain::config::default_reversible_guard_size;
                 uint32_t sig_cpu_bill_pct = chain::config::default_sig_cpu_bill_pct;
                 uint16_t thread_pool_size = chain::config::default_controller_thread_pool_size;
+                uint32_t replay_pipeline_depth = chain::config::default_replay_pipeline_depth;
+                uint16_t replay_threads = chain::config::default_replay_threads;
                 bool read_only = false;
                 bool force_all_checks = false;
                 bool disable_replay_opts = false;
@@ -291,6 +294,20 @@ namespace eosio {
 
             signed_block_ptr fetch_block_by_id(block_id_type id) const;
 
+            /**
+             * Packed signed_block from the block log, or an empty vector if block_num is not irreversible.
+             * Only reads the block log, so it may be called from any thread.
+             */
+            std::vector<char> fetch_block_raw_by_number(uint32_t block_num) const;
+
+            /**
+             * Packed signed_blocks first_num through last_num from the block log. Stops early at the first
+             * block not in the log, or once the blocks read exceed max_bytes; at least one block is returned
+             * if first_num is in the log. Only reads the block log, so it may be called from any thread.
+             */
+            std::vector<std::vector<char>> fetch_blocks_raw_by_number(uint32_t first_num, uint32_t last_num,
+                                                                      size_t max_bytes) const;
+
             block_state_ptr fetch_block_state_by_number(uint32_t block_num) const;
 
             block_state_ptr fetch_block_state_by_id(block_id_type id) const;
@@ -393,6 +410,17 @@ namespace eosio {
 
             const apply_handler *find_apply_handler(account_name contract, scope_name scope, action_name act) const;
 
+            /**
+             * @return true if act is registered in fioaction_index, answered from an in-memory copy of the registry
+             */
+            bool is_fio_action_registered(const action_name &act) const;
+
+            /// copy of the registered action name values, for checks made off the main thread
+            flat_set<uint64_t> registered_fio_actions() const;
+
+            /// called by addaction/remaction after modifying fioaction_index
+            void invalidate_fio_action_cache();
+
             wasm_interface &get_wasm_interface();
 
 
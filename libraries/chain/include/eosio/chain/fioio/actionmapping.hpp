@@ -9,77 +9,118 @@
 
 #pragma once
 
-#include <string>
+#include <eosio/chain/name.hpp>
+
+#include <array>
+#include <cstdint>
 
 namespace fioio {
 
-    static std::string map_to_contract(const std::string &action) {
-
-        // msig actions
-        if (action == "approve" || action == "cancel" || action == "invalidate" ||
-            action == "exec" || action == "propose" || action == "unapprove")
-          return "eosio.msig";
-
-        // fio.address actions
-        if (action == "regaddress" || action == "regdomain" || action == "addaddress" ||
-            action == "remaddress" || action == "remalladdr" ||
-            action == "renewdomain" || action == "renewaddress" ||
-            action == "setdomainpub" || action == "bind2eosio" ||
-            action == "burnexpired" || action == "decrcounter" || action == "xferdomain" || action == "xferaddress" )
-          return "fio.address";
-
-
-
-        // fio.fee actions
-        if (action == "setfeemult" || action == "bundlevote" || action == "setfeevote" ||
-            action == "bytemandfee" || action == "updatefees" || action == "mandatoryfee" ||
-            action == "createfee")
-          return "fio.fee";
-
-
-        // fio.treasury actions
-        if (action == "tpidclaim" || action == "bpclaim" || action == "bppoolupdate" ||
-            action == "fdtnrwdupdat" || action == "bprewdupdate" || action == "startclock" ||
-            action == "updateclock")
-          return "fio.treasury";
-
-        //fio.token actions
-        if (action == "trnsfiopubky" || action == "create" || action == "issue" ||
-            action == "transfer" || action == "mintfio")
-          return "fio.token";
-        //fio.request.obt actions
-        if (action == "recordobt" || action == "rejectfndreq" || action == "cancelfndreq"  || action == "newfundsreq")
-          return "fio.reqobt";
-
-        //fio.tpid actions
-        if (action == "updatebounty" || action == "rewardspaid" || action == "updatetpid")
-          return "fio.tpid";
-
-        // eosio.wrap actions
-        if (action == "execute")
-          return "eosio.wrap";
-
-        //system actions
-        if (action == "newaccount" || action == "onblock" || action == "addlocked" ||
-            action == "regproducer" || action == "unregprod" || action == "regproxy" ||
-            action == "voteproducer" || action == "unregproxy" || action == "voteproxy" ||
-            action == "setabi" || action == "setcode" || action == "updateauth" ||
-            action == "setprods" || action == "setpriv" || action == "init" ||
-            action == "nonce" || action == "burnaction" || action == "canceldelay" ||
-            action == "crautoproxy" || action == "deleteauth" || action == "inhibitunlck" ||
-            action == "linkauth" || action == "onerror" || action == "unlinkauth" ||
-            action == "rmvproducer" || action == "setautoproxy" || action == "setparams" ||
-            action == "unlocktokens" || action == "updtrevision" ||action == "updlocked" ||
-            action == "updatepower" ||
-            action == "updlbpclaim" || action == "resetclaim" || action == "incram" ||
-            action == "addaction" || action == "remaction")
-          return "eosio";
-
-        if (action == "nonce")
-           return "eosio.null";
-
-        return "nomap";
+    namespace detail {
+
+        struct action_contract {
+            uint64_t action;
+            uint64_t contract;
+        };
+
+        template<size_t N>
+        constexpr std::array<action_contract, N> sort_by_action(std::array<action_contract, N> table) {
+            for (size_t i = 1; i < N; ++i) {
+                for (size_t j = i; j > 0 && table[j].action < table[j - 1].action; --j) {
+                    const auto tmp = table[j];
+                    table[j] = table[j - 1];
+                    table[j - 1] = tmp;
+                }
+            }
+            return table;
+        }
+
+        template<size_t N>
+        constexpr bool unique_actions(const std::array<action_contract, N> &table) {
+            for (size_t i = 1; i < N; ++i) {
+                if (table[i].action == table[i - 1].action) return false;
+            }
+            return true;
+        }
+
+        // contract account of every FIO action, sorted by action name value at compile time
+        constexpr auto action_contracts = sort_by_action(std::array<action_contract, 82>{{
+            // msig actions
+            {N(approve), N(eosio.msig)}, {N(cancel), N(eosio.msig)}, {N(invalidate), N(eosio.msig)},
+            {N(exec), N(eosio.msig)}, {N(propose), N(eosio.msig)}, {N(unapprove), N(eosio.msig)},
+
+            // fio.address actions
+            {N(regaddress), N(fio.address)}, {N(regdomain), N(fio.address)}, {N(addaddress), N(fio.address)},
+            {N(remaddress), N(fio.address)}, {N(remalladdr), N(fio.address)}, {N(renewdomain), N(fio.address)},
+            {N(renewaddress), N(fio.address)}, {N(setdomainpub), N(fio.address)}, {N(bind2eosio), N(fio.address)},
+            {N(burnexpired), N(fio.address)}, {N(decrcounter), N(fio.address)}, {N(xferdomain), N(fio.address)},
+            {N(xferaddress), N(fio.address)},
+
+            // fio.fee actions
+            {N(setfeemult), N(fio.fee)}, {N(bundlevote), N(fio.fee)}, {N(setfeevote), N(fio.fee)},
+            {N(bytemandfee), N(fio.fee)}, {N(updatefees), N(fio.fee)}, {N(mandatoryfee), N(fio.fee)},
+            {N(createfee), N(fio.fee)},
+
+            // fio.treasury actions
+            {N(tpidclaim), N(fio.treasury)}, {N(bpclaim), N(fio.treasury)}, {N(bppoolupdate), N(fio.treasury)},
+            {N(fdtnrwdupdat), N(fio.treasury)}, {N(bprewdupdate), N(fio.treasury)},
+            {N(startclock), N(fio.treasury)}, {N(updateclock), N(fio.treasury)},
+
+            // fio.token actions
+            {N(trnsfiopubky), N(fio.token)}, {N(create), N(fio.token)}, {N(issue), N(fio.token)},
+            {N(transfer), N(fio.token)}, {N(mintfio), N(fio.token)},
+
+            // fio.request.obt actions
+            {N(recordobt), N(fio.reqobt)}, {N(rejectfndreq), N(fio.reqobt)}, {N(cancelfndreq), N(fio.reqobt)},
+            {N(newfundsreq), N(fio.reqobt)},
+
+            // fio.tpid actions
+            {N(updatebounty), N(fio.tpid)}, {N(rewardspaid), N(fio.tpid)}, {N(updatetpid), N(fio.tpid)},
+
+            // eosio.wrap actions
+            {N(execute), N(eosio.wrap)},
+
+            // system actions
+            {N(newaccount), N(eosio)}, {N(onblock), N(eosio)}, {N(addlocked), N(eosio)},
+            {N(regproducer), N(eosio)}, {N(unregprod), N(eosio)}, {N(regproxy), N(eosio)},
+            {N(voteproducer), N(eosio)}, {N(unregproxy), N(eosio)}, {N(voteproxy), N(eosio)},
+            {N(setabi), N(eosio)}, {N(setcode), N(eosio)}, {N(updateauth), N(eosio)}, {N(setprods), N(eosio)},
+            {N(setpriv), N(eosio)}, {N(init), N(eosio)}, {N(nonce), N(eosio)}, {N(burnaction), N(eosio)},
+            {N(canceldelay), N(eosio)}, {N(crautoproxy), N(eosio)}, {N(deleteauth), N(eosio)},
+            {N(inhibitunlck), N(eosio)}, {N(linkauth), N(eosio)}, {N(onerror), N(eosio)},
+            {N(unlinkauth), N(eosio)}, {N(rmvproducer), N(eosio)}, {N(setautoproxy), N(eosio)},
+            {N(setparams), N(eosio)}, {N(unlocktokens), N(eosio)}, {N(updtrevision), N(eosio)},
+            {N(updlocked), N(eosio)}, {N(updatepower), N(eosio)}, {N(updlbpclaim), N(eosio)},
+            {N(resetclaim), N(eosio)}, {N(incram), N(eosio)}, {N(addaction), N(eosio)}, {N(remaction), N(eosio)}
+        }});
+
+        static_assert(unique_actions(action_contracts), "an action can only map to one contract");
+
+    } // namespace detail
+
+    constexpr uint64_t nomap = N(nomap);
+
+    /// blocks after this time check actions against the fioaction registry instead of map_to_contract
+    constexpr int32_t HF1_BLOCK_TIME = 1600876800; //Wed Sep 23 16:00:00 UTC 2020
+
+    /**
+     * Contract account that implements action, or nomap. Used to validate actions before the
+     * fioaction registry took over at HF1.
+     */
+    constexpr uint64_t map_to_contract(uint64_t action) {
+        size_t lo = 0, hi = detail::action_contracts.size();
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (detail::action_contracts[mid].action < action) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo < detail::action_contracts.size() && detail::action_contracts[lo].action == action
+               ? detail::action_contracts[lo].contract : nomap;
     }
 
+    static_assert(map_to_contract(N(regaddress)) == N(fio.address), "action table lookup");
 
 }
@@ -90,6 +90,7 @@ namespace fioio {
     constexpr auto ErrorActorIsSystemAccount = ident | httpDataError | 154;   // the specified actor is a FIO system account
     constexpr auto ErrorNoFioActionsFound = ident | httpLocationError | 155;   // no actions found
     constexpr auto ErrorDomainOwner = ident | httpInvalidError | 156;
+    constexpr auto ErrorBatchSizeInvalid = ident | httpDataError | 157;   // Invalid number of items in a batch request
 
     /**
     * Helper funtions for detecting rich error messages and extracting bitfielded values
@@ -0,0 +1,86 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/block_log.hpp>
+#include <eosio/chain/thread_utils.hpp>
+#include <eosio/chain/transaction_metadata.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace eosio {
+    namespace chain {
+
+        /**
+         * Feeds irreversible blocks from the block log to controller replay.
+         *
+         * A reader thread pulls the packed bytes of each block from the log and hands them to a pool of
+         * threads that unpack the signed_block and build the transaction_metadata of its packed
+         * transactions, starting key recovery when requested. The caller takes the prepared blocks in
+         * order with next() and applies them. At most depth blocks are in flight between the reader and
+         * the caller.
+         */
+        class replay_pipeline {
+        public:
+            struct prepared_block {
+                signed_block_ptr block;
+                std::vector<transaction_metadata_ptr> trxs; ///< one per packed_transaction receipt, in order
+            };
+
+            struct stats {
+                uint64_t blocks = 0;
+                uint64_t bytes = 0;
+                fc::microseconds read_time;   ///< reader thread
+                fc::microseconds unpack_time; ///< summed over unpack threads
+                fc::microseconds wait_time;   ///< spent in next() waiting on the earlier stages
+            };
+
+            replay_pipeline(const block_log &blog, uint32_t first_block_num, uint32_t last_block_num,
+                            uint32_t depth, uint16_t threads, const chain_id_type &chain_id, bool recover_keys);
+
+            ~replay_pipeline();
+
+            /**
+             * @return the next block in order, or an empty optional after last_block_num
+             */
+            optional<prepared_block> next();
+
+            stats get_stats() const;
+
+        private:
+            void read_loop(uint32_t first_block_num);
+
+            prepared_block prepare(uint32_t block_num, const std::vector<char> &raw);
+
+            const block_log &blog;
+            const uint32_t last_block_num;
+            const uint32_t depth;
+            const chain_id_type chain_id;
+            const bool recover_keys;
+
+            named_thread_pool unpack_pool;
+
+            std::mutex mtx;
+            std::condition_variable cv;
+            std::deque<std::future<prepared_block>> queue;
+            bool reading = true;
+            bool stopping = false;
+            std::exception_ptr read_error;
+
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<int64_t> read_us{0};
+            std::atomic<int64_t> unpack_us{0};
+            uint64_t blocks = 0;
+            int64_t wait_us = 0;
+
+            std::thread reader;
+        };
+
+    }
+} // eosio::chain
@@ -0,0 +1,93 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+#include <mutex>
+
+namespace eosio {
+    namespace chain {
+
+        /**
+         * Bounded, thread-safe LRU cache of the public keys recovered from transaction signatures.
+         *
+         * Entries are keyed by the digest that was signed and the signature, so a hit always returns the key that
+         * recovering the signature would. A transaction is typically recovered when it arrives from a peer, again when
+         * it is re-applied after a fork switch or an aborted block, and again when the block containing it is applied;
+         * with the cache only the first of those does the elliptic curve math. The cpu time of that recovery is kept
+         * with the key so the transaction is billed the same either way.
+         *
+         * transaction::get_signature_keys goes through the process wide instance returned by shared().
+         */
+        class signature_recovery_cache {
+        public:
+            static constexpr size_t default_capacity = 10000;
+
+            explicit signature_recovery_cache(size_t capacity = default_capacity);
+
+            /// the instance shared by all transaction signature recovery in this process
+            static signature_recovery_cache &shared();
+
+            /// @return the recovered key and the cpu time recovering it took, or an empty optional if not cached
+            optional<std::pair<public_key_type, fc::microseconds>>
+            get(const digest_type &digest, const signature_type &sig);
+
+            void add(const digest_type &digest, const signature_type &sig, const public_key_type &key,
+                     fc::microseconds cpu_usage);
+
+            /// evicts the least recently used entries if the cache holds more than the new capacity
+            void set_capacity(size_t capacity);
+
+            size_t capacity() const;
+
+            size_t size() const;
+
+            void clear();
+
+        private:
+            struct entry {
+                digest_type digest;
+                signature_type sig;
+                public_key_type pub_key;
+                fc::microseconds cpu_usage;
+            };
+
+            struct by_sig;
+
+            typedef boost::multi_index_container<
+                    entry,
+                    boost::multi_index::indexed_by<
+                            boost::multi_index::sequenced<>,
+                            boost::multi_index::hashed_unique<
+                                    boost::multi_index::tag<by_sig>,
+                                    boost::multi_index::composite_key<
+                                            entry,
+                                            boost::multi_index::member<entry, digest_type, &entry::digest>,
+                                            boost::multi_index::member<entry, signature_type, &entry::sig>
+                                    >,
+                                    boost::multi_index::composite_key_hash<
+                                            std::hash<digest_type>,
+                                            boost::hash<signature_type>
+                                    >
+                            >
+                    >
+            > entry_index_type;
+
+            void evict();
+
+            mutable std::mutex _mtx;
+            size_t _capacity;
+            entry_index_type _entries; ///< least recently used first
+        };
+
+    }
+} // eosio::chain
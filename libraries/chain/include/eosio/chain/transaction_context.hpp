@@ -42,6 +42,11 @@ namespace eosio {
 
             void init_for_deferred_trx(fc::time_point published);
 
+            /// the net usage an input transaction is billed before any of its actions execute
+            static uint64_t initial_input_trx_net_usage(const chain_config &cfg, const transaction &trx,
+                                                        uint64_t packed_trx_unprunable_size,
+                                                        uint64_t packed_trx_prunable_size);
+
             void exec();
 
             void finalize();
@@ -67,6 +67,10 @@ namespace eosio {
             start_recover_keys(const transaction_metadata_ptr &mtrx, boost::asio::io_context &thread_pool,
                                const chain_id_type &chain_id, fc::microseconds time_limit);
 
+            // recovers on the calling thread; mtrx must not be in use on another thread
+            static void recover_keys_now(const transaction_metadata_ptr &mtrx, const chain_id_type &chain_id,
+                                         fc::microseconds time_limit);
+
             // start_recover_keys must be called first
             recovery_keys_type recover_keys(const chain_id_type &chain_id);
         };
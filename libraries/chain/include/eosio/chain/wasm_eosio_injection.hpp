@@ -874,6 +874,10 @@ namespace eosio {
                 using standard_module_injectors = module_injectors<max_memory_injection_visitor>;
 
             public:
+                // identifies the code inject() produces; bump it when that changes so compiled code cached for the old
+                // injection is discarded
+                static constexpr uint32_t version = 1;
+
                 wasm_binary_injection(IR::Module &mod) : _module(&mod) {
                     _module_injectors.init();
                     // initialize static fields of injectors
@@ -83,7 +83,11 @@ namespace eosio {
                 wabt
             };
 
-            wasm_interface(vm_type vm, const chainbase::database &db);
+            /**
+             * @param cache_dir directory of the persistent cache of compiled contracts, used by the wavm runtime;
+             * no cache if empty
+             */
+            wasm_interface(vm_type vm, const chainbase::database &db, const fc::path &cache_dir = fc::path());
 
             ~wasm_interface();
 
@@ -101,6 +105,9 @@ namespace eosio {
             //indicate the current LIB. evicts old cache entries
             void current_lib(const uint32_t lib);
 
+            //starts compiling a code_object on a background thread, so that it's ready by the time it's applied
+            void compile_in_background(const digest_type &code_hash, const uint8_t &vm_type, const uint8_t &vm_version);
+
             //Calls apply or error on a given code
             void apply(const digest_type &code_hash, const uint8_t &vm_type, const uint8_t &vm_version,
                        apply_context &context);
@@ -8,8 +8,13 @@
 #include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <future>
+#include <map>
+#include <tuple>
+
 #include "IR/Module.h"
 #include "Runtime/Intrinsics.h"
 #include "Platform/Platform.h"
@@ -34,13 +39,20 @@ namespace eosio {
                 uint8_t vm_type = 0;
                 uint8_t vm_version = 0;
             };
+            /// what the compile thread hands over to the main thread to instantiate
+            struct compiled_code {
+                std::vector<U8> code;
+                std::vector<uint8_t> initial_memory;
+                std::vector<uint8_t> object_code;
+            };
             struct by_hash;
             struct by_first_block_num;
             struct by_last_block_num;
 
-            wasm_interface_impl(wasm_interface::vm_type vm, const chainbase::database &d) : db(d) {
+            wasm_interface_impl(wasm_interface::vm_type vm, const chainbase::database &d, const fc::path &cache_dir)
+                    : db(d), compile_pool("wasm", 1) {
                 if (vm == wasm_interface::vm_type::wavm)
-                    runtime_interface = std::make_unique<webassembly::wavm::wavm_runtime>();
+                    runtime_interface = std::make_unique<webassembly::wavm::wavm_runtime>(cache_dir);
                 else if (vm == wasm_interface::vm_type::wabt)
                     runtime_interface = std::make_unique<webassembly::wabt_runtime::wabt_runtime>();
                 else
@@ -48,6 +60,8 @@ namespace eosio {
             }
 
             ~wasm_interface_impl() {
+                compile_pool.stop();
+                pending_compiles.clear();
                 if (is_shutting_down)
                     for (wasm_cache_index::iterator it = wasm_instantiation_cache.begin();
                          it != wasm_instantiation_cache.end(); ++it)
@@ -87,6 +101,7 @@ namespace eosio {
             }
 
             void current_lib(uint32_t lib) {
+                collect_compiled();
                 //anything last used before or on the LIB can be evicted
                 wasm_instantiation_cache.get<by_last_block_num>().erase(
                         wasm_instantiation_cache.get<by_last_block_num>().begin(),
@@ -96,6 +111,14 @@ namespace eosio {
             const std::unique_ptr<wasm_instantiated_module_interface> &
             get_instantiated_module(const digest_type &code_hash, const uint8_t &vm_type,
                                     const uint8_t &vm_version, transaction_context &trx_context) {
+                if (!pending_compiles.empty()) {
+                    // instantiating what finished compiling isn't billed to the transaction, as when it's waited for
+                    auto timer_pause = fc::make_scoped_exit([&]() {
+                        trx_context.resume_billing_timer();
+                    });
+                    trx_context.pause_billing_timer();
+                    collect_compiled();
+                }
                 wasm_cache_index::iterator it = wasm_instantiation_cache.find(
                         boost::make_tuple(code_hash, vm_type, vm_version));
                 const code_object *codeobject = nullptr;
@@ -121,40 +144,137 @@ namespace eosio {
                         trx_context.resume_billing_timer();
                     });
                     trx_context.pause_billing_timer();
-                    IR::Module module;
-                    try {
-                        Serialization::MemoryInputStream stream((const U8 *) codeobject->code.data(),
-                                                                codeobject->code.size());
-                        WASM::serialize(stream, module);
-                        module.userSections.clear();
-                    } catch (const Serialization::FatalSerializationException &e) {
-                        EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-                    } catch (const IR::ValidationException &e) {
-                        EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-                    }
 
-                    wasm_injections::wasm_binary_injection injector(module);
-                    injector.inject();
-
-                    std::vector<U8> bytes;
-                    try {
-                        Serialization::ArrayOutputStream outstream;
-                        WASM::serialize(outstream, module);
-                        bytes = outstream.getBytes();
-                    } catch (const Serialization::FatalSerializationException &e) {
-                        EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-                    } catch (const IR::ValidationException &e) {
-                        EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-                    }
+                    // wait for the background compile, or queue one if the code wasn't compiled ahead of time; it
+                    // still runs on the compile thread, the only one allowed to touch the injection
+                    start_compile(*codeobject);
+                    auto pending = pending_compiles.find(std::make_tuple(code_hash, vm_type, vm_version));
+                    auto compiled = std::move(pending->second);
+                    pending_compiles.erase(pending);
+                    auto module = instantiate(compiled.get(), code_hash, vm_type, vm_version);
 
                     wasm_instantiation_cache.modify(it, [&](auto &c) {
-                        c.module = runtime_interface->instantiate_module((const char *) bytes.data(), bytes.size(),
-                                                                         parse_initial_memory(module));
+                        c.module = std::move(module);
                     });
                 }
                 return it->module;
             }
 
+            void compile_in_background(const digest_type &code_hash, const uint8_t &vm_type,
+                                       const uint8_t &vm_version) {
+                const code_object *codeobject = db.find<code_object, by_code_hash>(
+                        boost::make_tuple(code_hash, vm_type, vm_version));
+                if (codeobject)
+                    start_compile(*codeobject);
+            }
+
+            /**
+             * Queue code for compilation on the compile thread, unless it's compiled or queued already. The code is
+             * copied, as chainbase may only be read on the main thread.
+             */
+            void start_compile(const code_object &codeobject) {
+                auto key = std::make_tuple(codeobject.code_hash, codeobject.vm_type, codeobject.vm_version);
+                if (pending_compiles.count(key))
+                    return;
+                wasm_cache_index::iterator it = wasm_instantiation_cache.find(
+                        boost::make_tuple(codeobject.code_hash, codeobject.vm_type, codeobject.vm_version));
+                if (it != wasm_instantiation_cache.end() && it->module)
+                    return;
+
+                pending_compiles.emplace(key, async_thread_pool(compile_pool.get_executor(),
+                        [this, code = bytes(codeobject.code.begin(), codeobject.code.end()),
+                         code_hash = codeobject.code_hash, vm_type = codeobject.vm_type,
+                         vm_version = codeobject.vm_version]() {
+                            return compile(code, code_hash, vm_type, vm_version);
+                        }));
+            }
+
+            /**
+             * Instantiate code compiled in the background and move the modules into the instantiation cache. Code
+             * whose code_object is gone, as happens when the setcode that created it was rolled back, or whose
+             * compilation failed is dropped; applying that code later compiles it again and raises the error there.
+             */
+            void collect_compiled() {
+                for (auto itr = pending_compiles.begin(); itr != pending_compiles.end();) {
+                    if (itr->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                        ++itr;
+                        continue;
+                    }
+                    const auto &[code_hash, vm_type, vm_version] = itr->first;
+                    const code_object *codeobject = db.find<code_object, by_code_hash>(
+                            boost::make_tuple(code_hash, vm_type, vm_version));
+                    wasm_cache_index::iterator it = wasm_instantiation_cache.find(
+                            boost::make_tuple(code_hash, vm_type, vm_version));
+                    std::unique_ptr<wasm_instantiated_module_interface> module;
+                    if (codeobject && (it == wasm_instantiation_cache.end() || !it->module)) {
+                        try {
+                            module = instantiate(itr->second.get(), code_hash, vm_type, vm_version);
+                        } catch (...) {
+                        }
+                    }
+                    if (module) {
+                        if (it == wasm_instantiation_cache.end()) {
+                            wasm_instantiation_cache.emplace(wasm_interface_impl::wasm_cache_entry{
+                                    .code_hash = code_hash,
+                                    .first_block_num_used = codeobject->first_block_used,
+                                    .last_block_num_used = UINT32_MAX,
+                                    .module = std::move(module),
+                                    .vm_type = vm_type,
+                                    .vm_version = vm_version
+                            });
+                        } else {
+                            wasm_instantiation_cache.modify(it, [&](auto &c) {
+                                c.module = std::move(module);
+                            });
+                        }
+                    }
+                    itr = pending_compiles.erase(itr);
+                }
+            }
+
+            /// runs on the compile thread
+            compiled_code compile(const bytes &code, const digest_type &code_hash, uint8_t vm_type,
+                                  uint8_t vm_version) {
+                IR::Module module;
+                try {
+                    Serialization::MemoryInputStream stream((const U8 *) code.data(), code.size());
+                    WASM::serialize(stream, module);
+                    module.userSections.clear();
+                } catch (const Serialization::FatalSerializationException &e) {
+                    EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+                } catch (const IR::ValidationException &e) {
+                    EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+                }
+
+                wasm_injections::wasm_binary_injection injector(module);
+                injector.inject();
+
+                compiled_code compiled;
+                try {
+                    Serialization::ArrayOutputStream outstream;
+                    WASM::serialize(outstream, module);
+                    compiled.code = outstream.getBytes();
+                } catch (const Serialization::FatalSerializationException &e) {
+                    EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+                } catch (const IR::ValidationException &e) {
+                    EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+                }
+                compiled.initial_memory = parse_initial_memory(module);
+                compiled.object_code = runtime_interface->compile_module((const char *) compiled.code.data(),
+                                                                         compiled.code.size(), code_hash, vm_type,
+                                                                         vm_version);
+                return compiled;
+            }
+
+            /// runs on the main thread: creating the tables, memory and other runtime objects of a module isn't safe
+            /// while another module executes
+            std::unique_ptr<wasm_instantiated_module_interface>
+            instantiate(compiled_code &&compiled, const digest_type &code_hash, uint8_t vm_type, uint8_t vm_version) {
+                return runtime_interface->instantiate_module((const char *) compiled.code.data(), compiled.code.size(),
+                                                             std::move(compiled.initial_memory), code_hash, vm_type,
+                                                             vm_version, std::move(compiled.object_code));
+            }
+
             bool is_shutting_down = false;
             std::unique_ptr<wasm_runtime_interface> runtime_interface;
 
@@ -175,6 +295,10 @@ namespace eosio {
             wasm_cache_index wasm_instantiation_cache;
 
             const chainbase::database &db;
+
+            // compiles code, one module at a time as the injection isn't thread safe; only the main thread instantiates
+            named_thread_pool compile_pool;
+            std::map<std::tuple<digest_type, uint8_t, uint8_t>, std::future<compiled_code>> pending_compiles;
         };
 
 #define _REGISTER_INTRINSIC_EXPLICIT(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
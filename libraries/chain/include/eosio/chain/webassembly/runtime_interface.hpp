@@ -1,5 +1,7 @@
 #pragma once
 
+#include <eosio/chain/types.hpp>
+
 #include <vector>
 #include <memory>
 
@@ -17,8 +19,17 @@ namespace eosio {
 
         class wasm_runtime_interface {
         public:
+            //generates whatever instantiate_module can reuse to skip compiling the code. Unlike the rest of the
+            // interface it may be called from another thread than the one instantiating and running modules
+            virtual std::vector<uint8_t>
+            compile_module(const char *code_bytes, size_t code_size, const digest_type &code_hash,
+                           const uint8_t &vm_type, const uint8_t &vm_version) { return {}; }
+
+            //object_code is what compile_module returned for the code, or empty
             virtual std::unique_ptr<wasm_instantiated_module_interface>
-            instantiate_module(const char *code_bytes, size_t code_size, std::vector<uint8_t> initial_memory) = 0;
+            instantiate_module(const char *code_bytes, size_t code_size, std::vector<uint8_t> initial_memory,
+                               const digest_type &code_hash, const uint8_t &vm_type, const uint8_t &vm_version,
+                               std::vector<uint8_t> object_code = {}) = 0;
 
             //immediately exit the currently running wasm_instantiated_module_interface. Yep, this assumes only one can possibly run at a time.
             virtual void immediately_exit_currently_running_module() = 0;
@@ -58,7 +58,9 @@ namespace eosio {
 
                     std::unique_ptr<wasm_instantiated_module_interface>
                     instantiate_module(const char *code_bytes, size_t code_size,
-                                       std::vector<uint8_t> initial_memory) override;
+                                       std::vector<uint8_t> initial_memory, const digest_type &code_hash,
+                                       const uint8_t &vm_type, const uint8_t &vm_version,
+                                       std::vector<uint8_t> object_code) override;
 
                     void immediately_exit_currently_running_module() override;
 
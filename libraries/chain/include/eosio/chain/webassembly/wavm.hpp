@@ -19,17 +19,31 @@ namespace eosio {
                 using namespace fc;
                 using namespace eosio::chain::webassembly::common;
 
+                class object_cache;
+
                 class wavm_runtime : public eosio::chain::wasm_runtime_interface {
                 public:
-                    wavm_runtime();
+                    /**
+                     * @param object_cache_dir directory of the persistent cache of compiled contracts, no cache if empty
+                     */
+                    explicit wavm_runtime(const fc::path &object_cache_dir = fc::path());
 
                     ~wavm_runtime();
 
+                    std::vector<uint8_t>
+                    compile_module(const char *code_bytes, size_t code_size, const digest_type &code_hash,
+                                   const uint8_t &vm_type, const uint8_t &vm_version) override;
+
                     std::unique_ptr<wasm_instantiated_module_interface>
                     instantiate_module(const char *code_bytes, size_t code_size,
-                                       std::vector<uint8_t> initial_memory) override;
+                                       std::vector<uint8_t> initial_memory, const digest_type &code_hash,
+                                       const uint8_t &vm_type, const uint8_t &vm_version,
+                                       std::vector<uint8_t> object_code) override;
 
                     void immediately_exit_currently_running_module() override;
+
+                private:
+                    std::unique_ptr<object_cache> cache;
                 };
 
 //This is a temporary hack for the single threaded implementation
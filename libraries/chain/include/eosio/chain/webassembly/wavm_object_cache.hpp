@@ -0,0 +1,68 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <mutex>
+#include <set>
+
+namespace eosio {
+    namespace chain {
+        namespace webassembly {
+            namespace wavm {
+
+                /**
+                 * Persistent cache of the object code WAVM compiles contracts to, so that a restarted node loads the
+                 * machine code of known contracts instead of running them through LLVM again.
+                 *
+                 * Entries live in a subdirectory per format version, one file per (code hash, vm type, vm version).
+                 * A file starts with a header recording its key, the version of the wasm injection and of the runtime
+                 * build that produced the code, and a hash of the code. On startup entries of other versions, and files
+                 * that aren't entries, are removed; the hash is checked whenever an entry is read.
+                 *
+                 * get and put may be called from several threads.
+                 */
+                class object_cache {
+                public:
+                    static constexpr uint32_t format_version = 1;
+
+                    explicit object_cache(const fc::path &dir);
+
+                    /// @return the object code of the contract, or an empty optional if it isn't in the cache
+                    optional<std::vector<uint8_t>> get(const digest_type &code_hash, uint8_t vm_type,
+                                                       uint8_t vm_version);
+
+                    void put(const digest_type &code_hash, uint8_t vm_type, uint8_t vm_version,
+                             const std::vector<uint8_t> &object_code);
+
+                    struct header {
+                        uint32_t    magic = 0;
+                        uint32_t    injection_version = 0;
+                        fc::sha256  runtime_version;
+                        digest_type code_hash;
+                        uint8_t     vm_type = 0;
+                        uint8_t     vm_version = 0;
+                        uint64_t    object_size = 0;
+                        fc::sha256  object_hash;
+                    };
+
+                private:
+                    fc::path entry_file(const digest_type &code_hash, uint8_t vm_type, uint8_t vm_version) const;
+
+                    bool valid_header(const header &h, const fc::path &file) const;
+
+                    void remove(const fc::path &file);
+
+                    const fc::path dir;
+                    const fc::sha256 runtime_version;
+
+                    std::mutex mtx;
+                    std::set<fc::path> entries;
+                };
+
+            }
+        }
+    }
+} // eosio::chain::webassembly::wavm
+
+FC_REFLECT(eosio::chain::webassembly::wavm::object_cache::header,
+           (magic)(injection_version)(runtime_version)(code_hash)(vm_type)(vm_version)(object_size)(object_hash))
@@ -0,0 +1,134 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/chain/replay_pipeline.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger_config.hpp>
+
+namespace eosio {
+    namespace chain {
+
+        replay_pipeline::replay_pipeline(const block_log &blog, uint32_t first_block_num, uint32_t last_block_num,
+                                         uint32_t depth, uint16_t threads, const chain_id_type &chain_id,
+                                         bool recover_keys)
+                : blog(blog), last_block_num(last_block_num), depth(std::max<uint32_t>(depth, 1)),
+                  chain_id(chain_id), recover_keys(recover_keys),
+                  unpack_pool("replay", std::max<uint16_t>(threads, 1)) {
+            reader = std::thread([this, first_block_num]() {
+                fc::set_os_thread_name("replay-read");
+                read_loop(first_block_num);
+            });
+        }
+
+        replay_pipeline::~replay_pipeline() {
+            {
+                std::lock_guard<std::mutex> g(mtx);
+                stopping = true;
+            }
+            cv.notify_all();
+            reader.join();
+            unpack_pool.stop();
+        }
+
+        void replay_pipeline::read_loop(uint32_t first_block_num) {
+            try {
+                for (uint32_t block_num = first_block_num; block_num <= last_block_num; ++block_num) {
+                    {
+                        std::unique_lock<std::mutex> l(mtx);
+                        cv.wait(l, [&]() { return stopping || queue.size() < depth; });
+                        if (stopping) break;
+                    }
+
+                    auto start = fc::time_point::now();
+                    auto raw = blog.read_block_raw_by_num(block_num);
+                    read_us += (fc::time_point::now() - start).count();
+                    if (raw.empty()) break;
+                    bytes += raw.size();
+
+                    auto prepared = async_thread_pool(unpack_pool.get_executor(),
+                                                      [this, block_num, raw{std::move(raw)}]() {
+                                                          return prepare(block_num, raw);
+                                                      });
+                    {
+                        std::lock_guard<std::mutex> g(mtx);
+                        queue.emplace_back(std::move(prepared));
+                    }
+                    cv.notify_all();
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> g(mtx);
+                read_error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> g(mtx);
+                reading = false;
+            }
+            cv.notify_all();
+        }
+
+        replay_pipeline::prepared_block replay_pipeline::prepare(uint32_t block_num, const std::vector<char> &raw) {
+            auto start = fc::time_point::now();
+
+            prepared_block result;
+            result.block = std::make_shared<signed_block>();
+            fc::datastream<const char *> ds(raw.data(), raw.size());
+            fc::raw::unpack(ds, *result.block);
+            EOS_ASSERT(result.block->block_num() == block_num, block_log_exception,
+                       "Wrong block was read from block log.",
+                       ("returned", result.block->block_num())("expected", block_num));
+
+            result.trxs.reserve(result.block->transactions.size());
+            for (const auto &receipt : result.block->transactions) {
+                if (receipt.trx.contains<packed_transaction>()) {
+                    auto mtrx = std::make_shared<transaction_metadata>(
+                            std::make_shared<packed_transaction>(receipt.trx.get<packed_transaction>()));
+                    if (recover_keys) {
+                        transaction_metadata::start_recover_keys(mtrx, unpack_pool.get_executor(), chain_id,
+                                                                 fc::microseconds::maximum());
+                    }
+                    result.trxs.emplace_back(std::move(mtrx));
+                }
+            }
+
+            unpack_us += (fc::time_point::now() - start).count();
+            return result;
+        }
+
+        optional<replay_pipeline::prepared_block> replay_pipeline::next() {
+            auto start = fc::time_point::now();
+
+            std::future<prepared_block> prepared;
+            {
+                std::unique_lock<std::mutex> l(mtx);
+                cv.wait(l, [&]() { return !queue.empty() || !reading; });
+                if (queue.empty()) {
+                    if (read_error) std::rethrow_exception(read_error);
+                    return {};
+                }
+                prepared = std::move(queue.front());
+                queue.pop_front();
+            }
+            cv.notify_all();
+
+            auto result = prepared.get();
+            wait_us += (fc::time_point::now() - start).count();
+            ++blocks;
+            return result;
+        }
+
+        replay_pipeline::stats replay_pipeline::get_stats() const {
+            stats s;
+            s.blocks = blocks;
+            s.bytes = bytes;
+            s.read_time = fc::microseconds(read_us);
+            s.unpack_time = fc::microseconds(unpack_us);
+            s.wait_time = fc::microseconds(wait_us);
+            return s;
+        }
+
+    }
+} // eosio::chain
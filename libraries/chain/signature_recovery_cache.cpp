@@ -0,0 +1,70 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/chain/signature_recovery_cache.hpp>
+
+namespace eosio {
+    namespace chain {
+
+        signature_recovery_cache::signature_recovery_cache(size_t capacity)
+                : _capacity(capacity) {}
+
+        signature_recovery_cache &signature_recovery_cache::shared() {
+            static signature_recovery_cache cache;
+            return cache;
+        }
+
+        optional<std::pair<public_key_type, fc::microseconds>>
+        signature_recovery_cache::get(const digest_type &digest, const signature_type &sig) {
+            std::lock_guard<std::mutex> g(_mtx);
+            auto &by_key = _entries.get<by_sig>();
+            auto itr = by_key.find(boost::make_tuple(digest, sig));
+            if (itr == by_key.end())
+                return optional<std::pair<public_key_type, fc::microseconds>>();
+
+            _entries.relocate(_entries.end(), _entries.project<0>(itr));
+            return std::make_pair(itr->pub_key, itr->cpu_usage);
+        }
+
+        void signature_recovery_cache::add(const digest_type &digest, const signature_type &sig,
+                                           const public_key_type &key, fc::microseconds cpu_usage) {
+            std::lock_guard<std::mutex> g(_mtx);
+            if (_capacity == 0)
+                return;
+
+            // another thread may have recovered the same signature meanwhile, then only its use is recorded
+            auto res = _entries.push_back(entry{digest, sig, key, cpu_usage});
+            if (!res.second)
+                _entries.relocate(_entries.end(), res.first);
+            evict();
+        }
+
+        void signature_recovery_cache::set_capacity(size_t capacity) {
+            std::lock_guard<std::mutex> g(_mtx);
+            _capacity = capacity;
+            evict();
+        }
+
+        size_t signature_recovery_cache::capacity() const {
+            std::lock_guard<std::mutex> g(_mtx);
+            return _capacity;
+        }
+
+        size_t signature_recovery_cache::size() const {
+            std::lock_guard<std::mutex> g(_mtx);
+            return _entries.size();
+        }
+
+        void signature_recovery_cache::clear() {
+            std::lock_guard<std::mutex> g(_mtx);
+            _entries.clear();
+        }
+
+        void signature_recovery_cache::evict() {
+            while (_entries.size() > _capacity)
+                _entries.pop_front();
+        }
+
+    }
+} // eosio::chain
@@ -309,15 +309,9 @@ namespace eosio {
             init(initial_net_usage);
         }
 
-        void transaction_context::init_for_input_trx(uint64_t packed_trx_unprunable_size,
-                                                     uint64_t packed_trx_prunable_size,
-                                                     bool skip_recording) {
-            if (trx.transaction_extensions.size() > 0) {
-                disallow_transaction_extensions("no transaction extensions supported yet for input transactions");
-            }
-
-            const auto &cfg = control.get_global_properties().configuration;
-
+        uint64_t transaction_context::initial_input_trx_net_usage(const chain_config &cfg, const transaction &trx,
+                                                                  uint64_t packed_trx_unprunable_size,
+                                                                  uint64_t packed_trx_prunable_size) {
             uint64_t discounted_size_for_pruned_data = packed_trx_prunable_size;
             if (cfg.context_free_discount_net_usage_den > 0
                 && cfg.context_free_discount_net_usage_num < cfg.context_free_discount_net_usage_den) {
@@ -330,7 +324,6 @@ namespace eosio {
             uint64_t initial_net_usage = static_cast<uint64_t>(cfg.base_per_transaction_net_usage)
                                          + packed_trx_unprunable_size + discounted_size_for_pruned_data;
 
-
             if (trx.delay_sec.value > 0) {
                 // If delayed, also charge ahead of time for the additional net usage needed to retire the delayed transaction
                 // whether that be by successfully executing, soft failure, hard failure, or expiration.
@@ -338,6 +331,20 @@ namespace eosio {
                                      + static_cast<uint64_t>(config::transaction_id_net_usage);
             }
 
+            return initial_net_usage;
+        }
+
+        void transaction_context::init_for_input_trx(uint64_t packed_trx_unprunable_size,
+                                                     uint64_t packed_trx_prunable_size,
+                                                     bool skip_recording) {
+            if (trx.transaction_extensions.size() > 0) {
+                disallow_transaction_extensions("no transaction extensions supported yet for input transactions");
+            }
+
+            uint64_t initial_net_usage = initial_input_trx_net_usage(control.get_global_properties().configuration,
+                                                                     trx, packed_trx_unprunable_size,
+                                                                     packed_trx_prunable_size);
+
             published = control.pending_block_time();
             is_input = true;
             if (!control.skip_trx_checks()) {
@@ -52,6 +52,23 @@ namespace eosio {
             return mtrx->signing_keys_future;
         }
 
+        void transaction_metadata::recover_keys_now(const transaction_metadata_ptr &mtrx,
+                                                    const chain_id_type &chain_id, fc::microseconds time_limit) {
+            if (mtrx->signing_keys_future.valid() &&
+                std::get<0>(mtrx->signing_keys_future.get()) == chain_id) // already recovered
+                return;
+
+            fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
+                                      fc::time_point::maximum() : fc::time_point::now() + time_limit;
+            flat_set<public_key_type> recovered_pub_keys;
+            const signed_transaction &trn = mtrx->packed_trx->get_signed_transaction();
+            fc::microseconds cpu_usage = trn.get_signature_keys(chain_id, deadline, recovered_pub_keys);
+
+            std::promise<signing_keys_future_value_type> p;
+            p.set_value(std::make_tuple(chain_id, cpu_usage, std::move(recovered_pub_keys)));
+            mtrx->signing_keys_future = p.get_future().share();
+        }
+
 
     }
 } // eosio::chain
@@ -30,7 +30,8 @@ namespace eosio {
         using namespace webassembly;
         using namespace webassembly::common;
 
-        wasm_interface::wasm_interface(vm_type vm, const chainbase::database &d) : my(new wasm_interface_impl(vm, d)) {}
+        wasm_interface::wasm_interface(vm_type vm, const chainbase::database &d, const fc::path &cache_dir)
+                : my(new wasm_interface_impl(vm, d, cache_dir)) {}
 
         wasm_interface::~wasm_interface() {}
 
@@ -71,6 +72,11 @@ namespace eosio {
             my->current_lib(lib);
         }
 
+        void wasm_interface::compile_in_background(const digest_type &code_hash, const uint8_t &vm_type,
+                                                   const uint8_t &vm_version) {
+            my->compile_in_background(code_hash, vm_type, vm_version);
+        }
+
         void wasm_interface::apply(const digest_type &code_hash, const uint8_t &vm_type, const uint8_t &vm_version,
                                    apply_context &context) {
             my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
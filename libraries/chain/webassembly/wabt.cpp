@@ -80,7 +80,8 @@ namespace eosio {
 
                 std::unique_ptr<wasm_instantiated_module_interface>
                 wabt_runtime::instantiate_module(const char *code_bytes, size_t code_size,
-                                                 std::vector<uint8_t> initial_memory) {
+                                                 std::vector<uint8_t> initial_memory, const digest_type &,
+                                                 const uint8_t &, const uint8_t &, std::vector<uint8_t>) {
                     std::unique_ptr<interp::Environment> env = std::make_unique<interp::Environment>();
                     for (auto it = intrinsic_registrator::get_map().begin();
                          it != intrinsic_registrator::get_map().end(); ++it) {
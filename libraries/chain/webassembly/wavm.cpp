@@ -1,4 +1,5 @@
 #include <eosio/chain/webassembly/wavm.hpp>
+#include <eosio/chain/webassembly/wavm_object_cache.hpp>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
 #include <eosio/chain/apply_context.hpp>
@@ -68,11 +69,19 @@ namespace eosio {
                         //The memory instance is reused across all wavm_instantiated_modules, but for wasm instances
                         // that didn't declare "memory", getDefaultMemory() won't see it. It would also be possible
                         // to say something like if(module->memories.size()) here I believe
-                        if (getDefaultMemory(_instance))
+                        if (getDefaultMemory(_instance)) {
                             _initial_memory_config = module->memories.defs.at(0).type;
+                            //with a snapshot of the initial memory, resetting it between actions only costs as much as
+                            // the pages the previous action wrote to; without one the whole image is copied each time
+                            _memory_snapshot = createMemorySnapshot(_initial_memory_config, _initial_memory);
+                            if (_memory_snapshot)
+                                std::vector<uint8_t>().swap(_initial_memory);
+                        }
                     }
 
                     ~wavm_instantiated_module() {
+                        if (_memory_snapshot)
+                            destroyMemorySnapshot(_memory_snapshot);
                         detail::the_wavm_live_modules.remove_live_module(_module_ref);
                     }
 
@@ -96,7 +105,11 @@ namespace eosio {
                             //The memory instance is reused across all wavm_instantiated_modules, but for wasm instances
                             // that didn't declare "memory", getDefaultMemory() won't see it
                             MemoryInstance *default_mem = getDefaultMemory(_instance);
-                            if (default_mem) {
+                            if (_memory_snapshot) {
+                                //maps the module's initial memory copy-on-write over the sandbox'ed memory, dropping
+                                // whatever the previous action wrote
+                                restoreMemorySnapshot(default_mem, _memory_snapshot);
+                            } else if (default_mem) {
                                 //reset memory resizes the sandbox'ed memory to the module's init memory size and then
                                 // (effectively) memzeros it all
                                 resetMemory(default_mem, _initial_memory_config);
@@ -127,18 +140,19 @@ namespace eosio {
                     ModuleInstance *_instance;
                     detail::live_module_ref _module_ref;
                     MemoryType _initial_memory_config;
+                    MemorySnapshot *_memory_snapshot = nullptr;
                 };
 
-                wavm_runtime::wavm_runtime() {
+                wavm_runtime::wavm_runtime(const fc::path &object_cache_dir) {
                     static detail::wavm_runtime_initializer the_wavm_runtime_initializer;
+                    if (!object_cache_dir.empty())
+                        cache = std::make_unique<object_cache>(object_cache_dir);
                 }
 
                 wavm_runtime::~wavm_runtime() {
                 }
 
-                std::unique_ptr<wasm_instantiated_module_interface>
-                wavm_runtime::instantiate_module(const char *code_bytes, size_t code_size,
-                                                 std::vector<uint8_t> initial_memory) {
+                static std::unique_ptr<Module> parse_module(const char *code_bytes, size_t code_size) {
                     std::unique_ptr<Module> module = std::make_unique<Module>();
                     try {
                         Serialization::MemoryInputStream stream((const U8 *) code_bytes, code_size);
@@ -148,11 +162,45 @@ namespace eosio {
                     } catch (const IR::ValidationException &e) {
                         EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
                     }
+                    return module;
+                }
+
+                std::vector<uint8_t>
+                wavm_runtime::compile_module(const char *code_bytes, size_t code_size, const digest_type &code_hash,
+                                             const uint8_t &vm_type, const uint8_t &vm_version) {
+                    if (cache) {
+                        if (auto cached = cache->get(code_hash, vm_type, vm_version))
+                            return std::move(*cached);
+                    }
+
+                    std::vector<U8> object_code;
+                    compileModule(*parse_module(code_bytes, code_size), object_code);
+                    if (cache)
+                        cache->put(code_hash, vm_type, vm_version, object_code);
+                    return object_code;
+                }
+
+                std::unique_ptr<wasm_instantiated_module_interface>
+                wavm_runtime::instantiate_module(const char *code_bytes, size_t code_size,
+                                                 std::vector<uint8_t> initial_memory, const digest_type &code_hash,
+                                                 const uint8_t &vm_type, const uint8_t &vm_version,
+                                                 std::vector<uint8_t> object_code) {
+                    std::unique_ptr<Module> module = parse_module(code_bytes, code_size);
 
                     eosio::chain::webassembly::common::root_resolver resolver;
                     LinkResult link_result = linkModule(*module, resolver);
-                    ModuleInstance *instance = instantiateModule(*module, std::move(link_result.resolvedImports));
+
+                    if (cache && object_code.empty()) {
+                        if (auto cached = cache->get(code_hash, vm_type, vm_version))
+                            object_code = std::move(*cached);
+                    }
+                    bool compiled = false;
+                    ModuleInstance *instance = instantiateModule(*module, std::move(link_result.resolvedImports),
+                                                                 object_code, &compiled);
                     EOS_ASSERT(instance != nullptr, wasm_exception, "Fail to Instantiate WAVM Module");
+                    // also replaces an entry whose object code didn't match the module
+                    if (cache && compiled)
+                        cache->put(code_hash, vm_type, vm_version, object_code);
 
                     return std::make_unique<wavm_instantiated_module>(instance, std::move(module), initial_memory);
                 }
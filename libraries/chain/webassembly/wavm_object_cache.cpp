@@ -0,0 +1,142 @@
+#include <eosio/chain/webassembly/wavm_object_cache.hpp>
+#include <eosio/chain/wasm_eosio_injection.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include "Runtime/Runtime.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace eosio {
+    namespace chain {
+        namespace webassembly {
+            namespace wavm {
+
+                namespace {
+                    constexpr uint32_t header_magic = 0x4d564157; // "WAVM"
+                    const char entry_extension[] = ".obj";
+                }
+
+                object_cache::object_cache(const fc::path &d)
+                        : dir(d / ("v" + std::to_string(format_version))),
+                          runtime_version(fc::sha256::hash(Runtime::getObjectCodeVersion())) {
+                    fc::create_directories(dir);
+
+                    // Only the headers are checked here, the object code is checked when it's read.
+                    const size_t header_size = fc::raw::pack_size(header());
+                    std::vector<fc::path> stale;
+                    for (boost::filesystem::directory_iterator itr(dir.string()), end; itr != end; ++itr) {
+                        const fc::path file = itr->path();
+                        header h;
+                        bool valid = false;
+                        if (file.extension().string() == entry_extension) {
+                            std::vector<char> buf(header_size);
+                            std::ifstream in(file.string(), std::ios::binary);
+                            if (in.read(buf.data(), buf.size())) {
+                                fc::datastream<const char *> ds(buf.data(), buf.size());
+                                fc::raw::unpack(ds, h);
+                                valid = valid_header(h, file) &&
+                                        fc::file_size(file) == header_size + h.object_size;
+                            }
+                        }
+                        if (valid)
+                            entries.insert(file);
+                        else
+                            stale.push_back(file);
+                    }
+                    for (const auto &file : stale)
+                        remove(file);
+
+                    ilog("WAVM object cache ${dir} holds ${n} compiled contracts, removed ${r} stale entries",
+                         ("dir", dir.generic_string())("n", entries.size())("r", stale.size()));
+                }
+
+                optional<std::vector<uint8_t>>
+                object_cache::get(const digest_type &code_hash, uint8_t vm_type, uint8_t vm_version) {
+                    std::lock_guard<std::mutex> g(mtx);
+                    const fc::path file = entry_file(code_hash, vm_type, vm_version);
+                    if (!entries.count(file))
+                        return optional<std::vector<uint8_t>>();
+
+                    try {
+                        std::ifstream in(file.string(), std::ios::binary);
+                        std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                        fc::datastream<const char *> ds(buf.data(), buf.size());
+                        header h;
+                        fc::raw::unpack(ds, h);
+                        if (valid_header(h, file) && h.code_hash == code_hash && h.vm_type == vm_type &&
+                            h.vm_version == vm_version && ds.remaining() == h.object_size) {
+                            const char *object = buf.data() + (buf.size() - ds.remaining());
+                            if (fc::sha256::hash(object, h.object_size) == h.object_hash)
+                                return std::vector<uint8_t>(object, object + h.object_size);
+                        }
+                    } FC_LOG_AND_DROP()
+
+                    wlog("Removing corrupt WAVM object cache entry ${f}", ("f", file.generic_string()));
+                    remove(file);
+                    return optional<std::vector<uint8_t>>();
+                }
+
+                void object_cache::put(const digest_type &code_hash, uint8_t vm_type, uint8_t vm_version,
+                                       const std::vector<uint8_t> &object_code) {
+                    std::lock_guard<std::mutex> g(mtx);
+                    header h;
+                    h.magic = header_magic;
+                    h.injection_version = wasm_injections::wasm_binary_injection::version;
+                    h.runtime_version = runtime_version;
+                    h.code_hash = code_hash;
+                    h.vm_type = vm_type;
+                    h.vm_version = vm_version;
+                    h.object_size = object_code.size();
+                    h.object_hash = fc::sha256::hash((const char *) object_code.data(), object_code.size());
+
+                    // Written next to the entry and renamed over it, so a crash never leaves a partial entry behind.
+                    const fc::path file = entry_file(code_hash, vm_type, vm_version);
+                    const fc::path tmp = file.string() + ".tmp";
+                    try {
+                        const auto packed_header = fc::raw::pack(h);
+                        {
+                            std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+                            out.write(packed_header.data(), packed_header.size());
+                            out.write((const char *) object_code.data(), object_code.size());
+                            out.close();
+                            EOS_ASSERT(out, wasm_exception, "failed to write ${f}", ("f", tmp.generic_string()));
+                        }
+                        fc::rename(tmp, file);
+                        entries.insert(file);
+                    } catch (const fc::exception &e) {
+                        wlog("Unable to add ${f} to the WAVM object cache: ${e}",
+                             ("f", file.generic_string())("e", e.to_detail_string()));
+                        remove(tmp);
+                    }
+                }
+
+                fc::path object_cache::entry_file(const digest_type &code_hash, uint8_t vm_type,
+                                                  uint8_t vm_version) const {
+                    return dir / (code_hash.str() + "-" + std::to_string(vm_type) + "-" + std::to_string(vm_version) +
+                                  entry_extension);
+                }
+
+                bool object_cache::valid_header(const header &h, const fc::path &file) const {
+                    return h.magic == header_magic &&
+                           h.injection_version == wasm_injections::wasm_binary_injection::version &&
+                           h.runtime_version == runtime_version &&
+                           entry_file(h.code_hash, h.vm_type, h.vm_version) == file;
+                }
+
+                void object_cache::remove(const fc::path &file) {
+                    entries.erase(file);
+                    boost::system::error_code ec;
+                    boost::filesystem::remove(file.string(), ec);
+                    if (ec)
+                        wlog("Unable to remove ${f} from the WAVM object cache: ${e}",
+                             ("f", file.generic_string())("e", ec.message()));
+                }
+
+            }
+        }
+    }
+} // eosio::chain::webassembly::wavm
@@ -102,6 +102,26 @@ namespace Platform {
     // baseVirtualAddress must be a multiple of the preferred page size.
     PLATFORM_API void freeVirtualPages(U8 *baseVirtualAddress, Uptr numPages);
 
+    // The contents of a range of virtual pages, that can be mapped copy-on-write: mapping it doesn't copy anything, and
+    // a page is only copied when it's first written to.
+    struct PageImage;
+
+    // Creates an image of numPages virtual pages, holding numDataBytes of data followed by zeros.
+    // Returns nullptr if the platform doesn't support page images.
+    PLATFORM_API PageImage *createPageImage(const U8 *data, Uptr numDataBytes, Uptr numPages);
+
+    PLATFORM_API void destroyPageImage(PageImage *image);
+
+    // Maps a page image copy-on-write to the virtual pages starting at baseVirtualAddress, discarding their contents.
+    // baseVirtualAddress must be a multiple of the preferred page size.
+    // Return true if successful.
+    PLATFORM_API bool mapPageImage(PageImage *image, U8 *baseVirtualAddress);
+
+    // Returns virtual pages that were committed, or had a page image mapped to them, to the state allocateVirtualPages
+    // leaves them in. baseVirtualAddress must be a multiple of the preferred page size.
+    // Return true if successful.
+    PLATFORM_API bool resetVirtualPages(U8 *baseVirtualAddress, Uptr numPages);
+
     //
     // Call stack and exceptions
     //
@@ -269,6 +269,21 @@ namespace Runtime {
     // Instantiates a module, bindings its imports to the specified objects. May throw InstantiationException.
     RUNTIME_API ModuleInstance *instantiateModule(const IR::Module &module, ImportBindings &&imports);
 
+    // Instantiates a module like the above, reusing or returning the object code generated for it. If objectCode isn't
+    // empty, it should have been returned for the same module by a runtime with the same getObjectCodeVersion(), and
+    // it's loaded instead of compiling the module. Otherwise, or if it refers to symbols the module doesn't have or
+    // lacks code for some of its functions, the module is compiled and objectCode is replaced by its object code.
+    // outCompiled, if given, is set to whether the module was compiled.
+    RUNTIME_API ModuleInstance *instantiateModule(const IR::Module &module, ImportBindings &&imports,
+                                                  std::vector<U8> &objectCode, bool *outCompiled = nullptr);
+
+    // Generates the object code instantiateModule would for a module, without creating any runtime object. Unlike the
+    // rest of the runtime it's safe to call from any thread, so modules can be compiled while others execute.
+    RUNTIME_API void compileModule(const IR::Module &module, std::vector<U8> &outObjectCode);
+
+    // Identifies the code generator of this build of the runtime. Object code is only valid for the same version.
+    RUNTIME_API std::string getObjectCodeVersion();
+
     // Gets the default table/memory for a ModuleInstance.
     RUNTIME_API MemoryInstance *getDefaultMemory(ModuleInstance *moduleInstance);
 
@@ -282,6 +297,19 @@ namespace Runtime {
 
     RUNTIME_API void resetMemory(MemoryInstance *memory, IR::MemoryType &newMemoryType);
 
+    // The initial contents of a memory, that a memory can be reset to at a cost that depends on the number of pages
+    // written since the last reset rather than on the size of the contents.
+    struct MemorySnapshot;
+
+    // Creates a snapshot of a memory of the given type, holding initialData at offset 0. Returns null if the platform
+    // can't map memory copy-on-write, in which case resetMemory and a copy of the data have to be used instead.
+    RUNTIME_API MemorySnapshot *createMemorySnapshot(const IR::MemoryType &type, const std::vector<U8> &initialData);
+
+    RUNTIME_API void destroyMemorySnapshot(MemorySnapshot *snapshot);
+
+    // Resets a memory to the type and contents of a snapshot.
+    RUNTIME_API void restoreMemorySnapshot(MemoryInstance *memory, MemorySnapshot *snapshot);
+
     // Gets an object exported by a ModuleInstance by name.
     RUNTIME_API ObjectInstance *getInstanceExport(ModuleInstance *moduleInstance, const std::string &name);
 }
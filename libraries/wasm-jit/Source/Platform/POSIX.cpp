@@ -7,6 +7,7 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <stdlib.h>
 
 #include <errno.h>
 #include <signal.h>
@@ -29,6 +30,10 @@
 #ifdef __linux__
 #include <execinfo.h>
 #include <dlfcn.h>
+#include <sys/syscall.h>
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
 #endif
 #ifdef __FreeBSD__
 #include <execinfo.h>
@@ -102,6 +107,62 @@ namespace Platform {
         if (munmap(baseVirtualAddress, numPages << getPageSizeLog2())) { Errors::fatal("munmap failed"); }
     }
 
+    // A page image is kept in an unlinked file, which is mapped privately so that writes don't reach the file.
+    struct PageImage {
+        int fd;
+        Uptr numPages;
+    };
+
+    static int createAnonymousFile() {
+#if defined(__linux__) && defined(SYS_memfd_create)
+        int fd = syscall(SYS_memfd_create, "wavm-page-image", MFD_CLOEXEC);
+        if (fd >= 0) { return fd; }
+#endif
+        char path[] = "/tmp/wavm-page-image-XXXXXX";
+        int fd = mkstemp(path);
+        if (fd >= 0) { unlink(path); }
+        return fd;
+    }
+
+    PageImage *createPageImage(const U8 *data, Uptr numDataBytes, Uptr numPages) {
+        const Uptr numBytes = numPages << getPageSizeLog2();
+        errorUnless(numDataBytes <= numBytes);
+        int fd = createAnonymousFile();
+        if (fd < 0) { return nullptr; }
+
+        // The file is sized first, so the zeros after the data don't take up any space.
+        bool written = ftruncate(fd, numBytes) == 0;
+        for (Uptr offset = 0; written && offset < numDataBytes;) {
+            ssize_t numWrittenBytes = pwrite(fd, data + offset, numDataBytes - offset, offset);
+            if (numWrittenBytes < 0 && errno == EINTR) { continue; }
+            written = numWrittenBytes > 0;
+            if (written) { offset += numWrittenBytes; }
+        }
+        if (!written) {
+            close(fd);
+            return nullptr;
+        }
+        return new PageImage{fd, numPages};
+    }
+
+    void destroyPageImage(PageImage *image) {
+        // Mappings of the image keep the file alive until they're replaced.
+        close(image->fd);
+        delete image;
+    }
+
+    bool mapPageImage(PageImage *image, U8 *baseVirtualAddress) {
+        errorUnless(isPageAligned(baseVirtualAddress));
+        return mmap(baseVirtualAddress, image->numPages << getPageSizeLog2(), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_FIXED, image->fd, 0) == baseVirtualAddress;
+    }
+
+    bool resetVirtualPages(U8 *baseVirtualAddress, Uptr numPages) {
+        errorUnless(isPageAligned(baseVirtualAddress));
+        return mmap(baseVirtualAddress, numPages << getPageSizeLog2(), PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == baseVirtualAddress;
+    }
+
     bool describeInstructionPointer(Uptr ip, std::string &outDescription) {
 #if defined __linux__ || defined __FreeBSD__
         // Look up static symbol information for the address.
@@ -85,6 +85,17 @@ namespace Platform
         if(baseVirtualAddress && !result) { Errors::fatal("VirtualFree(MEM_RELEASE) failed"); }
     }
 
+    // Mapping a view over part of a reserved region isn't possible, so page images aren't supported.
+    PageImage* createPageImage(const U8* data,Uptr numDataBytes,Uptr numPages) { return nullptr; }
+    void destroyPageImage(PageImage* image) {}
+    bool mapPageImage(PageImage* image,U8* baseVirtualAddress) { return false; }
+
+    bool resetVirtualPages(U8* baseVirtualAddress,Uptr numPages)
+    {
+        decommitVirtualPages(baseVirtualAddress,numPages);
+        return true;
+    }
+
     // The interface to the DbgHelp DLL
     struct DbgHelp
     {
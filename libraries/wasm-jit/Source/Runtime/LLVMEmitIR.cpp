@@ -12,10 +12,10 @@
 using namespace IR;
 
 namespace LLVMJIT {
-    // The LLVM IR for a module.
+    // The LLVM IR for a module. It only depends on the module, not on an instance of it, so it can be emitted before the
+    // module is instantiated.
     struct EmitModuleContext {
         const Module &module;
-        ModuleInstance *moduleInstance;
 
         llvm::Module *llvmModule;
         std::vector<llvm::Function *> functionDefs;
@@ -29,8 +29,8 @@ namespace LLVMJIT {
         llvm::MDNode *likelyFalseBranchWeights;
         llvm::MDNode *likelyTrueBranchWeights;
 
-        EmitModuleContext(const Module &inModule, ModuleInstance *inModuleInstance)
-                : module(inModule), moduleInstance(inModuleInstance), llvmModule(new llvm::Module("", context)) {
+        EmitModuleContext(const Module &inModule)
+                : module(inModule), llvmModule(new llvm::Module("", context)) {
             auto zeroAsMetadata = llvm::ConstantAsMetadata::get(emitLiteral(I32(0)));
             auto i32MaxAsMetadata = llvm::ConstantAsMetadata::get(emitLiteral(I32(INT32_MAX)));
             likelyFalseBranchWeights = llvm::MDTuple::getDistinct(context,
@@ -43,6 +43,17 @@ namespace LLVMJIT {
         }
 
         llvm::Module *emit();
+
+        // Emits a reference to a runtime object that is bound to the module instance when its object code is loaded.
+        llvm::Constant *emitSymbolReference(const std::string &symbol, llvm::Type *type) {
+            llvm::GlobalVariable *global = llvmModule->getNamedGlobal(symbol);
+            if (!global) {
+                global = new llvm::GlobalVariable(*llvmModule, llvmI8Type, false, llvm::GlobalValue::ExternalLinkage,
+                                                  nullptr, symbol);
+            }
+            return type->isPointerTy() ? llvm::ConstantExpr::getPointerCast(global, type)
+                                       : llvm::ConstantExpr::getPtrToInt(global, type);
+        }
     };
 
     // The context used by functions involved in JITing a single AST function.
@@ -53,7 +64,7 @@ namespace LLVMJIT {
         const Module &module;
         const FunctionDef &functionDef;
         const FunctionType *functionType;
-        FunctionInstance *functionInstance;
+        Uptr functionDefIndex;
         llvm::Function *llvmFunction;
         llvm::IRBuilder<> irBuilder;
 
@@ -93,10 +104,10 @@ namespace LLVMJIT {
         std::vector<llvm::Value *> stack;
 
         EmitFunctionContext(EmitModuleContext &inEmitModuleContext, const Module &inModule,
-                            const FunctionDef &inFunctionDef, FunctionInstance *inFunctionInstance,
+                            const FunctionDef &inFunctionDef, Uptr inFunctionDefIndex,
                             llvm::Function *inLLVMFunction)
                 : moduleContext(inEmitModuleContext), module(inModule), functionDef(inFunctionDef),
-                  functionType(inModule.types[inFunctionDef.type.index]), functionInstance(inFunctionInstance),
+                  functionType(inModule.types[inFunctionDef.type.index]), functionDefIndex(inFunctionDefIndex),
                   llvmFunction(inLLVMFunction), irBuilder(context) {}
 
         void emit();
@@ -275,8 +286,8 @@ namespace LLVMJIT {
             WAVM_ASSERT_THROW(intrinsicObject);
             FunctionInstance *intrinsicFunction = asFunction(intrinsicObject);
             WAVM_ASSERT_THROW(intrinsicFunction->type == intrinsicType);
-            auto intrinsicFunctionPointer = emitLiteralPointer(intrinsicFunction->nativeFunction,
-                                                               asLLVMType(intrinsicType)->getPointerTo());
+            auto intrinsicFunctionPointer = moduleContext.emitSymbolReference(
+                    getIntrinsicSymbol(intrinsicName, intrinsicType), asLLVMType(intrinsicType)->getPointerTo());
             return irBuilder.CreateCall(intrinsicFunctionPointer,
                                         llvm::ArrayRef<llvm::Value *>(args.begin(), args.end()));
         }
@@ -592,9 +603,9 @@ namespace LLVMJIT {
             llvm::Value *callee;
             const FunctionType *calleeType;
             if (imm.functionIndex < moduleContext.importedFunctionPointers.size()) {
-                WAVM_ASSERT_THROW(imm.functionIndex < moduleContext.moduleInstance->functions.size());
+                WAVM_ASSERT_THROW(imm.functionIndex < module.functions.imports.size());
                 callee = moduleContext.importedFunctionPointers[imm.functionIndex];
-                calleeType = moduleContext.moduleInstance->functions[imm.functionIndex]->type;
+                calleeType = module.types[module.functions.imports[imm.functionIndex].type.index];
             } else {
                 const Uptr calleeIndex = imm.functionIndex - moduleContext.importedFunctionPointers.size();
                 WAVM_ASSERT_THROW(calleeIndex < moduleContext.functionDefs.size());
@@ -640,7 +651,8 @@ namespace LLVMJIT {
             auto functionTypePointerPointer = irBuilder.CreateInBoundsGEP(moduleContext.defaultTablePointer,
                                                                           {functionIndexZExt, emitLiteral((U32) 0)});
             auto functionTypePointer = irBuilder.CreateLoad(functionTypePointerPointer);
-            auto llvmCalleeType = emitLiteralPointer(calleeType, llvmI8PtrType);
+            auto llvmCalleeType = moduleContext.emitSymbolReference(getFunctionTypeSymbol(imm.type.index),
+                                                                    llvmI8PtrType);
 
             // If the function type doesn't match, trap.
             emitConditionalTrapIntrinsic(
@@ -649,7 +661,7 @@ namespace LLVMJIT {
                     FunctionType::get(ResultType::none, {ValueType::i32, ValueType::i64, ValueType::i64}),
                     {tableElementIndex,
                      irBuilder.CreatePtrToInt(llvmCalleeType, llvmI64Type),
-                     emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultTable))}
+                     moduleContext.emitSymbolReference(defaultTableSymbol, llvmI64Type)}
             );
 
             // Call the function loaded from the table.
@@ -706,8 +718,7 @@ namespace LLVMJIT {
 
         void grow_memory(MemoryImm) {
             auto deltaNumPages = pop();
-            auto defaultMemoryObjectAsI64 = emitLiteral(
-                    reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+            auto defaultMemoryObjectAsI64 = moduleContext.emitSymbolReference(defaultMemorySymbol, llvmI64Type);
             auto previousNumPages = emitRuntimeIntrinsic(
                     "wavmIntrinsics.growMemory",
                     FunctionType::get(ResultType::i32, {ValueType::i32, ValueType::i64}),
@@ -716,8 +727,7 @@ namespace LLVMJIT {
         }
 
         void current_memory(MemoryImm) {
-            auto defaultMemoryObjectAsI64 = emitLiteral(
-                    reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+            auto defaultMemoryObjectAsI64 = moduleContext.emitSymbolReference(defaultMemorySymbol, llvmI64Type);
             auto currentNumPages = emitRuntimeIntrinsic(
                     "wavmIntrinsics.currentMemory",
                     FunctionType::get(ResultType::i32, {ValueType::i64}),
@@ -1303,7 +1313,7 @@ namespace LLVMJIT {
         {
             auto numWaiters = pop();
             auto address = pop();
-            auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+            auto defaultMemoryObjectAsI64 = moduleContext.emitSymbolReference(defaultMemorySymbol,llvmI64Type);
             push(emitRuntimeIntrinsic(
                 "wavmIntrinsics.wake",
                 FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i32,ValueType::i64}),
@@ -1314,7 +1324,7 @@ namespace LLVMJIT {
             auto timeout = pop();
             auto expectedValue = pop();
             auto address = pop();
-            auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+            auto defaultMemoryObjectAsI64 = moduleContext.emitSymbolReference(defaultMemorySymbol,llvmI64Type);
             push(emitRuntimeIntrinsic(
                 "wavmIntrinsics.wait",
                 FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i32,ValueType::f64,ValueType::i64}),
@@ -1325,7 +1335,7 @@ namespace LLVMJIT {
             auto timeout = pop();
             auto expectedValue = pop();
             auto address = pop();
-            auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+            auto defaultMemoryObjectAsI64 = moduleContext.emitSymbolReference(defaultMemorySymbol,llvmI64Type);
             push(emitRuntimeIntrinsic(
                 "wavmIntrinsics.wait",
                 FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i64,ValueType::f64,ValueType::i64}),
@@ -1334,11 +1344,11 @@ namespace LLVMJIT {
 
         void launch_thread(LaunchThreadImm)
         {
-            WAVM_ASSERT_THROW(moduleContext.moduleInstance->defaultTable);
+            WAVM_ASSERT_THROW(module.tables.size());
             auto errorFunctionIndex = pop();
             auto argument = pop();
             auto functionIndex = pop();
-            auto defaultTableAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultTable));
+            auto defaultTableAsI64 = moduleContext.emitSymbolReference(defaultTableSymbol,llvmI64Type);
             emitRuntimeIntrinsic(
                 "wavmIntrinsics.launchThread",
                 FunctionType::get(ResultType::none,{ValueType::i32,ValueType::i32,ValueType::i32,ValueType::i64}),
@@ -1568,7 +1578,7 @@ namespace LLVMJIT {
             emitRuntimeIntrinsic(
                     "wavmIntrinsics.debugEnterFunction",
                     FunctionType::get(ResultType::none, {ValueType::i64}),
-                    {emitLiteral(reinterpret_cast<U64>(functionInstance))}
+                    {moduleContext.emitSymbolReference(getFunctionDefSymbol(functionDefIndex), llvmI64Type)}
             );
         }
 
@@ -1611,7 +1621,7 @@ namespace LLVMJIT {
             emitRuntimeIntrinsic(
                     "wavmIntrinsics.debugExitFunction",
                     FunctionType::get(ResultType::none, {ValueType::i64}),
-                    {emitLiteral(reinterpret_cast<U64>(functionInstance))}
+                    {moduleContext.emitSymbolReference(getFunctionDefSymbol(functionDefIndex), llvmI64Type)}
             );
         }
 
@@ -1623,53 +1633,53 @@ namespace LLVMJIT {
     llvm::Module *EmitModuleContext::emit() {
         Timing::Timer emitTimer;
 
-        // Create literals for the default memory base and mask.
-        if (moduleInstance->defaultMemory) {
-            defaultMemoryBase = emitLiteralPointer(moduleInstance->defaultMemory->baseAddress, llvmI8PtrType);
-            const Uptr defaultMemoryEndOffsetValue = Uptr(moduleInstance->defaultMemory->endOffset);
+        // Create references to the default memory base and a literal for its end offset.
+        if (module.memories.size()) {
+            defaultMemoryBase = emitSymbolReference(defaultMemoryBaseSymbol, llvmI8PtrType);
+            const Uptr defaultMemoryEndOffsetValue = getMemoryMaxBytes();
             defaultMemoryEndOffset = emitLiteral(defaultMemoryEndOffsetValue);
         } else { defaultMemoryBase = defaultMemoryEndOffset = nullptr; }
 
         // Set up the LLVM values used to access the global table.
-        if (moduleInstance->defaultTable) {
+        if (module.tables.size()) {
             auto tableElementType = llvm::StructType::get(context, {
                     llvmI8PtrType,
                     llvmI8PtrType
             });
-            defaultTablePointer = emitLiteralPointer(moduleInstance->defaultTable->baseAddress,
-                                                     tableElementType->getPointerTo());
+            defaultTablePointer = emitSymbolReference(defaultTableBaseSymbol, tableElementType->getPointerTo());
             defaultTableMaxElementIndex = emitLiteral(
-                    ((Uptr) moduleInstance->defaultTable->endOffset) / sizeof(TableInstance::FunctionElement));
+                    getTableMaxBytes() / sizeof(TableInstance::FunctionElement));
         } else {
             defaultTablePointer = defaultTableMaxElementIndex = nullptr;
         }
 
         // Create LLVM pointer constants for the module's imported functions.
         for (Uptr functionIndex = 0; functionIndex < module.functions.imports.size(); ++functionIndex) {
-            const FunctionInstance *functionInstance = moduleInstance->functions[functionIndex];
-            importedFunctionPointers.push_back(emitLiteralPointer(functionInstance->nativeFunction,
-                                                                  asLLVMType(functionInstance->type)->getPointerTo()));
+            const FunctionType *functionType = module.types[module.functions.imports[functionIndex].type.index];
+            importedFunctionPointers.push_back(emitSymbolReference(getImportedFunctionSymbol(functionIndex),
+                                                                   asLLVMType(functionType)->getPointerTo()));
         }
 
         // Create LLVM pointer constants for the module's globals.
-        for (auto global : moduleInstance->globals) {
-            globalPointers.push_back(
-                    emitLiteralPointer(&global->value, asLLVMType(global->type.valueType)->getPointerTo()));
+        for (Uptr globalIndex = 0; globalIndex < module.globals.size(); ++globalIndex) {
+            const GlobalType globalType = module.globals.getType(globalIndex);
+            globalPointers.push_back(emitSymbolReference(getGlobalSymbol(globalIndex),
+                                                         asLLVMType(globalType.valueType)->getPointerTo()));
         }
 
         // Create the LLVM functions.
         functionDefs.resize(module.functions.defs.size());
         for (Uptr functionDefIndex = 0; functionDefIndex < module.functions.defs.size(); ++functionDefIndex) {
             auto llvmFunctionType = asLLVMType(module.types[module.functions.defs[functionDefIndex].type.index]);
-            auto externalName = getExternalFunctionName(moduleInstance, functionDefIndex);
+            auto externalName = getExternalFunctionName(functionDefIndex);
             functionDefs[functionDefIndex] = llvm::Function::Create(llvmFunctionType, llvm::Function::ExternalLinkage,
                                                                     externalName, llvmModule);
         }
 
         // Compile each function in the module.
         for (Uptr functionDefIndex = 0; functionDefIndex < module.functions.defs.size(); ++functionDefIndex) {
-            EmitFunctionContext(*this, module, module.functions.defs[functionDefIndex],
-                                moduleInstance->functionDefs[functionDefIndex], functionDefs[functionDefIndex]).emit();
+            EmitFunctionContext(*this, module, module.functions.defs[functionDefIndex], functionDefIndex,
+                                functionDefs[functionDefIndex]).emit();
         }
 
         Timing::logRatePerSecond("Emitted LLVM IR", emitTimer, (F64) llvmModule->size(), "functions");
@@ -1677,7 +1687,7 @@ namespace LLVMJIT {
         return llvmModule;
     }
 
-    llvm::Module *emitModule(const Module &module, ModuleInstance *moduleInstance) {
-        return EmitModuleContext(module, moduleInstance).emit();
+    llvm::Module *emitModule(const Module &module) {
+        return EmitModuleContext(module).emit();
     }
 }
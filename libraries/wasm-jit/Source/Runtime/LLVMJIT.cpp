@@ -4,6 +4,10 @@
 #include "Logging/Logging.h"
 #include "RuntimePrivate.h"
 #include "IR/Validate.h"
+#include "ObjectCodeVersion.h"
+
+#include <algorithm>
+#include <functional>
 
 #ifdef _DEBUG
 // This needs to be 1 to allow debuggers such as Visual Studio to place breakpoints and step through the JITed code.
@@ -55,9 +59,16 @@ namespace LLVMJIT {
     Platform::Mutex *addressToSymbolMapMutex = Platform::createMutex();
     std::map<Uptr, struct JITSymbol *> addressToSymbolMap;
 
+    // Modules may be instantiated on a different thread than the one invoking functions. LLVM's context and target
+    // machine are shared by everything generating code, so only one thread may generate code at a time.
+    Platform::Mutex *llvmMutex = Platform::createMutex();
+
     // A map from function types to function indices in the invoke thunk unit.
+    Platform::Mutex *invokeThunkMutex = Platform::createMutex();
     std::map<const FunctionType *, struct JITSymbol *> invokeThunkTypeToSymbolMap;
 
+    static InvokeFunctionPointer generateInvokeThunk(const FunctionType *functionType);
+
     // Information about a JIT symbol, used to map instruction pointers to descriptive names.
     struct JITSymbol {
         enum class Type {
@@ -228,24 +239,32 @@ namespace LLVMJIT {
         {
             objectLayer = llvm::make_unique<ObjectLayer>(NotifyLoadedFunctor(this), NotifyFinalizedFunctor(this));
             objectLayer->setProcessAllSections(true);
-            compileLayer = llvm::make_unique<CompileLayer>(*objectLayer, llvm::orc::SimpleCompiler(*targetMachine));
         }
 
         ~JITUnit() {
             if (handleIsValid)
-                compileLayer->removeModuleSet(handle);
+                objectLayer->removeObjectSet(handle);
 #ifdef _WIN64
             if(pdataCopy) { Platform::deregisterSEHUnwindInfo(reinterpret_cast<Uptr>(pdataCopy)); }
 #endif
         }
 
-        void compile(llvm::Module *llvmModule);
+        // Compiles the module, storing the object code in outObjectCode if it's non-null.
+        void compile(llvm::Module *llvmModule, llvm::JITSymbolResolver *resolver,
+                     std::vector<U8> *outObjectCode = nullptr);
+
+        // Loads object code produced by compile in this or an earlier process. Returns false if it isn't a valid object
+        // file, or if accept rejects it.
+        bool load(const std::vector<U8> &objectCode, llvm::JITSymbolResolver *resolver,
+                  const std::function<bool(const llvm::object::ObjectFile &)> &accept);
 
         virtual void notifySymbolLoaded(const char *name, Uptr baseAddress, Uptr numBytes,
                                         std::map<U32, U32> &&offsetToOpIndexMap) = 0;
 
     private:
 
+        void link(llvm::object::OwningBinary<llvm::object::ObjectFile> &&object, llvm::JITSymbolResolver *resolver);
+
         // Functor that receives notifications when an object produced by the JIT is loaded.
         struct NotifyLoadedFunctor {
             JITUnit *jitUnit;
@@ -269,12 +288,10 @@ namespace LLVMJIT {
         };
 
         typedef llvm::orc::ObjectLinkingLayer<NotifyLoadedFunctor> ObjectLayer;
-        typedef llvm::orc::IRCompileLayer<ObjectLayer> CompileLayer;
 
         UnitMemoryManager memoryManager;
         std::unique_ptr<ObjectLayer> objectLayer;
-        std::unique_ptr<CompileLayer> compileLayer;
-        CompileLayer::ModuleSetHandleT handle;
+        ObjectLayer::ObjSetHandleT handle;
         bool handleIsValid = false;
         bool shouldLogMetrics;
 
@@ -383,6 +400,23 @@ namespace LLVMJIT {
 
     llvm::JITSymbol NullResolver::findSymbolInLogicalDylib(const std::string &name) { return llvm::JITSymbol(nullptr); }
 
+    // Binds the symbols a module's code uses for runtime objects to the objects of a module instance.
+    struct ModuleResolver : NullResolver {
+        const IR::Module &module;
+        ModuleInstance *moduleInstance;
+
+        ModuleResolver(const IR::Module &inModule, ModuleInstance *inModuleInstance)
+                : module(inModule), moduleInstance(inModuleInstance) {}
+
+        virtual llvm::JITSymbol findSymbol(const std::string &name) override {
+            Uptr address;
+            if (resolveModuleSymbol(module, moduleInstance, name, address)) {
+                return llvm::JITSymbol(address, llvm::JITSymbolFlags::None);
+            }
+            return NullResolver::findSymbol(name);
+        }
+    };
+
     void JITUnit::NotifyLoadedFunctor::operator()(
             const llvm::orc::ObjectLinkingLayerBase::ObjSetHandleT &objectSetHandle,
             const std::vector<std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>> &objectSet,
@@ -530,7 +564,10 @@ namespace LLVMJIT {
         Log::printf(Log::Category::debug, "Dumped LLVM module to: %s\n", augmentedFilename.c_str());
     }
 
-    void JITUnit::compile(llvm::Module *llvmModule) {
+    // Optimizes a module and generates machine code for it, taking ownership of the module. The caller must hold
+    // llvmMutex.
+    static llvm::object::OwningBinary<llvm::object::ObjectFile>
+    generateObject(llvm::Module *llvmModule, bool shouldLogMetrics) {
         // Get a target machine object for this host, and set the module to use its data layout.
         llvmModule->setDataLayout(targetMachine->createDataLayout());
 
@@ -567,38 +604,141 @@ namespace LLVMJIT {
 
         if (DUMP_OPTIMIZED_MODULE) { printModule(llvmModule, "llvmOptimizedDump"); }
 
-        // Pass the module to the JIT compiler.
+        // Generate machine code for the module.
         Timing::Timer machineCodeTimer;
-        handle = compileLayer->addModuleSet(
-                std::vector<llvm::Module *>{llvmModule},
-                &memoryManager,
-                &NullResolver::singleton);
-        handleIsValid = true;
-        compileLayer->emitAndFinalize(handle);
+        auto object = llvm::orc::SimpleCompiler(*targetMachine)(*llvmModule);
+        if (!object.getBinary()) { Errors::fatal("LLVM failed to generate an object file"); }
 
         if (shouldLogMetrics) {
             Timing::logRatePerSecond("Generated machine code", machineCodeTimer, (F64) llvmModule->size(), "functions");
         }
 
         delete llvmModule;
+        return object;
+    }
+
+    static void copyObjectCode(const llvm::object::OwningBinary<llvm::object::ObjectFile> &object,
+                               std::vector<U8> &outObjectCode) {
+        const llvm::MemoryBufferRef objectBuffer = object.getBinary()->getMemoryBufferRef();
+        outObjectCode.assign(objectBuffer.getBufferStart(), objectBuffer.getBufferEnd());
     }
 
-    void instantiateModule(const IR::Module &module, ModuleInstance *moduleInstance) {
-        // Emit LLVM IR for the module.
-        auto llvmModule = emitModule(module, moduleInstance);
+    void JITUnit::compile(llvm::Module *llvmModule, llvm::JITSymbolResolver *resolver, std::vector<U8> *outObjectCode) {
+        auto object = generateObject(llvmModule, shouldLogMetrics);
+        if (outObjectCode) { copyObjectCode(object, *outObjectCode); }
+        link(std::move(object), resolver);
+    }
+
+    bool JITUnit::load(const std::vector<U8> &objectCode, llvm::JITSymbolResolver *resolver,
+                       const std::function<bool(const llvm::object::ObjectFile &)> &accept) {
+        std::unique_ptr<llvm::MemoryBuffer> objectBuffer = llvm::MemoryBuffer::getMemBufferCopy(
+                llvm::StringRef(reinterpret_cast<const char *>(objectCode.data()), objectCode.size()));
+        auto object = llvm::object::ObjectFile::createObjectFile(objectBuffer->getMemBufferRef());
+        if (!object) {
+            llvm::consumeError(object.takeError());
+            return false;
+        }
+        if (!accept(**object)) { return false; }
+
+        link(llvm::object::OwningBinary<llvm::object::ObjectFile>(std::move(*object), std::move(objectBuffer)),
+             resolver);
+        return true;
+    }
+
+    void JITUnit::link(llvm::object::OwningBinary<llvm::object::ObjectFile> &&object,
+                       llvm::JITSymbolResolver *resolver) {
+        std::vector<std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>> objectSet;
+        objectSet.push_back(llvm::make_unique<llvm::object::OwningBinary<llvm::object::ObjectFile>>(std::move(object)));
+        handle = objectLayer->addObjectSet(std::move(objectSet), &memoryManager, resolver);
+        handleIsValid = true;
+        objectLayer->emitAndFinalize(handle);
+    }
+
+    // Whether object code links against a module instance: every symbol it refers to must be one the instance
+    // resolves, and it must define the code of each function of the module. Object code of another module, or of a
+    // runtime that names symbols differently, fails this instead of aborting the process on an unresolved symbol.
+    static bool objectMatchesModule(const llvm::object::ObjectFile &object, const IR::Module &module,
+                                    ModuleInstance *moduleInstance) {
+        std::vector<bool> defined(moduleInstance->functionDefs.size(), false);
+        for (const llvm::object::SymbolRef &symbol : object.symbols()) {
+            auto name = symbol.getName();
+            if (!name) {
+                llvm::consumeError(name.takeError());
+                return false;
+            }
+            const std::string symbolName = name->str();
+            // ELF symbol tables start with a null symbol, which has no name and is undefined
+            if (symbolName.empty()) { continue; }
+            if (symbol.getFlags() & llvm::object::SymbolRef::SF_Undefined) {
+                Uptr address;
+                if (!resolveModuleSymbol(module, moduleInstance, symbolName, address)
+                    && !runtimeSymbolMap.count(symbolName)) { return false; }
+            } else {
+                Uptr functionDefIndex;
+                if (getFunctionIndexFromExternalName(symbolName.c_str(), functionDefIndex)) {
+                    if (functionDefIndex >= defined.size()) { return false; }
+                    defined[functionDefIndex] = true;
+                }
+            }
+        }
+        return std::find(defined.begin(), defined.end(), false) == defined.end();
+    }
+
+    bool instantiateModule(const IR::Module &module, ModuleInstance *moduleInstance, std::vector<U8> *objectCode) {
+        Platform::Lock llvmLock(llvmMutex);
 
         // Construct the JIT compilation pipeline for this module.
         auto jitModule = new JITModule(moduleInstance);
         moduleInstance->jitModule = jitModule;
+        ModuleResolver resolver(module, moduleInstance);
+
+        // Load the object code the module was compiled to before, if there is any.
+        bool loaded = false;
+        if (objectCode && objectCode->size()) {
+            Timing::Timer loadTimer;
+            loaded = jitModule->load(*objectCode, &resolver, [&](const llvm::object::ObjectFile &object) {
+                return objectMatchesModule(object, module, moduleInstance);
+            });
+            if (loaded) { Timing::logTimer("Loaded object code", loadTimer); }
+            else { Log::printf(Log::Category::error, "Invalid object code, compiling the module instead\n"); }
+        }
+
+        // Emit LLVM IR for the module, and compile it.
+        if (!loaded) {
+            auto llvmModule = emitModule(module);
+            jitModule->compile(llvmModule, &resolver, objectCode);
+        }
+
+        // Generate the invoke thunks for the module's exports now, so invoking them doesn't have to wait for another
+        // thread's code generation.
+        for (const Export &exportIt : module.exports) {
+            if (exportIt.kind == ObjectKind::function) {
+                generateInvokeThunk(moduleInstance->functions[exportIt.index]->type);
+            }
+        }
+        return !loaded;
+    }
+
+    void compileModule(const IR::Module &module, std::vector<U8> &outObjectCode) {
+        Platform::Lock llvmLock(llvmMutex);
+        copyObjectCode(generateObject(emitModule(module), true), outObjectCode);
+    }
 
-        // Compile the module.
-        jitModule->compile(llvmModule);
+    // Bump when the format of the object code, or how it's loaded, changes.
+    static constexpr U32 objectCodeFormatVersion = 2;
+
+    std::string getObjectCodeVersion() {
+        // The object code depends on the code generator and on the sources of the runtime that emit IR for it.
+        return "wavm-object-" + std::to_string(objectCodeFormatVersion)
+               + " sources-" + WAVM_OBJECT_CODE_SOURCES_HASH
+               + " llvm-" + LLVM_VERSION_STRING
+               + " " + targetMachine->getTargetTriple().str()
+               + " " + targetMachine->getTargetCPU().str()
+               + " " + targetMachine->getTargetFeatureString().str();
     }
 
-    std::string getExternalFunctionName(ModuleInstance *moduleInstance, Uptr functionDefIndex) {
-        WAVM_ASSERT_THROW(functionDefIndex < moduleInstance->functionDefs.size());
-        return "wasmFunc" + std::to_string(functionDefIndex)
-               + "_" + moduleInstance->functionDefs[functionDefIndex]->debugName;
+    std::string getExternalFunctionName(Uptr functionDefIndex) {
+        return "wasmFunc" + std::to_string(functionDefIndex);
     }
 
     bool getFunctionIndexFromExternalName(const char *externalName, Uptr &outFunctionDefIndex) {
@@ -617,6 +757,103 @@ namespace LLVMJIT {
         } else { return false; }
     }
 
+    const char defaultMemorySymbol[] = "wavmDefaultMemory";
+    const char defaultMemoryBaseSymbol[] = "wavmDefaultMemoryBase";
+    const char defaultTableSymbol[] = "wavmDefaultTable";
+    const char defaultTableBaseSymbol[] = "wavmDefaultTableBase";
+
+    static const char importedFunctionSymbolPrefix[] = "wavmImport";
+    static const char globalSymbolPrefix[] = "wavmGlobal";
+    static const char functionDefSymbolPrefix[] = "wavmFunctionDef";
+    static const char functionTypeSymbolPrefix[] = "wavmType";
+    static const char intrinsicSymbolPrefix[] = "wavmIntrinsic.";
+
+    std::string getImportedFunctionSymbol(Uptr importIndex) {
+        return importedFunctionSymbolPrefix + std::to_string(importIndex);
+    }
+
+    std::string getGlobalSymbol(Uptr globalIndex) { return globalSymbolPrefix + std::to_string(globalIndex); }
+
+    std::string getFunctionDefSymbol(Uptr functionDefIndex) {
+        return functionDefSymbolPrefix + std::to_string(functionDefIndex);
+    }
+
+    std::string getFunctionTypeSymbol(Uptr typeIndex) { return functionTypeSymbolPrefix + std::to_string(typeIndex); }
+
+    std::string getIntrinsicSymbol(const char *intrinsicName, const FunctionType *intrinsicType) {
+        // Intrinsics are overloaded by type, so the symbol spells out the type as a digit per type, the result first.
+        std::string symbol = intrinsicSymbolPrefix + std::to_string(Uptr(intrinsicType->ret));
+        for (ValueType parameterType : intrinsicType->parameters) { symbol += std::to_string(Uptr(parameterType)); }
+        return symbol + "." + intrinsicName;
+    }
+
+    static bool getSymbolIndex(const std::string &symbol, const char *prefix, Uptr &outIndex) {
+        const Uptr numPrefixChars = strlen(prefix);
+        if (symbol.size() <= numPrefixChars || symbol.compare(0, numPrefixChars, prefix)) { return false; }
+        char *numberEnd = nullptr;
+        U64 index64 = std::strtoull(symbol.c_str() + numPrefixChars, &numberEnd, 10);
+        if (*numberEnd || index64 > UINTPTR_MAX) { return false; }
+        outIndex = Uptr(index64);
+        return true;
+    }
+
+    static bool resolveIntrinsicSymbol(const std::string &symbol, Uptr &outAddress) {
+        const Uptr typeBegin = sizeof(intrinsicSymbolPrefix) - 1;
+        const Uptr typeEnd = symbol.find('.', typeBegin);
+        if (typeEnd == std::string::npos || typeEnd == typeBegin) { return false; }
+        for (Uptr charIndex = typeBegin; charIndex < typeEnd; ++charIndex) {
+            if (!isdigit(symbol[charIndex])) { return false; }
+        }
+
+        const U8 ret = U8(symbol[typeBegin] - '0');
+        if (ret > U8(ResultType::max)) { return false; }
+        std::vector<ValueType> parameters;
+        for (Uptr charIndex = typeBegin + 1; charIndex < typeEnd; ++charIndex) {
+            const U8 parameterType = U8(symbol[charIndex] - '0');
+            if (parameterType == U8(ValueType::any) || parameterType > U8(ValueType::max)) { return false; }
+            parameters.push_back(ValueType(parameterType));
+        }
+
+        ObjectInstance *intrinsicObject = Intrinsics::find(symbol.substr(typeEnd + 1),
+                                                           FunctionType::get(ResultType(ret), parameters));
+        if (!intrinsicObject) { return false; }
+        outAddress = reinterpret_cast<Uptr>(asFunction(intrinsicObject)->nativeFunction);
+        return true;
+    }
+
+    bool resolveModuleSymbol(const IR::Module &module, ModuleInstance *moduleInstance, const std::string &mangledSymbol,
+                             Uptr &outAddress) {
+#if defined(_WIN32) && !defined(_WIN64)
+        if (mangledSymbol.empty() || mangledSymbol[0] != '_') { return false; }
+        const std::string symbol = mangledSymbol.substr(1);
+#else
+        const std::string &symbol = mangledSymbol;
+#endif
+        Uptr index;
+        if (symbol == defaultMemorySymbol && moduleInstance->defaultMemory) {
+            outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultMemory);
+        } else if (symbol == defaultMemoryBaseSymbol && moduleInstance->defaultMemory) {
+            outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultMemory->baseAddress);
+        } else if (symbol == defaultTableSymbol && moduleInstance->defaultTable) {
+            outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultTable);
+        } else if (symbol == defaultTableBaseSymbol && moduleInstance->defaultTable) {
+            outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultTable->baseAddress);
+        } else if (getSymbolIndex(symbol, importedFunctionSymbolPrefix, index)
+                   && index < module.functions.imports.size()) {
+            outAddress = reinterpret_cast<Uptr>(moduleInstance->functions[index]->nativeFunction);
+        } else if (getSymbolIndex(symbol, globalSymbolPrefix, index) && index < moduleInstance->globals.size()) {
+            outAddress = reinterpret_cast<Uptr>(&moduleInstance->globals[index]->value);
+        } else if (getSymbolIndex(symbol, functionDefSymbolPrefix, index)
+                   && index < moduleInstance->functionDefs.size()) {
+            outAddress = reinterpret_cast<Uptr>(moduleInstance->functionDefs[index]);
+        } else if (getSymbolIndex(symbol, functionTypeSymbolPrefix, index) && index < module.types.size()) {
+            outAddress = reinterpret_cast<Uptr>(module.types[index]);
+        } else if (!symbol.compare(0, sizeof(intrinsicSymbolPrefix) - 1, intrinsicSymbolPrefix)) {
+            return resolveIntrinsicSymbol(symbol, outAddress);
+        } else { return false; }
+        return true;
+    }
+
     bool describeInstructionPointer(Uptr ip, std::string &outDescription) {
         JITSymbol *symbol;
         {
@@ -650,11 +887,18 @@ namespace LLVMJIT {
         return true;
     }
 
-    InvokeFunctionPointer getInvokeThunk(const FunctionType *functionType) {
-        // Reuse cached invoke thunks for the same function type.
+    static InvokeFunctionPointer findInvokeThunk(const FunctionType *functionType) {
+        Platform::Lock invokeThunkLock(invokeThunkMutex);
         auto mapIt = invokeThunkTypeToSymbolMap.find(functionType);
         if (mapIt !=
             invokeThunkTypeToSymbolMap.end()) { return reinterpret_cast<InvokeFunctionPointer>(mapIt->second->baseAddress); }
+        return nullptr;
+    }
+
+    // The caller must hold llvmMutex.
+    static InvokeFunctionPointer generateInvokeThunk(const FunctionType *functionType) {
+        // Reuse cached invoke thunks for the same function type.
+        if (auto invokeThunk = findInvokeThunk(functionType)) { return invokeThunk; }
 
         auto llvmModule = new llvm::Module("", context);
         auto llvmFunctionType = llvm::FunctionType::get(
@@ -700,10 +944,13 @@ namespace LLVMJIT {
 
         // Compile the invoke thunk.
         auto jitUnit = new JITInvokeThunkUnit(functionType);
-        jitUnit->compile(llvmModule);
+        jitUnit->compile(llvmModule, &NullResolver::singleton);
 
         WAVM_ASSERT_THROW(jitUnit->symbol);
-        invokeThunkTypeToSymbolMap[functionType] = jitUnit->symbol;
+        {
+            Platform::Lock invokeThunkLock(invokeThunkMutex);
+            invokeThunkTypeToSymbolMap[functionType] = jitUnit->symbol;
+        }
 
         {
             Platform::Lock addressToSymbolMapLock(addressToSymbolMapMutex);
@@ -713,6 +960,13 @@ namespace LLVMJIT {
         return reinterpret_cast<InvokeFunctionPointer>(jitUnit->symbol->baseAddress);
     }
 
+    InvokeFunctionPointer getInvokeThunk(const FunctionType *functionType) {
+        if (auto invokeThunk = findInvokeThunk(functionType)) { return invokeThunk; }
+
+        Platform::Lock llvmLock(llvmMutex);
+        return generateInvokeThunk(functionType);
+    }
+
     void init() {
         llvm::InitializeNativeTarget();
         llvm::InitializeNativeTargetAsmPrinter();
@@ -24,6 +24,7 @@
 #endif
 
 #include "llvm/Analysis/Passes.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
@@ -46,6 +47,7 @@
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/IR/DIBuilder.h"
@@ -149,10 +151,31 @@ namespace LLVMJIT {
     }
 
     // Functions that map between the symbols used for externally visible functions and the function
-    std::string getExternalFunctionName(ModuleInstance *moduleInstance, Uptr functionDefIndex);
+    std::string getExternalFunctionName(Uptr functionDefIndex);
 
     bool getFunctionIndexFromExternalName(const char *externalName, Uptr &outFunctionDefIndex);
 
+    // Symbols that stand for the runtime objects a module's code refers to. They are bound to the module instance when
+    // its object code is loaded, so the object code doesn't contain addresses that are only valid in this process.
+    extern const char defaultMemorySymbol[];
+    extern const char defaultMemoryBaseSymbol[];
+    extern const char defaultTableSymbol[];
+    extern const char defaultTableBaseSymbol[];
+
+    std::string getImportedFunctionSymbol(Uptr importIndex);
+
+    std::string getGlobalSymbol(Uptr globalIndex);
+
+    std::string getFunctionDefSymbol(Uptr functionDefIndex);
+
+    std::string getFunctionTypeSymbol(Uptr typeIndex);
+
+    std::string getIntrinsicSymbol(const char *intrinsicName, const FunctionType *intrinsicType);
+
+    // Looks up the address one of the above symbols stands for in a module instance.
+    bool resolveModuleSymbol(const IR::Module &module, ModuleInstance *moduleInstance, const std::string &symbol,
+                             Uptr &outAddress);
+
     // Emits LLVM IR for a module.
-    llvm::Module *emitModule(const IR::Module &module, ModuleInstance *moduleInstance);
+    llvm::Module *emitModule(const IR::Module &module);
 }
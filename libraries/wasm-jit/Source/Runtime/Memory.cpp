@@ -3,6 +3,8 @@
 #include "Platform/Platform.h"
 #include "RuntimePrivate.h"
 
+#include <algorithm>
+
 namespace Runtime {
     // Global lists of memories; used to query whether an address is reserved by one of them.
     std::vector<MemoryInstance *> memories;
@@ -25,13 +27,17 @@ namespace Runtime {
         else { return (U8 *) ((Uptr) (outUnalignedBaseAddress + alignmentBytes - 1) & ~(alignmentBytes - 1)); }
     }
 
-    MemoryInstance *createMemory(MemoryType type) {
-        MemoryInstance *memory = new MemoryInstance(type);
-
+    Uptr getMemoryMaxBytes() {
         // On a 64-bit runtime, allocate 8GB of address space for the memory.
         // This allows eliding bounds checks on memory accesses, since a 32-bit index + 32-bit offset will always be within the reserved address-space.
         // On a 32-bit runtime, allocate 256MB.
-        const Uptr memoryMaxBytes = HAS_64BIT_ADDRESS_SPACE ? Uptr(8ull * 1024 * 1024 * 1024) : 0x10000000;
+        return HAS_64BIT_ADDRESS_SPACE ? Uptr(8ull * 1024 * 1024 * 1024) : 0x10000000;
+    }
+
+    MemoryInstance *createMemory(MemoryType type) {
+        MemoryInstance *memory = new MemoryInstance(type);
+
+        const Uptr memoryMaxBytes = getMemoryMaxBytes();
 
         // On a 64 bit runtime, align the instance memory base to a 4GB boundary, so the lower 32-bits will all be zero. Maybe it will allow better code generation?
         // Note that this reserves a full extra 4GB, but only uses (4GB-1 page) for alignment, so there will always be a guard page at the end to
@@ -99,6 +105,22 @@ namespace Runtime {
     }
 
     void resetMemory(MemoryInstance *memory, MemoryType &newMemoryType) {
+        // Pages a snapshot was mapped to would show the snapshot again once decommitted, instead of zeros. Put them back
+        // to reserved pages like those of a new memory, which also stops them from sharing the snapshot's pages.
+        if (memory->numSnapshotPages) {
+            const Uptr numUsedPages = std::max(Uptr(memory->numPages), memory->numSnapshotPages);
+            if (!Platform::resetVirtualPages(memory->baseAddress,
+                                             numUsedPages << getPlatformPagesPerWebAssemblyPageLog2())) {
+                causeException(Exception::Cause::outOfMemory);
+            }
+            memory->numSnapshotPages = 0;
+            memory->numPages = 0;
+            memory->type = newMemoryType;
+            if (growMemory(memory, memory->type.size.min) == -1)
+                causeException(Exception::Cause::outOfMemory);
+            return;
+        }
+
         memory->type.size.min = 1;
         if (shrinkMemory(memory, memory->numPages - 1) == -1)
             causeException(Exception::Cause::outOfMemory);
@@ -108,6 +130,52 @@ namespace Runtime {
             causeException(Exception::Cause::outOfMemory);
     }
 
+    struct MemorySnapshot {
+        MemoryType type;
+        // Null if the snapshot is empty.
+        Platform::PageImage *image;
+    };
+
+    MemorySnapshot *createMemorySnapshot(const MemoryType &type, const std::vector<U8> &initialData) {
+        WAVM_ASSERT_THROW(type.size.min <= UINTPTR_MAX >> IR::numBytesPerPageLog2);
+        const Uptr numPages = Uptr(type.size.min);
+        errorUnless(initialData.size() <= numPages << IR::numBytesPerPageLog2);
+
+        Platform::PageImage *image = nullptr;
+        if (numPages) {
+            image = Platform::createPageImage(initialData.data(), initialData.size(),
+                                              numPages << getPlatformPagesPerWebAssemblyPageLog2());
+            if (!image) { return nullptr; }
+        }
+        return new MemorySnapshot{type, image};
+    }
+
+    void destroyMemorySnapshot(MemorySnapshot *snapshot) {
+        if (snapshot->image) { Platform::destroyPageImage(snapshot->image); }
+        delete snapshot;
+    }
+
+    void restoreMemorySnapshot(MemoryInstance *memory, MemorySnapshot *snapshot) {
+        const Uptr numPages = Uptr(snapshot->type.size.min);
+
+        // Anything past the snapshot, whether grown into or mapped to a larger snapshot, goes back to being reserved.
+        const Uptr numUsedPages = std::max(Uptr(memory->numPages), memory->numSnapshotPages);
+        if (numUsedPages > numPages &&
+            !Platform::resetVirtualPages(memory->baseAddress + (numPages << IR::numBytesPerPageLog2),
+                                         (numUsedPages - numPages) << getPlatformPagesPerWebAssemblyPageLog2())) {
+            causeException(Exception::Cause::outOfMemory);
+        }
+
+        // Mapping the snapshot drops the copies of the pages written to since it was last mapped, so only those cost
+        // anything; the others still share the snapshot's pages.
+        if (snapshot->image && !Platform::mapPageImage(snapshot->image, memory->baseAddress)) {
+            causeException(Exception::Cause::outOfMemory);
+        }
+        memory->numSnapshotPages = numPages;
+        memory->numPages = numPages;
+        memory->type = snapshot->type;
+    }
+
     Iptr growMemory(MemoryInstance *memory, Uptr numNewPages) {
         const Uptr previousNumPages = memory->numPages;
         if (numNewPages > 0) {
@@ -31,7 +31,8 @@ namespace Runtime {
 
     MemoryInstance *MemoryInstance::theMemoryInstance = nullptr;
 
-    ModuleInstance *instantiateModule(const IR::Module &module, ImportBindings &&imports) {
+    static ModuleInstance *instantiateModule(const IR::Module &module, ImportBindings &&imports,
+                                             std::vector<U8> *objectCode, bool *outCompiled) {
         ModuleInstance *moduleInstance = new ModuleInstance(
                 std::move(imports.functions),
                 std::move(imports.tables),
@@ -123,7 +124,8 @@ namespace Runtime {
         }
 
         // Generate machine code for the module.
-        LLVMJIT::instantiateModule(module, moduleInstance);
+        const bool compiled = LLVMJIT::instantiateModule(module, moduleInstance, objectCode);
+        if (outCompiled) { *outCompiled = compiled; }
 
         // Set up the instance's exports.
         for (const Export &exportIt : module.exports) {
@@ -173,6 +175,21 @@ namespace Runtime {
         return moduleInstance;
     }
 
+    ModuleInstance *instantiateModule(const IR::Module &module, ImportBindings &&imports) {
+        return instantiateModule(module, std::move(imports), nullptr, nullptr);
+    }
+
+    ModuleInstance *instantiateModule(const IR::Module &module, ImportBindings &&imports, std::vector<U8> &objectCode,
+                                      bool *outCompiled) {
+        return instantiateModule(module, std::move(imports), &objectCode, outCompiled);
+    }
+
+    void compileModule(const IR::Module &module, std::vector<U8> &outObjectCode) {
+        LLVMJIT::compileModule(module, outObjectCode);
+    }
+
+    std::string getObjectCodeVersion() { return LLVMJIT::getObjectCodeVersion(); }
+
     ModuleInstance::~ModuleInstance() {
         delete jitModule;
     }
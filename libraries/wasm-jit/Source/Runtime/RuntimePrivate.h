@@ -19,7 +19,17 @@ namespace LLVMJIT {
 
     void init();
 
-    void instantiateModule(const IR::Module &module, Runtime::ModuleInstance *moduleInstance);
+    // Generates machine code for a module instance. If objectCode is non-null and not empty, it's loaded instead of
+    // compiling the module, unless it doesn't match the module. Whenever the module is compiled, its object code is
+    // stored in objectCode. Returns true if the module was compiled.
+    bool instantiateModule(const IR::Module &module, Runtime::ModuleInstance *moduleInstance,
+                           std::vector<U8> *objectCode = nullptr);
+
+    // Generates the object code of a module without instantiating it. It doesn't touch any runtime object, so it may
+    // run on another thread than the one instantiating and executing modules.
+    void compileModule(const IR::Module &module, std::vector<U8> &outObjectCode);
+
+    std::string getObjectCodeVersion();
 
     bool describeInstructionPointer(Uptr ip, std::string &outDescription);
 
@@ -88,9 +98,12 @@ namespace Runtime {
         U8 *reservedBaseAddress;
         Uptr reservedNumPlatformPages;
 
+        // The number of pages at the start of the memory that the last restored snapshot was mapped to.
+        Uptr numSnapshotPages;
+
         MemoryInstance(const MemoryType &inType) : GCObject(ObjectKind::memory), type(inType), baseAddress(nullptr),
                                                    numPages(0), endOffset(0), reservedBaseAddress(nullptr),
-                                                   reservedNumPlatformPages(0) {}
+                                                   reservedNumPlatformPages(0), numSnapshotPages(0) {}
 
         ~MemoryInstance() override;
 
@@ -146,6 +159,12 @@ namespace Runtime {
 
     bool isAddressOwnedByMemory(U8 *address);
 
+    // The address space reserved for a memory or table, which compiled code bounds checks accesses against. It's the
+    // same for every instance, so code can be compiled before the instance it runs in exists.
+    Uptr getMemoryMaxBytes();
+
+    Uptr getTableMaxBytes();
+
     // Allocates virtual pages with alignBytes of padding, and returns an aligned base address.
     // The unaligned allocation address and size are written to outUnalignedBaseAddress and outUnalignedNumPlatformPages.
     U8 *allocateVirtualPagesAligned(Uptr numBytes, Uptr alignmentBytes, U8 *&outUnalignedBaseAddress,
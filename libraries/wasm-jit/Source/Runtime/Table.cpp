@@ -12,11 +12,14 @@ namespace Runtime {
         return (numBytes + (Uptr(1) << Platform::getPageSizeLog2()) - 1) >> Platform::getPageSizeLog2();
     }
 
+    Uptr getTableMaxBytes() {
+        return sizeof(TableInstance::FunctionElement) * eosio::chain::wasm_constraints::maximum_table_elements;
+    }
+
     TableInstance *createTable(TableType type) {
         TableInstance *table = new TableInstance(type);
 
-        const Uptr tableMaxBytes =
-                sizeof(TableInstance::FunctionElement) * eosio::chain::wasm_constraints::maximum_table_elements;
+        const Uptr tableMaxBytes = getTableMaxBytes();
 
         const Uptr alignmentBytes = 1U << Platform::getPageSizeLog2();
         table->baseAddress = (TableInstance::FunctionElement *) allocateVirtualPagesAligned(tableMaxBytes,
@@ -116,6 +116,8 @@ namespace eosio {
                                      CHAIN_RO_CALL(avail_check, 200),
                                      CHAIN_RO_CALL(serialize_json, 200),
                                      CHAIN_RO_CALL(get_pub_address, 200),
+                                     CHAIN_RO_CALL(get_pub_addresses, 200),
+                                     CHAIN_RO_CALL(get_fio_names_batch, 200),
                                      CHAIN_RO_CALL(get_pending_fio_requests, 200),
                                      CHAIN_RO_CALL(get_cancelled_fio_requests, 200),
                                      CHAIN_RO_CALL(get_obt_data, 200),
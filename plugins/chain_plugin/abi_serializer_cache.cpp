@@ -0,0 +1,95 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+#include <eosio/chain/account_object.hpp>
+#include <eosio/chain/contract_types.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <algorithm>
+
+namespace eosio {
+    namespace chain_apis {
+
+        using namespace eosio::chain;
+
+        abi_serializer_cache::abi_serializer_cache(uint32_t max_entries) : max_entries(std::max<uint32_t>(max_entries, 1)) {}
+
+        cached_abi_ptr abi_serializer_cache::get(const controller &db, const account_name &account,
+                                                 const fc::microseconds &max_serialization_time) {
+            const auto &d = db.db();
+            const account_object *code_accnt = d.find<account_object, by_name>(account);
+            EOS_ASSERT(code_accnt != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}",
+                       ("account", account));
+            const auto &code_meta = d.get<account_metadata_object, by_name>(account);
+
+            {
+                std::lock_guard<std::mutex> g(mtx);
+                auto itr = entries.find(account);
+                if (itr != entries.end() && itr->second.abi_sequence == code_meta.abi_sequence) {
+                    lru.splice(lru.begin(), lru, itr->second.lru_pos);
+                    ++hits;
+                    return itr->second.abi;
+                }
+            }
+
+            ++misses;
+            // parse outside the lock, a concurrent miss on the same account only costs a duplicate parse
+            abi_def abi;
+            abi_serializer::to_abi(code_accnt->abi, abi);
+            auto abi_hash = fc::sha256::hash(code_accnt->abi.data(), code_accnt->abi.size());
+            auto result = std::make_shared<const cached_abi>(std::move(abi), abi_hash, max_serialization_time);
+
+            std::lock_guard<std::mutex> g(mtx);
+            auto itr = entries.find(account);
+            if (itr == entries.end()) {
+                if (entries.size() >= max_entries) {
+                    erase(entries.find(lru.back()));
+                    ++evictions;
+                }
+                lru.push_front(account);
+                itr = entries.emplace(account, entry{0, nullptr, lru.begin()}).first;
+            } else {
+                lru.splice(lru.begin(), lru, itr->second.lru_pos);
+            }
+            itr->second.abi_sequence = code_meta.abi_sequence;
+            itr->second.abi = result;
+            return result;
+        }
+
+        void abi_serializer_cache::on_applied_transaction(const transaction_trace &trace) {
+            for (const auto &at : trace.action_traces) {
+                if (at.receiver != config::system_account_name || at.act.account != config::system_account_name ||
+                    at.act.name != setabi::get_name())
+                    continue;
+                account_name account;
+                try {
+                    account = at.act.data_as<setabi>().account;
+                } catch (const fc::exception &) {
+                    continue; // malformed, the setabi failed without touching the account
+                }
+                std::lock_guard<std::mutex> g(mtx);
+                auto itr = entries.find(account);
+                if (itr != entries.end())
+                    erase(itr);
+            }
+        }
+
+        abi_serializer_cache_stats abi_serializer_cache::get_stats() const {
+            abi_serializer_cache_stats stats;
+            stats.hits = hits;
+            stats.misses = misses;
+            stats.evictions = evictions;
+            std::lock_guard<std::mutex> g(mtx);
+            stats.entries = entries.size();
+            return stats;
+        }
+
+        void abi_serializer_cache::erase(std::map<account_name, entry>::iterator itr) {
+            lru.erase(itr->second.lru_pos);
+            entries.erase(itr);
+        }
+
+    }
+} // eosio::chain_apis
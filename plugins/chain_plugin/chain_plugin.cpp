@@ -14,6 +14,7 @@
 #include <eosio/chain/wasm_interface.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/reversible_block_object.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
 #include <eosio/chain/snapshot.hpp>
@@ -170,6 +171,8 @@ namespace eosio {
         fc::optional<vm_type> wasm_runtime;
         fc::microseconds abi_serializer_max_time_ms;
         fc::optional<bfs::path> snapshot_path;
+        std::shared_ptr<chain_apis::abi_serializer_cache> abi_cache = std::make_shared<chain_apis::abi_serializer_cache>();
+        std::shared_ptr<chain_apis::fio_request_index> fio_requests;
 
 
         // retained references to channels for easy publication
@@ -220,9 +223,14 @@ namespace eosio {
                  "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
                 ("wasm-runtime", bpo::value<eosio::chain::wasm_interface::vm_type>()->value_name("wavm/wabt"),
                  "Override default WASM runtime")
+                ("wasm-cache-dir", bpo::value<bfs::path>()->default_value(config::default_wasm_cache_dir_name),
+                 "the location of the persistent cache of contracts compiled by the wavm runtime (absolute path or relative to application data dir), empty to disable it")
                 ("abi-serializer-max-time-ms",
                  bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_ms),
                  "Override default maximum ABI serialization time allowed in ms")
+                ("abi-serializer-cache-size",
+                 bpo::value<uint32_t>()->default_value(chain_apis::abi_serializer_cache::default_max_entries),
+                 "Maximum number of contract ABIs the chain API keeps parsed, the least recently used is dropped first")
                 ("chain-state-db-size-mb",
                  bpo::value<uint64_t>()->default_value(config::default_state_size / (1024 * 1024)),
                  "Maximum size (in MiB) of the chain state database")
@@ -256,8 +264,15 @@ namespace eosio {
                 ("signature-cpu-billable-pct",
                  bpo::value<uint32_t>()->default_value(config::default_sig_cpu_bill_pct / config::percent_1),
                  "Percentage of actual signature recovery cpu to bill. Whole number percentages, e.g. 50 for 50%")
+                ("signature-cache-size",
+                 bpo::value<uint32_t>()->default_value(signature_recovery_cache::default_capacity),
+                 "Number of recovered transaction signature keys kept so a transaction seen again is not recovered again, 0 to disable")
                 ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
                  "Number of worker threads in controller thread pool")
+                ("replay-threads", bpo::value<uint16_t>()->default_value(config::default_replay_threads),
+                 "Number of threads unpacking blocks and recovering keys while replaying the block log")
+                ("replay-pipeline-depth", bpo::value<uint32_t>()->default_value(config::default_replay_pipeline_depth),
+                 "Maximum number of blocks read ahead of the block being applied while replaying the block log")
                 ("contracts-console", bpo::bool_switch()->default_value(false),
                  "print contract's output to console")
                 ("actor-whitelist", boost::program_options::value<vector<string>>()->composing()->multitoken(),
@@ -699,6 +714,10 @@ if( options.count(name) ) { \
                 my->abi_serializer_max_time_ms = fc::microseconds(
                         options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
 
+            if (options.count("abi-serializer-cache-size"))
+                my->abi_cache = std::make_shared<chain_apis::abi_serializer_cache>(
+                        options.at("abi-serializer-cache-size").as<uint32_t>());
+
             my->chain_config->blocks_dir = my->blocks_dir;
             my->chain_config->state_dir = app().data_dir() / config::default_state_dir_name;
             my->chain_config->read_only = my->readonly;
@@ -756,6 +775,19 @@ if( options.count(name) ) { \
                            "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size));
             }
 
+            if (options.count("replay-threads")) {
+                my->chain_config->replay_threads = options.at("replay-threads").as<uint16_t>();
+                EOS_ASSERT(my->chain_config->replay_threads > 0, plugin_config_exception,
+                           "replay-threads ${num} must be greater than 0", ("num", my->chain_config->replay_threads));
+            }
+
+            if (options.count("replay-pipeline-depth")) {
+                my->chain_config->replay_pipeline_depth = options.at("replay-pipeline-depth").as<uint32_t>();
+                EOS_ASSERT(my->chain_config->replay_pipeline_depth > 0, plugin_config_exception,
+                           "replay-pipeline-depth ${num} must be greater than 0",
+                           ("num", my->chain_config->replay_pipeline_depth));
+            }
+
             my->chain_config->sig_cpu_bill_pct = options.at("signature-cpu-billable-pct").as<uint32_t>();
             EOS_ASSERT(my->chain_config->sig_cpu_bill_pct >= 0 && my->chain_config->sig_cpu_bill_pct <= 100,
                        plugin_config_exception,
@@ -763,9 +795,19 @@ if( options.count(name) ) { \
                        ("pct", my->chain_config->sig_cpu_bill_pct));
             my->chain_config->sig_cpu_bill_pct *= config::percent_1;
 
+            signature_recovery_cache::shared().set_capacity(options.at("signature-cache-size").as<uint32_t>());
+
             if (my->wasm_runtime)
                 my->chain_config->wasm_runtime = *my->wasm_runtime;
 
+            if (options.count("wasm-cache-dir")) {
+                auto wcd = options.at("wasm-cache-dir").as<bfs::path>();
+                if (wcd.empty() || wcd.is_absolute())
+                    my->chain_config->wasm_cache_dir = wcd;
+                else
+                    my->chain_config->wasm_cache_dir = app().data_dir() / wcd;
+            }
+
             my->chain_config->force_all_checks = options.at("force-all-checks").as<bool>();
             my->chain_config->disable_replay_opts = options.at("disable-replay-opts").as<bool>();
             my->chain_config->contracts_console = options.at("contracts-console").as<bool>();
@@ -1040,7 +1082,11 @@ if( options.count(name) ) { \
                         my->accepted_block_header_channel.publish(priority::medium, blk);
                     });
 
+            my->fio_requests = std::make_shared<chain_apis::fio_request_index>(my->abi_cache,
+                                                                               my->abi_serializer_max_time_ms);
+
             my->accepted_block_connection = my->chain->accepted_block.connect([this](const block_state_ptr &blk) {
+                my->fio_requests->on_accepted_block(*my->chain, blk);
                 my->accepted_block_channel.publish(priority::high, blk);
             });
 
@@ -1056,6 +1102,7 @@ if( options.count(name) ) { \
 
             my->applied_transaction_connection = my->chain->applied_transaction.connect(
                     [this](std::tuple<const transaction_trace_ptr &, const signed_transaction &> t) {
+                        my->abi_cache->on_applied_transaction(*std::get<0>(t));
                         my->applied_transaction_channel.publish(priority::low, std::get<0>(t));
                     });
 
@@ -1083,6 +1130,8 @@ if( options.count(name) ) { \
                 throw;
             }
 
+            my->fio_requests->rebuild(*my->chain);
+
             if (!my->readonly) {
                 ilog("starting chain in read/write mode");
             }
@@ -1354,6 +1403,14 @@ if( options.count(name) ) { \
         return my->abi_serializer_max_time_ms;
     }
 
+    std::shared_ptr<chain_apis::abi_serializer_cache> chain_plugin::get_abi_serializer_cache() const {
+        return my->abi_cache;
+    }
+
+    std::shared_ptr<const chain_apis::fio_request_index> chain_plugin::get_fio_request_index() const {
+        return my->fio_requests;
+    }
+
     void chain_plugin::log_guard_exception(const chain::guard_exception &e) {
         if (e.code() == chain::database_guard_exception::code_value) {
             elog("Database has reached an unsafe level of usage, shutting down to avoid corrupting the database.  "
@@ -1607,12 +1664,12 @@ if( options.count(name) ) { \
 //*******************BEGIN FIO API
 
         const name fio_system_code = N(fio.address);    // FIO name contract account, init in the top of this class
-        const string fio_system_scope = "fio.address";   // FIO name contract scope
+        const name fio_system_scope = N(fio.address);   // FIO name contract scope
         const name fio_reqobt_code = N(
                 fio.reqobt);    // FIO request obt contract account, init in the top of this class
-        const string fio_reqobt_scope = "fio.reqobt";   // FIO request obt contract scope
+        const name fio_reqobt_scope = N(fio.reqobt);   // FIO request obt contract scope
         const name fio_fee_code = N(fio.fee);    // FIO fee account, init in the top of this class
-        const string fio_fee_scope = "fio.fee";   // FIO fee contract scope
+        const name fio_fee_scope = N(fio.fee);   // FIO fee contract scope
         const name fio_whitelst_code = N(fio.whitelst);    // FIO whitelst account, init in the top of this class
         const string fio_whitelst_scope = "fio.whitelst";   // FIO whitelst contract scope
 
@@ -1623,9 +1680,48 @@ if( options.count(name) ) { \
         const name fio_domains_table = N(domains); // FIO Domains Table
         const name fio_chains_table = N(chains); // FIO Chains Table
         const name fio_accounts_table = N(accountmap); // FIO Chains Table
+        const name fio_requests_table = N(fioreqctxts); // FIO Requests Table
+        const name fio_request_status_table = N(fioreqstss); // FIO Request Status Table
+        const name fio_obt_table = N(recordobts); // FIO OBT Records Table
 
         const uint16_t FEEMAXLENGTH = 32;
         const uint16_t FIOPUBLICKEYLENGTH = 53;
+        const uint16_t BATCHMAXITEMS = 1000;
+
+        static string fio_request_time(uint64_t time_stamp) {
+            time_t temptime = time_stamp;
+            char buffer[80];
+            strftime(buffer, 80, "%Y-%m-%dT%T", gmtime(&temptime));
+            return buffer;
+        }
+
+        static string fio_request_status(uint8_t status) {
+            switch (status) {
+                case 1:
+                    return "rejected";
+                case 2:
+                    return "sent_to_blockchain";
+                case 3:
+                    return "cancelled";
+                default:
+                    return "requested";
+            }
+        }
+
+        /**
+         * Hashes of the fio addresses in names_rows_result, 404 if there are none.
+         */
+        static vector<uint128_t> fio_request_addresses(const vector<fio_rows::fioname> &names_rows_result) {
+            FIO_404_ASSERT(!names_rows_result.empty(), "No FIO Requests",
+                           fioio::ErrorNoFioRequestsFound);
+
+            vector<uint128_t> addresses;
+            addresses.reserve(names_rows_result.size());
+            for (const auto &n : names_rows_result) {
+                addresses.push_back(fioio::string_to_uint128_t(n.name.c_str()));
+            }
+            return addresses;
+        }
 
         /***
         * get pending fio requests.
@@ -1646,158 +1742,55 @@ if( options.count(name) ) { \
                            fioio::ErrorPagingInvalid);
 
             string account_name;
-
-            uint32_t search_results = 0;
-            uint32_t search_limit = p.limit;
-            uint32_t search_offset = p.offset;
-            uint32_t returnCount = 0;
-            uint32_t search_notFound = 0;
-            bool search_finished = false;
-
             fioio::key_to_account(fioKey, account_name);
-
             name account = name{account_name};
+
             get_pending_fio_requests_result result;
 
-            const abi_def system_abi = eosio::chain_apis::get_abi(db, fio_system_code);
-            const abi_def reqobt_abi = eosio::chain_apis::get_abi(db, fio_reqobt_code);
+            const auto system_abi = get_cached_abi(fio_system_code);
+            const auto reqobt_abi = get_cached_abi(fio_reqobt_code);
 
-            get_table_rows_params table_row_params = get_table_rows_params{
-                    .json        = true,
-                    .code        = fio_system_code,
-                    .scope       = fio_system_scope,
-                    .table       = fio_address_table,
-                    .lower_bound = boost::lexical_cast<string>(account.value),
-                    .upper_bound = boost::lexical_cast<string>(account.value),
-                    .key_type       = "i64",
-                    .index_position = "4"};
+            auto names_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value, *system_abi);
 
-            get_table_rows_result names_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, system_abi, [](uint64_t v) -> uint64_t {
-                        return v;
-                    });
+            // requests where one of our addresses is the payer and that have no status yet
+            vector<fio_request_index::range> ranges;
+            for (const auto &address : fio_request_addresses(names_rows_result)) {
+                ranges.push_back({fio_request_index::range::payer_requests, address, fio_request_index::no_status});
+            }
 
-            FIO_404_ASSERT(!names_rows_result.rows.empty(), "No FIO Requests",
-                           fioio::ErrorNoFioRequestsFound);
+            auto page = fio_requests->get_page(ranges, p.offset, p.limit);
+            for (const auto &r : page.refs) {
+                auto request = get_fio_row<fio_rows::fioreqctxt>(fio_reqobt_code, fio_reqobt_scope,
+                                                                 fio_requests_table, r.id, *reqobt_abi);
+                if (!request) continue;
+
+                // the payer is the one of our addresses the request was found under
+                string from_fioadd;
+                for (const auto &n : names_rows_result) {
+                    if (fioio::string_to_uint128_t(n.name.c_str()) == request->payer_fio_address) {
+                        from_fioadd = n.name;
+                        break;
+                    }
+                }
 
-            for (size_t knpos = 0; knpos < names_rows_result.rows.size(); knpos++) {
-                string fio_address = (string) names_rows_result.rows[knpos]["name"].as_string();
-                string from_fioadd = fio_address;
-                uint128_t address_hash = fioio::string_to_uint128_t(fio_address.c_str());
-                string fio_requests_lookup_table = "fioreqctxts";   // table name
-
-                std::string hexvalnamehash = "0x";
-                //now get the hex little-endian and search
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&address_hash),
-                                                    sizeof(address_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_requests_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position = "2"};
-
-                get_table_rows_result requests_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
+                // Do secondary key lookup
+                auto fioname_result = get_fio_rows_by_seckey<fio_rows::fioname, index128_index>(
+                        fio_system_code, fio_system_scope, fio_address_table, 5,
+                        request->payee_fio_address, *system_abi, 1);
 
-                //for each request look to see if there are associated statuses
-                //query the fioreqstss table by the fioreqid, if there is a match then take these
-                //out of the results, otherwise include in the results.
-                // Look through the keynames lookup results and push the fio_addresses into results
-                if (search_offset < requests_rows_result.rows.size() && !search_finished) {
-                    for (size_t pos = 0 + search_offset; pos < requests_rows_result.rows.size(); pos++) {
-                        //get all the attributes of the fio request
-                        uint64_t fio_request_id = requests_rows_result.rows[pos]["fio_request_id"].as_uint64();
-                        string payee_fio_address = requests_rows_result.rows[pos]["payee_fio_address_hex_str"].as_string();
-                        string payee_fio_addr = requests_rows_result.rows[pos]["payee_fio_addr"].as_string();
-                        string content = requests_rows_result.rows[pos]["content"].as_string();
-                        uint64_t time_stamp = requests_rows_result.rows[pos]["time_stamp"].as_uint64();
-                        string payer_fio_public_key = requests_rows_result.rows[pos]["payer_key"].as_string();
-                        string payee_fio_public_key = requests_rows_result.rows[pos]["payee_key"].as_string();
-
-                        get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                                .code=fio_system_code,
-                                .scope=fio_system_scope,
-                                .table=fio_address_table,
-                                .lower_bound=payee_fio_address,
-                                .upper_bound=payee_fio_address,
-                                .encode_type="hex",
-                                .index_position ="5"};
-
-                        // Do secondary key lookup
-                        get_table_rows_result fioname_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                                name_table_row_params, system_abi, [](uint128_t v) -> uint128_t {
-                                    return v;
-                                });
-
-                        FIO_404_ASSERT(!fioname_result.rows.empty(), "No pending FIO Requests",
-                                       fioio::ErrorNoFioRequestsFound);
-
-                        string to_fioadd = fioname_result.rows[0]["name"].as_string();
-                        name account = name{fioname_result.rows[0]["owner_account"].as_string()};
-
-                        //convert the time_stamp to string formatted time.
-                        time_t temptime;
-                        struct tm *timeinfo;
-                        char buffer[80];
-
-                        temptime = time_stamp;
-                        timeinfo = gmtime(&temptime);
-                        strftime(buffer, 80, "%Y-%m-%dT%T", timeinfo);
+                FIO_404_ASSERT(!fioname_result.empty(), "No pending FIO Requests",
+                               fioio::ErrorNoFioRequestsFound);
 
-                        request_record rr{fio_request_id, from_fioadd,
-                                          to_fioadd, payer_fio_public_key, payee_fio_public_key, content, buffer};
-
-                        string fio_request_status_lookup_table = "fioreqstss";   // table name
-
-                        get_table_rows_params request_status_row_params = get_table_rows_params{
-                                .json        = true,
-                                .code        = fio_reqobt_code,
-                                .scope       = fio_reqobt_scope,
-                                .table       = fio_request_status_lookup_table,
-                                .lower_bound = boost::lexical_cast<string>(fio_request_id),
-                                .upper_bound = boost::lexical_cast<string>(fio_request_id),
-                                .key_type       = "i64",
-                                .index_position = "2"};
-
-                        get_table_rows_result request_status_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                                request_status_row_params, reqobt_abi, [](uint64_t v) -> uint64_t {
-                                    return v;
-                                });
-
-                        //if there are no statuses for this record then add it to the results
-                        if (request_status_rows_result.rows.empty()) {
-                            result.requests.push_back(rr);
-                            returnCount++;
-                            if (search_offset > 0) { search_offset--; }
-
-                            if (returnCount == search_limit && search_limit != 0) {
-                                search_results = requests_rows_result.rows.size() - (pos + 1 + search_notFound);
-                                search_finished = true;
-                                break;
-                            }
-                        } else {
-                            search_notFound++;
-                        }
-                    }
-                } else if (search_finished) {
-                    search_results += requests_rows_result.rows.size();
-                } else {
-                    if (search_offset > 0) {
-                        search_offset -= requests_rows_result.rows.size(); //set 0
-                    }
-                }
-            } // Get request statuses
+                string to_fioadd = fioname_result[0].name;
+
+                result.requests.push_back(request_record{request->fio_request_id, from_fioadd, to_fioadd,
+                                                         request->payer_key, request->payee_key, request->content,
+                                                         fio_request_time(request->time_stamp)});
+            }
 
             FIO_404_ASSERT(!(result.requests.size() == 0), "No pending FIO Requests", fioio::ErrorNoFioRequestsFound);
-            result.more = search_results;
+            result.more = page.more;
             return result;
         } // get_pending_fio_requests
 
@@ -1814,41 +1807,37 @@ if( options.count(name) ) { \
 
             get_actions_result results;
 
-            const auto &idx = db.db().get_index<fioaction_index,by_id>();
+            // actions are listed newest first. A cursor is the id of the next action to return.
+            const auto &idx = db.db().get_index<fioaction_index, by_id>();
             auto itr = idx.rbegin();
 
-            int count = 0;
-            if (p.offset > 0){
-                while ((itr != idx.rend()) && (count < p.offset)){
-                    itr++;
-                    count++;
-                }
-            }
+            if (!p.cursor.empty()) {
+                uint64_t next_id = 0;
+                bool valid = false;
+                try {
+                    next_id = boost::lexical_cast<uint64_t>(p.cursor);
+                    // only ids of existing actions are handed out, later ones can't come from a previous call
+                    valid = !idx.empty() && next_id <= idx.rbegin()->id._id;
+                } catch (const boost::bad_lexical_cast &) {}
+                FIO_400_ASSERT(valid, "cursor", p.cursor, "Invalid cursor", fioio::ErrorPagingInvalid);
 
-            count = 0;
-            while ((itr != idx.rend())){
-                if (count == p.limit && p.limit != 0){
-                    break;
-                }
-                string action = itr->actionname.to_string();
-                string contract = itr->contractname;
-                string timestamp = to_string(itr->blocktimestamp);
-
-                action_record rr{action, contract, timestamp};
-                results.actions.push_back(rr);
-                itr++;
-                count++;
+                itr = decltype(itr)(idx.upper_bound(fioaction_id_type(next_id)));
+            } else {
+                for (int32_t count = 0; itr != idx.rend() && count < p.offset; ++itr, ++count);
             }
 
-            count = 0;
-            while ((itr != idx.rend())){
-                itr++;
-                count++;
+            for (; itr != idx.rend() && (p.limit == 0 || results.actions.size() < static_cast<uint32_t>(p.limit)); ++itr) {
+                results.actions.push_back(action_record{itr->actionname.to_string(), itr->contractname,
+                                                        to_string(itr->blocktimestamp)});
             }
 
-
             FIO_404_ASSERT(!(results.actions.size() == 0), "No actions", fioio::ErrorNoFioActionsFound);
-            results.more = count;
+
+            // counted from the rows left after the last one returned, the registry only holds a few dozen actions
+            results.more = static_cast<uint32_t>(std::distance(itr, idx.rend()));
+            if (itr != idx.rend()) {
+                results.next_cursor = std::to_string(itr->id._id);
+            }
             return results;
         } // get_actions
 
@@ -1872,151 +1861,38 @@ if( options.count(name) ) { \
                            fioio::ErrorPagingInvalid);
 
             string account_name;
-
-            uint32_t search_results = 0;
-            uint32_t search_limit = p.limit;
-            uint32_t search_offset = p.offset;
-            uint32_t returnCount = 0;
-            bool search_finished = false;
-
             fioio::key_to_account(fioKey, account_name);
-
             name account = name{account_name};
-            get_cancelled_fio_requests_result result;
-
-            const abi_def system_abi = eosio::chain_apis::get_abi(db, fio_system_code);
-            const abi_def reqobt_abi = eosio::chain_apis::get_abi(db, fio_reqobt_code);
-
-            get_table_rows_params table_row_params = get_table_rows_params{
-                    .json        = true,
-                    .code        = fio_system_code,
-                    .scope       = fio_system_scope,
-                    .table       = fio_address_table,
-                    .lower_bound = boost::lexical_cast<string>(account.value),
-                    .upper_bound = boost::lexical_cast<string>(account.value),
-                    .key_type       = "i64",
-                    .index_position = "4"};
-
-            get_table_rows_result names_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, system_abi, [](uint64_t v) -> uint64_t {
-                        return v;
-                    });
-
-            FIO_404_ASSERT(!names_rows_result.rows.empty(), "No FIO Requests",
-                           fioio::ErrorNoFioRequestsFound);
-
-            for (size_t knpos = 0; knpos < names_rows_result.rows.size(); knpos++) {
-                string fio_address = names_rows_result.rows[knpos]["name"].as_string();
-                string to_fioadd = fio_address;
-                uint128_t address_hash = fioio::string_to_uint128_t(fio_address.c_str());
-                string fio_requests_lookup_table = "fioreqctxts";   // table name
-
-                std::string hexvalnamehash = "0x";
-                //now get the hex little-endian and search
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&address_hash),
-                                                    sizeof(address_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_requests_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="3"};
-
-                get_table_rows_result requests_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
-
-                if (search_offset < requests_rows_result.rows.size() && !search_finished) {
-                    for (size_t pos = 0 + search_offset; pos < requests_rows_result.rows.size(); pos++) {
-                        //get all the attributes of the fio request
-                        uint64_t fio_request_id = requests_rows_result.rows[pos]["fio_request_id"].as_uint64();
-                        string payer_address = requests_rows_result.rows[pos]["payer_fio_addr"].as_string();
-                        string payee_address = requests_rows_result.rows[pos]["payee_fio_addr"].as_string();
-                        string content = requests_rows_result.rows[pos]["content"].as_string();
-                        uint64_t time_stamp = requests_rows_result.rows[pos]["time_stamp"].as_uint64();
-                        string payer_fio_public_key = requests_rows_result.rows[pos]["payer_key"].as_string();
-                        string payee_fio_public_key = requests_rows_result.rows[pos]["payee_key"].as_string();
-
-                        //query the statuses
-                        //use this id and query the fioreqstss table for status updates to this fioreqid
-                        //look up the requests for this fio name (look for matches in the tofioadd
-                        string fio_request_status_lookup_table = "fioreqstss";   // table name
-                        get_table_rows_params request_status_row_params = get_table_rows_params{
-                                .json        = true,
-                                .code        = fio_reqobt_code,
-                                .scope       = fio_reqobt_scope,
-                                .table       = fio_request_status_lookup_table,
-                                .lower_bound = boost::lexical_cast<string>(fio_request_id),
-                                .upper_bound = boost::lexical_cast<string>(fio_request_id),
-                                .key_type       = "i64",
-                                .index_position = "2"};
-                        // Do secondary key lookup
-                        get_table_rows_result request_status_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                                request_status_row_params, reqobt_abi, [](uint64_t v) -> uint64_t {
-                                    return v;
-                                });
-
-                        string status = "requested";
-
-                        if (!(request_status_rows_result.rows.empty())) {
-                            for (size_t rw = 0; rw < request_status_rows_result.rows.size(); rw++) {
-                                uint64_t reqid = request_status_rows_result.rows[rw]["fio_request_id"].as_uint64();
-                                uint64_t statusintV = request_status_rows_result.rows[rw]["status"].as_uint64();
-
-                                if (reqid == fio_request_id) {
-
-                                    if (statusintV == 3) {
-                                        status = "cancelled";
-                                    }
-                                    break; //exit the loop after finding the first.
-
-                                }
-                            }
-                        }
-
-                        if (status == "cancelled") {
-                            //convert the time_stamp to string formatted time.
-                            time_t temptime;
-                            struct tm *timeinfo;
-                            char buffer[80];
 
-                            temptime = time_stamp;
-                            timeinfo = gmtime(&temptime);
-                            strftime(buffer, 80, "%Y-%m-%dT%T", timeinfo);
-
-                            request_status_record rr{fio_request_id, payer_address, payee_address, payer_fio_public_key,
-                                                     payee_fio_public_key, content, buffer, status};
+            get_cancelled_fio_requests_result result;
 
-                            result.requests.push_back(rr);
-                        }
+            const auto system_abi = get_cached_abi(fio_system_code);
+            const auto reqobt_abi = get_cached_abi(fio_reqobt_code);
 
-                        returnCount++;
-                        if (search_offset > 0) { search_offset--; }
+            auto names_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value, *system_abi);
 
-                        if (returnCount == search_limit && search_limit != 0) {
-                            search_results = requests_rows_result.rows.size() - (pos + 1);
-                            search_finished = true;
-                            break;
-                        }
+            // requests made by one of our addresses whose first status is cancelled
+            vector<fio_request_index::range> ranges;
+            for (const auto &address : fio_request_addresses(names_rows_result)) {
+                ranges.push_back({fio_request_index::range::payee_requests, address, uint8_t(3)});
+            }
 
-                    } // Get request statuses
-                } else if (search_finished) {
-                    search_results += requests_rows_result.rows.size();
-                } else {
-                    if (search_offset > 0) {
-                        search_offset -= requests_rows_result.rows.size(); //set 0
-                    }
-                }
+            auto page = fio_requests->get_page(ranges, p.offset, p.limit);
+            for (const auto &r : page.refs) {
+                auto request = get_fio_row<fio_rows::fioreqctxt>(fio_reqobt_code, fio_reqobt_scope,
+                                                                 fio_requests_table, r.id, *reqobt_abi);
+                if (!request) continue;
+
+                result.requests.push_back(request_status_record{request->fio_request_id, request->payer_fio_addr,
+                                                                request->payee_fio_addr, request->payer_key,
+                                                                request->payee_key, request->content,
+                                                                fio_request_time(request->time_stamp),
+                                                                fio_request_status(r.status)});
             }
 
             FIO_404_ASSERT(!(result.requests.size() == 0), "No FIO Requests", fioio::ErrorNoFioRequestsFound);
-            result.more = search_results;
+            result.more = page.more;
             return result;
         }
 
@@ -2042,152 +1918,38 @@ if( options.count(name) ) { \
                            fioio::ErrorPagingInvalid);
 
             string account_name;
-
-            uint32_t search_results = 0;
-            uint32_t search_limit = p.limit;
-            uint32_t search_offset = p.offset;
-            uint32_t returnCount = 0;
-            bool search_finished = false;
-
             fioio::key_to_account(fioKey, account_name);
-
             name account = name{account_name};
-            get_sent_fio_requests_result result;
-
-            const abi_def system_abi = eosio::chain_apis::get_abi(db, fio_system_code);
-            const abi_def reqobt_abi = eosio::chain_apis::get_abi(db, fio_reqobt_code);
-
-            get_table_rows_params table_row_params = get_table_rows_params{
-                    .json        = true,
-                    .code        = fio_system_code,
-                    .scope       = fio_system_scope,
-                    .table       = fio_address_table,
-                    .lower_bound = boost::lexical_cast<string>(account.value),
-                    .upper_bound = boost::lexical_cast<string>(account.value),
-                    .key_type       = "i64",
-                    .index_position = "4"};
-
-            get_table_rows_result names_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, system_abi, [](uint64_t v) -> uint64_t {
-                        return v;
-                    });
-
-            FIO_404_ASSERT(!names_rows_result.rows.empty(), "No FIO Requests",
-                           fioio::ErrorNoFioRequestsFound);
-
-            for (size_t knpos = 0; knpos < names_rows_result.rows.size(); knpos++) {
-                string fio_address = names_rows_result.rows[knpos]["name"].as_string();
-                string to_fioadd = fio_address;
-                uint128_t address_hash = fioio::string_to_uint128_t(fio_address.c_str());
-                string fio_requests_lookup_table = "fioreqctxts";   // table name
-
-                std::string hexvalnamehash = "0x";
-                //now get the hex little-endian and search
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&address_hash),
-                                                    sizeof(address_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_requests_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="3"};
-
-                get_table_rows_result requests_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
 
-                if (search_offset < requests_rows_result.rows.size() && !search_finished) {
-                    for (size_t pos = 0 + search_offset; pos < requests_rows_result.rows.size(); pos++) {
-                        //get all the attributes of the fio request
-                        uint64_t fio_request_id = requests_rows_result.rows[pos]["fio_request_id"].as_uint64();
-                        string payer_address = requests_rows_result.rows[pos]["payer_fio_addr"].as_string();
-                        string payee_address = requests_rows_result.rows[pos]["payee_fio_addr"].as_string();
-                        string content = requests_rows_result.rows[pos]["content"].as_string();
-                        uint64_t time_stamp = requests_rows_result.rows[pos]["time_stamp"].as_uint64();
-                        string payer_fio_public_key = requests_rows_result.rows[pos]["payer_key"].as_string();
-                        string payee_fio_public_key = requests_rows_result.rows[pos]["payee_key"].as_string();
-
-                        //query the statuses
-                        //use this id and query the fioreqstss table for status updates to this fioreqid
-                        //look up the requests for this fio name (look for matches in the tofioadd
-                        string fio_request_status_lookup_table = "fioreqstss";   // table name
-                        get_table_rows_params request_status_row_params = get_table_rows_params{
-                                .json        = true,
-                                .code        = fio_reqobt_code,
-                                .scope       = fio_reqobt_scope,
-                                .table       = fio_request_status_lookup_table,
-                                .lower_bound = boost::lexical_cast<string>(fio_request_id),
-                                .upper_bound = boost::lexical_cast<string>(fio_request_id),
-                                .key_type       = "i64",
-                                .index_position = "2"};
-                        // Do secondary key lookup
-                        get_table_rows_result request_status_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                                request_status_row_params, reqobt_abi, [](uint64_t v) -> uint64_t {
-                                    return v;
-                                });
-
-                        string status = "requested";
-
-                        if (!(request_status_rows_result.rows.empty())) {
-                            for (size_t rw = 0; rw < request_status_rows_result.rows.size(); rw++) {
-                                uint64_t reqid = request_status_rows_result.rows[rw]["fio_request_id"].as_uint64();
-                                uint64_t statusintV = request_status_rows_result.rows[rw]["status"].as_uint64();
-
-                                if (reqid == fio_request_id) {
-
-                                    if (statusintV == 0) {
-                                        status = "requested";
-                                    } else if (statusintV == 1) {
-                                        status = "rejected";
-                                    } else if (statusintV == 2) {
-                                        status = "sent_to_blockchain";
-                                    }else if (statusintV == 3) {
-                                        status = "cancelled";
-                                    }
-                                    break; //exit the loop after finding the first.
-
-                                }
-                            }
-                        }
-                        //convert the time_stamp to string formatted time.
-                        time_t temptime;
-                        struct tm *timeinfo;
-                        char buffer[80];
+            get_sent_fio_requests_result result;
 
-                        temptime = time_stamp;
-                        timeinfo = gmtime(&temptime);
-                        strftime(buffer, 80, "%Y-%m-%dT%T", timeinfo);
+            const auto system_abi = get_cached_abi(fio_system_code);
+            const auto reqobt_abi = get_cached_abi(fio_reqobt_code);
 
-                        request_status_record rr{fio_request_id, payer_address, payee_address, payer_fio_public_key,
-                                                 payee_fio_public_key, content, buffer, status};
+            auto names_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value, *system_abi);
 
-                        result.requests.push_back(rr);
-                        returnCount++;
-                        if (search_offset > 0) { search_offset--; }
+            // every request made by one of our addresses, whatever its status
+            vector<fio_request_index::range> ranges;
+            for (const auto &address : fio_request_addresses(names_rows_result)) {
+                ranges.push_back({fio_request_index::range::payee_requests, address, fc::optional<uint8_t>()});
+            }
 
-                        if (returnCount == search_limit && search_limit != 0) {
-                            search_results = requests_rows_result.rows.size() - (pos + 1);
-                            search_finished = true;
-                            break;
-                        }
-                    } // Get request statuses
-                } else if (search_finished) {
-                    search_results += requests_rows_result.rows.size();
-                } else {
-                    if (search_offset > 0) {
-                        search_offset -= requests_rows_result.rows.size(); //set 0
-                    }
-                }
+            auto page = fio_requests->get_page(ranges, p.offset, p.limit);
+            for (const auto &r : page.refs) {
+                auto request = get_fio_row<fio_rows::fioreqctxt>(fio_reqobt_code, fio_reqobt_scope,
+                                                                 fio_requests_table, r.id, *reqobt_abi);
+                if (!request) continue;
+
+                result.requests.push_back(request_status_record{request->fio_request_id, request->payer_fio_addr,
+                                                                request->payee_fio_addr, request->payer_key,
+                                                                request->payee_key, request->content,
+                                                                fio_request_time(request->time_stamp),
+                                                                fio_request_status(r.status)});
             }
 
             FIO_404_ASSERT(!(result.requests.size() == 0), "No FIO Requests", fioio::ErrorNoFioRequestsFound);
-            result.more = search_results;
+            result.more = page.more;
             return result;
         }
 
@@ -2208,217 +1970,62 @@ if( options.count(name) ) { \
             fioio::key_to_account(fioKey, account_name);
             name account = name{account_name};
 
-            uint32_t search_results = 0;
-            uint32_t search_limit = p.limit;
-            uint32_t search_offset = p.offset;
-            uint32_t returnCount = 0;
-            bool search_finished = false;
-
             get_obt_data_result result;
 
-            const abi_def system_abi = eosio::chain_apis::get_abi(db, fio_system_code);
-            const abi_def reqobt_abi = eosio::chain_apis::get_abi(db, fio_reqobt_code);
-
-            get_table_rows_params table_row_params = get_table_rows_params{
-                    .json        = true,
-                    .code        = fio_system_code,
-                    .scope       = fio_system_scope,
-                    .table       = fio_address_table,
-                    .lower_bound = boost::lexical_cast<string>(account.value),
-                    .upper_bound = boost::lexical_cast<string>(account.value),
-                    .key_type       = "i64",
-                    .index_position = "4"};
-
-            get_table_rows_result names_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, system_abi, [](uint64_t v) -> uint64_t {
-                        return v;
-                    });
+            const auto system_abi = get_cached_abi(fio_system_code);
+            const auto reqobt_abi = get_cached_abi(fio_reqobt_code);
 
-            FIO_404_ASSERT(!names_rows_result.rows.empty(), "No FIO Requests",
-                           fioio::ErrorNoFioRequestsFound);
-
-            for (size_t knpos = 0; knpos < names_rows_result.rows.size(); knpos++) {
-                string fio_address = names_rows_result.rows[knpos]["name"].as_string();
-                string to_fioadd = fio_address;
-                uint128_t address_hash = fioio::string_to_uint128_t(fio_address.c_str());
-                string fio_requests_lookup_table = "fioreqctxts";   // table name
-                string fio_request_obt_lookup_table = "recordobts";
-
-                std::string hexvalnamehash = "0x";
-                //now get the hex little-endian and search
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&address_hash),
-                                                    sizeof(address_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_requests_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="3"};
-
-                get_table_rows_result payerrequests_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
+            auto names_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value, *system_abi);
 
-                get_table_rows_params name_table_row_params2 = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_requests_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="2"};
-
-                get_table_rows_result payeerequests_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params2, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
-                get_table_rows_params name_table_row_params3 = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_request_obt_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="2"};
-
-                get_table_rows_result payeerequests_obt_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params3, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
-                get_table_rows_params name_table_row_params4 = get_table_rows_params{
-                        .json=true,
-                        .code=fio_reqobt_code,
-                        .scope=fio_reqobt_scope,
-                        .table=fio_request_obt_lookup_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="3"};
-
-                get_table_rows_result payerrequests_obt_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params4, reqobt_abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
+            // per address: requests answered with recordobt from either side, then obt records from either side
+            vector<fio_request_index::range> ranges;
+            for (const auto &address : fio_request_addresses(names_rows_result)) {
+                ranges.push_back({fio_request_index::range::payee_requests, address, uint8_t(2)});
+                ranges.push_back({fio_request_index::range::payer_requests, address, uint8_t(2)});
+                ranges.push_back({fio_request_index::range::payer_obts, address, {}});
+                ranges.push_back({fio_request_index::range::payee_obts, address, {}});
+            }
 
-                obt_data_search(search_limit, result, reqobt_abi,
-                                payerrequests_rows_result, search_results, search_offset, returnCount, search_finished,
-                                true);
-                obt_data_search(search_limit, result, reqobt_abi,
-                                payeerequests_rows_result, search_results, search_offset, returnCount, search_finished,
-                                true);
-                obt_data_search(search_limit, result, reqobt_abi,
-                                payeerequests_obt_rows_result, search_results, search_offset, returnCount,
-                                search_finished, false);
-                obt_data_search(search_limit, result, reqobt_abi,
-                                payerrequests_obt_rows_result, search_results, search_offset, returnCount,
-                                search_finished, false);
+            auto page = fio_requests->get_page(ranges, p.offset, p.limit);
+            for (const auto &r : page.refs) {
+                if (r.obt) {
+                    auto obt = get_fio_row<fio_rows::recordobt_info>(fio_reqobt_code, fio_reqobt_scope,
+                                                                     fio_obt_table, r.id, *reqobt_abi);
+                    if (!obt) continue;
+
+                    result.obt_data_records.push_back(obt_records{obt->payer_fio_addr, obt->payee_fio_addr,
+                                                                  obt->payer_key, obt->payee_key, obt->content, 0,
+                                                                  fio_request_time(obt->time_stamp),
+                                                                  fio_request_status(2)});
+                } else {
+                    auto request = get_fio_row<fio_rows::fioreqctxt>(fio_reqobt_code, fio_reqobt_scope,
+                                                                     fio_requests_table, r.id, *reqobt_abi);
+                    auto status = get_fio_row<fio_rows::fioreqsts>(fio_reqobt_code, fio_reqobt_scope,
+                                                                   fio_request_status_table, r.status_id,
+                                                                   *reqobt_abi);
+                    if (!request || !status) continue;
+
+                    result.obt_data_records.push_back(obt_records{request->payer_fio_addr, request->payee_fio_addr,
+                                                                  request->payer_key, request->payee_key,
+                                                                  status->metadata, request->fio_request_id,
+                                                                  fio_request_time(request->time_stamp),
+                                                                  fio_request_status(2)});
+                }
             }
 
             FIO_404_ASSERT(!(result.obt_data_records.size() == 0), "No FIO Requests", fioio::ErrorNoFioRequestsFound);
-            result.more = search_results;
+            result.more = page.more;
             return result;
         }
 
-        void read_only::obt_data_search(uint32_t search_limit, read_only::get_obt_data_result &result,
-                                        const abi_def &reqobt_abi,
-                                        const read_only::get_table_rows_result &table_rows_result,
-                                        uint32_t &search_results, uint32_t &search_offset, uint32_t &returnCount,
-                                        bool &search_finished, const bool id_req) const {
-            uint64_t statusintV;
-            uint64_t reqid;
-
-            if (search_offset < table_rows_result.rows.size() && !search_finished) {
-                for (size_t pos = 0 + search_offset; pos < table_rows_result.rows.size(); pos++) {
-                    //get all the attributes of the fio request
-                    string payer_address = table_rows_result.rows[pos]["payer_fio_addr"].as_string();
-                    string payee_address = table_rows_result.rows[pos]["payee_fio_addr"].as_string();
-                    uint64_t time_stamp = table_rows_result.rows[pos]["time_stamp"].as_uint64();
-                    string payer_fio_public_key = table_rows_result.rows[pos]["payer_key"].as_string();
-                    string payee_fio_public_key = table_rows_result.rows[pos]["payee_key"].as_string();
-                    string content = table_rows_result.rows[pos]["content"].as_string();
-                    //query the statuses
-                    //use this id and query the fioreqstss table for status updates to this fioreqid
-                    //look up the requests for this fio name (look for matches in the tofioadd
-                    uint64_t fio_request_id = 0;
-
-                    if (id_req) {
-                        fio_request_id = table_rows_result.rows[pos]["fio_request_id"].as_uint64();
-                        string fio_request_status_lookup_table = "fioreqstss";   // table name
-                        get_table_rows_params request_status_row_params = get_table_rows_params{
-                                .json        = true,
-                                .code        = fio_reqobt_code,
-                                .scope       = fio_reqobt_scope,
-                                .table       = fio_request_status_lookup_table,
-                                .lower_bound = boost::lexical_cast<string>(fio_request_id),
-                                .upper_bound = boost::lexical_cast<string>(fio_request_id),
-                                .key_type       = "i64",
-                                .index_position = "2"};
-                        // Do secondary key lookup
-                        get_table_rows_result request_status_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                                request_status_row_params, reqobt_abi, [](uint64_t v) -> uint64_t {
-                                    return v;
-                                });
-
-                        if (!(request_status_rows_result.rows.empty())) {
-                            for (size_t rw = 0; rw < request_status_rows_result.rows.size(); rw++) {
-                                reqid = request_status_rows_result.rows[rw]["fio_request_id"].as_uint64();
-                                statusintV = request_status_rows_result.rows[rw]["status"].as_uint64();
-                                content = request_status_rows_result.rows[rw]["metadata"].as_string();
-                                if (reqid == fio_request_id) {
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                    //convert the time_stamp to string formatted time.
-                    if ((statusintV == 2 && reqid == fio_request_id) || !id_req) {
-                        time_t temptime;
-                        struct tm *timeinfo;
-                        char buffer[80];
-
-                        temptime = time_stamp;
-                        timeinfo = gmtime(&temptime);
-                        strftime(buffer, 80, "%Y-%m-%dT%T", timeinfo);
-                        string status = "sent_to_blockchain";
-
-                        obt_records rr{payer_address, payee_address, payer_fio_public_key,
-                                       payee_fio_public_key, content, fio_request_id, buffer, status};
-
-                        result.obt_data_records.push_back(rr);
-                        returnCount++;
-                        if (search_offset > 0) { search_offset--; }
-
-                        if (returnCount == search_limit && search_limit != 0) {
-                            search_results = table_rows_result.rows.size() - (pos + 1);
-                            search_finished = true;
-                            break;
-                        }
-                    }
-                } // Get request statuses
-            } else if (search_finished) {
-                search_results += table_rows_result.rows.size();
-            } else {
-                if (search_offset > 0) {
-                    search_offset -= table_rows_result.rows.size(); //set 0
-                }
-            }
-        }
-
         void read_only::GetFIOAccount(name account, read_only::get_table_rows_result &account_result) const {
 
-            const abi_def system_abi = eosio::chain_apis::get_abi(db, fio_system_code);
+            const auto system_abi = get_cached_abi(fio_system_code);
             get_table_rows_params fio_table_row_params = get_table_rows_params{
                     .json           = true,
                     .code           = fio_system_code,
-                    .scope          = fio_system_scope,
+                    .scope          = fio_system_scope.to_string(),
                     .table          = fio_accounts_table,
                     .lower_bound    = boost::lexical_cast<string>(account.value),
                     .upper_bound    = boost::lexical_cast<string>(account.value),
@@ -2426,7 +2033,7 @@ if( options.count(name) ) { \
                     .index_position = "1"};
 
             account_result =
-                    get_table_rows_ex<key_value_index>(fio_table_row_params, system_abi);
+                    get_table_rows_ex<key_value_index>(fio_table_row_params, system_abi->serializer);
         }
         // get_sent_fio_requests
 
@@ -2436,6 +2043,11 @@ if( options.count(name) ) { \
         * @return result
         */
         read_only::get_fio_names_result read_only::get_fio_names(const read_only::get_fio_names_params &p) const {
+            return get_fio_names(p, *get_cached_abi(fio_system_code));
+        }
+
+        read_only::get_fio_names_result read_only::get_fio_names(const read_only::get_fio_names_params &p,
+                                                                 const cached_abi &abi) const {
             // assert if empty chain key
             get_fio_names_result result;
             string fioKey = p.fio_public_key;
@@ -2449,24 +2061,10 @@ if( options.count(name) ) { \
             fioio::key_to_account(fioKey, account_name);
             name account = name{account_name};
 
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_system_code);
             const uint64_t key_hash = ::eosio::string_to_uint64_t(fioKey.c_str()); // hash of public address
 
-            get_table_rows_params table_row_params = get_table_rows_params{
-                    .json        = true,
-                    .code        = fio_system_code,
-                    .scope       = fio_system_scope,
-                    .table       = fio_address_table,
-                    .lower_bound = boost::lexical_cast<string>(account.value),
-                    .upper_bound = boost::lexical_cast<string>(account.value),
-                    .key_type       = "i64",
-                    .index_position ="4"};
-
-            get_table_rows_result table_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, abi,
-                    [](uint64_t v) -> uint64_t {
-                        return v;
-                    });
+            auto table_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value, abi);
 
             std::string nam;
             uint64_t namexpiration;
@@ -2474,15 +2072,15 @@ if( options.count(name) ) { \
             struct tm *timeinfo;
             char buffer[80];
 
-            if (!table_rows_result.rows.empty()) {
+            if (!table_rows_result.empty()) {
 
                 // Look through the keynames lookup results and push the fio_addresses into results
-                for (size_t pos = 0; pos < table_rows_result.rows.size(); pos++) {
+                for (size_t pos = 0; pos < table_rows_result.size(); pos++) {
 
-                    nam = (string) table_rows_result.rows[pos]["name"].as_string();
+                    nam = (string) table_rows_result[pos].name;
                     if (nam.find('@') !=
                         std::string::npos) { //if it's not a domain record in the keynames table (no '.'),
-                        namexpiration = table_rows_result.rows[pos]["expiration"].as_uint64();
+                        namexpiration = table_rows_result[pos].expiration;
 
                         temptime = namexpiration;
                         timeinfo = gmtime(&temptime);
@@ -2494,24 +2092,12 @@ if( options.count(name) ) { \
                 } // Get FIO domains and push
             }
             //Get the domain record
-            get_table_rows_params domain_row_params = get_table_rows_params{.json=true,
-                    .code=fio_system_code,
-                    .scope=fio_system_scope,
-                    .table=fio_domains_table,
-                    .lower_bound=boost::lexical_cast<string>(::eosio::string_to_name(account_name.c_str())),
-                    .upper_bound=boost::lexical_cast<string>(::eosio::string_to_name(account_name.c_str())),
-                    .key_type       = "i64",
-                    .index_position = "2"};
-
-            get_table_rows_result domain_result = get_table_rows_by_seckey<index64_index, uint64_t>(domain_row_params,
-                                                                                                    abi,
-                                                                                                    [](uint64_t v) -> uint64_t {
-                                                                                                        return v;
-                                                                                                    });
-            FIO_404_ASSERT(!(domain_result.rows.empty() && table_rows_result.rows.empty()), "No FIO names",
+            auto domain_result = get_fio_rows_by_seckey<fio_rows::domain, index64_index>(
+                    fio_system_code, fio_system_scope, fio_domains_table, 2, account.value, abi);
+            FIO_404_ASSERT(!(domain_result.empty() && table_rows_result.empty()), "No FIO names",
                            fioio::ErrorNoFIONames);
 
-            if (domain_result.rows.empty()) {
+            if (domain_result.empty()) {
 
                 return result;
             }
@@ -2520,10 +2106,10 @@ if( options.count(name) ) { \
             uint64_t domexpiration;
             bool public_domain;
 
-            for (size_t pos = 0; pos < domain_result.rows.size(); pos++) {
-                dom = ((string) domain_result.rows[pos]["name"].as_string());
-                domexpiration = domain_result.rows[pos]["expiration"].as_uint64();
-                public_domain = domain_result.rows[pos]["is_public"].as_bool();
+            for (size_t pos = 0; pos < domain_result.size(); pos++) {
+                dom = ((string) domain_result[pos].name);
+                domexpiration = domain_result[pos].expiration;
+                public_domain = domain_result[pos].is_public;
 
                 temptime = domexpiration;
                 timeinfo = gmtime(&temptime);
@@ -2567,44 +2153,35 @@ if( options.count(name) ) { \
             uint32_t search_limit = p.limit;
             uint32_t search_offset = p.offset;
 
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_system_code);
+            const auto abi = get_cached_abi(fio_system_code);
 
-            //Get the domain record
-            get_table_rows_params domain_row_params = get_table_rows_params{.json=true,
-                    .code=fio_system_code,
-                    .scope=fio_system_scope,
-                    .table=fio_domains_table,
-                    .lower_bound=boost::lexical_cast<string>(::eosio::string_to_name(account_name.c_str())),
-                    .upper_bound=boost::lexical_cast<string>(::eosio::string_to_name(account_name.c_str())),
-                    .key_type       = "i64",
-                    .index_position = "2"};
+            //Get the domain records up to the requested page, the rest are only counted
+            auto domain_result = get_fio_rows_by_seckey<fio_rows::domain, index64_index>(
+                    fio_system_code, fio_system_scope, fio_domains_table, 2, account.value, *abi,
+                    search_limit > 0 ? search_offset + search_limit : get_table_rows_params().limit);
+            const uint32_t domain_count = search_limit > 0 ? count_table_rows_by_seckey<index64_index>(
+                    fio_system_code, fio_system_scope, fio_domains_table, 2, account.value) : domain_result.size();
 
-            get_table_rows_result domain_result = get_table_rows_by_seckey<index64_index, uint64_t>(domain_row_params,
-                                                                                                    abi,
-                                                                                                    [](uint64_t v) -> uint64_t {
-                                                                                                        return v;
-                                                                                                    });
-
-            FIO_404_ASSERT(!domain_result.rows.empty(), "No FIO Domains", fioio::ErrorPubAddressNotFound);
+            FIO_404_ASSERT(domain_count > 0, "No FIO Domains", fioio::ErrorPubAddressNotFound);
 
             std::string dom;
             uint64_t domexpiration;
             bool public_domain;
 
-            if (search_offset < domain_result.rows.size() ) {
-                int64_t leftover = domain_result.rows.size() - (search_offset+search_limit);
+            if (search_offset < domain_result.size() ) {
+                int64_t leftover = (int64_t) domain_count - (search_offset+search_limit);
                 if (leftover < 0){
                     leftover = 0;
                 }
                 result.more = leftover;
-                for (size_t pos = 0 + search_offset; pos < domain_result.rows.size();pos++) {
+                for (size_t pos = 0 + search_offset; pos < domain_result.size();pos++) {
                     if((search_limit > 0)&&(pos-search_offset >= search_limit)){
                         break;
                     }
 
-                    dom = ((string) domain_result.rows[pos]["name"].as_string());
-                    domexpiration = domain_result.rows[pos]["expiration"].as_uint64();
-                    public_domain = domain_result.rows[pos]["is_public"].as_bool();
+                    dom = ((string) domain_result[pos].name);
+                    domexpiration = domain_result[pos].expiration;
+                    public_domain = domain_result[pos].is_public;
 
                     temptime = domexpiration;
                     timeinfo = gmtime(&temptime);
@@ -2612,7 +2189,7 @@ if( options.count(name) ) { \
 
                     fiodomain_record d{dom, buffer, public_domain};
                     result.fio_domains.push_back(d);    //pushback results in domain
-                    result.more = (domain_result.rows.size()-pos)-1;
+                    result.more = (domain_count-pos)-1;
                 }
             }
 
@@ -2647,24 +2224,14 @@ if( options.count(name) ) { \
             uint32_t search_limit = p.limit;
             uint32_t search_offset = p.offset;
 
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_system_code);
+            const auto abi = get_cached_abi(fio_system_code);
             const uint64_t key_hash = ::eosio::string_to_uint64_t(p.fio_public_key.c_str()); // hash of public address
 
-            get_table_rows_params table_row_params = get_table_rows_params{
-                    .json        = true,
-                    .code        = fio_system_code,
-                    .scope       = fio_system_scope,
-                    .table       = fio_address_table,
-                    .lower_bound = boost::lexical_cast<string>(account.value),
-                    .upper_bound = boost::lexical_cast<string>(account.value),
-                    .key_type       = "i64",
-                    .index_position ="4"};
-
-            get_table_rows_result table_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, abi,
-                    [](uint64_t v) -> uint64_t {
-                        return v;
-                    });
+            auto table_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value, *abi,
+                    search_limit > 0 ? search_offset + search_limit : get_table_rows_params().limit);
+            const uint32_t address_count = search_limit > 0 ? count_table_rows_by_seckey<index64_index>(
+                    fio_system_code, fio_system_scope, fio_address_table, 4, account.value) : table_rows_result.size();
 
             std::string nam;
             uint64_t namexpiration;
@@ -2672,22 +2239,22 @@ if( options.count(name) ) { \
             struct tm *timeinfo;
             char buffer[80];
 
-            FIO_404_ASSERT(!table_rows_result.rows.empty(), "No FIO Addresses", fioio::ErrorPubAddressNotFound);
+            FIO_404_ASSERT(address_count > 0, "No FIO Addresses", fioio::ErrorPubAddressNotFound);
 
-            if (search_offset < table_rows_result.rows.size()) {
-                int64_t leftover = table_rows_result.rows.size() - (search_offset+search_limit);
+            if (search_offset < table_rows_result.size()) {
+                int64_t leftover = (int64_t) address_count - (search_offset+search_limit);
                 if (leftover < 0){
                     leftover = 0;
                 }
                 result.more = leftover;
 
-                for (size_t pos = 0 + search_offset;pos < table_rows_result.rows.size();pos++) {
+                for (size_t pos = 0 + search_offset;pos < table_rows_result.size();pos++) {
                     if((search_limit > 0)&&(pos-search_offset >= search_limit)){
                         break;
                     }
-                    nam = (string) table_rows_result.rows[pos]["name"].as_string();
+                    nam = (string) table_rows_result[pos].name;
                     if (nam.find('@') != std::string::npos) {
-                        namexpiration = table_rows_result.rows[pos]["expiration"].as_uint64();
+                        namexpiration = table_rows_result[pos].expiration;
 
                         temptime = namexpiration;
                         timeinfo = gmtime(&temptime);
@@ -2696,7 +2263,7 @@ if( options.count(name) ) { \
                         fioaddress_record fa{nam, buffer};
                         result.fio_addresses.push_back(fa);
                     }
-                    result.more = (table_rows_result.rows.size()-pos)-1;
+                    result.more = (address_count-pos)-1;
                 }
             }
 
@@ -2716,32 +2283,16 @@ if( options.count(name) ) { \
             result.balance = 0;
 
             uint128_t keyhash = fioio::string_to_uint128_t(fioKey.c_str());
-            const abi_def system_abi = eosio::chain_apis::get_abi(db, fio_system_code);
+            const auto system_abi = get_cached_abi(fio_system_code);
 
-            std::string hexvalkeyhash = "0x";
-            hexvalkeyhash.append(
-                    fioio::to_hex_little_endian(reinterpret_cast<const char *>(&keyhash), sizeof(keyhash)));
 
+            auto account_result =
+                    get_fio_rows_by_seckey<fio_rows::eosio_name, index128_index>(
+                            fio_system_code, fio_system_scope, fio_accounts_table, 2, keyhash, *system_abi, 1);
 
-            get_table_rows_params eosio_table_row_params = get_table_rows_params{
-                    .json           = true,
-                    .code           = fio_system_code,
-                    .scope          = fio_system_scope,
-                    .table          = fio_accounts_table,
-                    .lower_bound    = hexvalkeyhash,
-                    .upper_bound    = hexvalkeyhash,
-                    .key_type       = "hex",
-                    .index_position = "2"};
-
-            get_table_rows_result account_result =
-                    get_table_rows_by_seckey<index128_index, uint128_t>(
-                            eosio_table_row_params, system_abi, [](uint128_t v) -> uint128_t {
-                                return v;
-                            });
+            FIO_404_ASSERT(!account_result.empty(), "Public key not found", fioio::ErrorPubAddressNotFound);
 
-            FIO_404_ASSERT(!account_result.rows.empty(), "Public key not found", fioio::ErrorPubAddressNotFound);
-
-            string fio_account = account_result.rows[0]["account"].as_string();
+            string fio_account = account_result[0].account.to_string();
             actor_lookup_params.account_name = fio_account;
 
             try {
@@ -2777,6 +2328,15 @@ if( options.count(name) ) { \
         } //get_actor
 
 
+        optional<uint64_t> read_only::get_scheduled_fee(const string &end_point) const {
+            const uint128_t endpointhash = fioio::string_to_uint128_t(end_point.c_str());
+            auto table_rows_result = get_fio_rows_by_seckey<fio_rows::fiofee, index128_index>(
+                    fio_fee_code, fio_fee_scope, fio_fees_table, 2, endpointhash, *get_cached_abi(fio_fee_code));
+            if (table_rows_result.size() != 1)
+                return optional<uint64_t>();
+            return table_rows_result[0].suf_amount;
+        }
+
         /*** v1/chain/get_fee
         * Retrieves the fee associated with the specified fio address and blockchain endpoint
         * @param p
@@ -2798,73 +2358,43 @@ if( options.count(name) ) { \
             const uint128_t endpointhash = fioio::string_to_uint128_t(p.end_point.c_str());
 
             //read the fees table.
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_fee_code);
-
-            std::string hexvalendpointhash = "0x";
-            hexvalendpointhash.append(
-                    fioio::to_hex_little_endian(reinterpret_cast<const char *>(&endpointhash), sizeof(endpointhash)));
-
-            get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                    .code=fio_fee_code,
-                    .scope=fio_fee_scope,
-                    .table=fio_fees_table,
-                    .lower_bound=hexvalendpointhash,
-                    .upper_bound=hexvalendpointhash,
-                    .encode_type="hex",
-                    .index_position ="2"};
+            const auto abi = get_cached_abi(fio_fee_code);
 
             // Do secondary key lookup
-            get_table_rows_result table_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                    name_table_row_params, abi, [](uint128_t v) -> uint128_t {
-                        return v;
-                    });
+            auto table_rows_result = get_fio_rows_by_seckey<fio_rows::fiofee, index128_index>(
+                    fio_fee_code, fio_fee_scope, fio_fees_table, 2, endpointhash, *abi);
 
-            FIO_400_ASSERT(!table_rows_result.rows.empty(), "end_point", p.end_point, "Invalid end point",
+            FIO_400_ASSERT(!table_rows_result.empty(), "end_point", p.end_point, "Invalid end point",
                            fioio::ErrorNoFeesFoundForEndpoint);
-            FIO_404_ASSERT(table_rows_result.rows.size() == 1, "Multiple fees found for endpoint",
+            FIO_404_ASSERT(table_rows_result.size() == 1, "Multiple fees found for endpoint",
                            fioio::ErrorNoFeesFoundForEndpoint);
 
-            bool isbundleeligible = ((uint64_t) (table_rows_result.rows[0]["type"].as_uint64()) == 1);
-            uint64_t feeamount = (uint64_t) table_rows_result.rows[0]["suf_amount"].as_uint64();
+            bool isbundleeligible = ((uint64_t) (table_rows_result[0].type) == 1);
+            uint64_t feeamount = (uint64_t) table_rows_result[0].suf_amount;
 
             if (isbundleeligible) {
 
                 //read the fio names table using the specified address
                 //read the fees table.
-                const abi_def abi = eosio::chain_apis::get_abi(db, fio_system_code);
+                const auto abi = get_cached_abi(fio_system_code);
                 uint128_t name_hash = fioio::string_to_uint128_t(p.fio_address.c_str());
 
-                std::string hexvalnamehash = "0x";
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&name_hash), sizeof(name_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                        .code=fio_system_code,
-                        .scope=fio_system_scope,
-                        .table=fio_address_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="5"};
-
-                get_table_rows_result names_table_rows_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
+                auto names_table_rows_result = get_fio_rows_by_seckey<fio_rows::fioname, index128_index>(
+                        fio_system_code, fio_system_scope, fio_address_table, 5, name_hash, *abi);
 
                 fioio::FioAddress fa;
                 fioio::getFioAddressStruct(p.fio_address, fa);
                 FIO_400_ASSERT(validateFioNameFormat(fa), "fio_address", p.fio_address, "Invalid FIO Address",
                                fioio::ErrorFioNameNotReg);
 
-                FIO_400_ASSERT(!names_table_rows_result.rows.empty(), "fio_address", p.fio_address,
+                FIO_400_ASSERT(!names_table_rows_result.empty(), "fio_address", p.fio_address,
                                "No such FIO address",
                                fioio::ErrorFioNameNotReg);
 
-                FIO_404_ASSERT(names_table_rows_result.rows.size() == 1, "Multiple names found for fio address",
+                FIO_404_ASSERT(names_table_rows_result.size() == 1, "Multiple names found for fio address",
                                fioio::ErrorNoFeesFoundForEndpoint);
 
-                uint64_t bundleeligiblecountdown = (uint64_t) names_table_rows_result.rows[0]["bundleeligiblecountdown"].as_uint64();
+                uint64_t bundleeligiblecountdown = (uint64_t) names_table_rows_result[0].bundleeligiblecountdown;
                 //read fio names
 
                 if (bundleeligiblecountdown < 1) {
@@ -2895,7 +2425,7 @@ if( options.count(name) ) { \
 
             name account = name{account_name};
 
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_whitelst_code);
+            const auto abi = get_cached_abi(fio_whitelst_code);
 
             get_table_rows_params table_row_params = get_table_rows_params{
                     .json        = true,
@@ -2908,7 +2438,7 @@ if( options.count(name) ) { \
                     .index_position ="2"};
 
             get_table_rows_result table_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, abi, [](uint64_t v) -> uint64_t {
+                    table_row_params, abi->serializer, [](uint64_t v) -> uint64_t {
                         return v;
                     });
 
@@ -2941,7 +2471,7 @@ if( options.count(name) ) { \
 
             uint64_t fio_pub_key_hash = eosio::string_to_uint64_t(p.fio_public_key_hash.c_str());
 
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_whitelst_code);
+            const auto abi = get_cached_abi(fio_whitelst_code);
 
             get_table_rows_params table_row_params = get_table_rows_params{
                     .json        = true,
@@ -2954,7 +2484,7 @@ if( options.count(name) ) { \
                     .index_position ="3"};
 
             get_table_rows_result table_rows_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                    table_row_params, abi, [](uint64_t v) -> uint64_t {
+                    table_row_params, abi->serializer, [](uint64_t v) -> uint64_t {
                         return v;
                     });
 
@@ -2972,6 +2502,11 @@ if( options.count(name) ) { \
         */
         read_only::get_pub_address_result
         read_only::get_pub_address(const read_only::get_pub_address_params &p) const {
+            return get_pub_address(p, *get_cached_abi(fio_system_code));
+        }
+
+        read_only::get_pub_address_result
+        read_only::get_pub_address(const read_only::get_pub_address_params &p, const cached_abi &abi) const {
             fioio::FioAddress fa;
             fioio::getFioAddressStruct(p.fio_address, fa);
             // assert if empty fio name
@@ -2987,89 +2522,53 @@ if( options.count(name) ) { \
                            "Invalid Chain Code",
                            fioio::ErrorTokenCodeInvalid);
 
-            const name code = ::eosio::string_to_name("fio.address");
-            const abi_def abi = eosio::chain_apis::get_abi(db, code);
             const uint128_t name_hash = fioio::string_to_uint128_t(fa.fioaddress.c_str());
             const uint128_t domain_hash = fioio::string_to_uint128_t(fa.fiodomain.c_str());
             const string chainCode = fioio::makeLowerCase(p.chain_code);
             const string tokenCode = fioio::makeLowerCase(p.token_code);
 
             //these are the results for the table searches for domain ansd fio name
-            get_table_rows_result domain_result;
-            get_table_rows_result fioname_result;
-            get_table_rows_result name_result;
+            vector<fio_rows::domain> domain_result;
+            vector<fio_rows::fioname> fioname_result;
 
             get_pub_address_result result;
 
             result.public_address = "";
 
-            std::string hexvaldomainhash = "0x";
-            hexvaldomainhash.append(
-                    fioio::to_hex_little_endian(reinterpret_cast<const char *>(&domain_hash), sizeof(domain_hash)));
-
-            get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                    .code=code,
-                    .scope=fio_system_scope,
-                    .table=fio_domains_table,
-                    .lower_bound=hexvaldomainhash,
-                    .upper_bound=hexvaldomainhash,
-                    .encode_type="hex",
-                    .index_position ="4"};
-
-            domain_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                    name_table_row_params, abi, [](uint128_t v) -> uint128_t {
-                        return v;
-                    });
+            domain_result = get_fio_rows_by_seckey<fio_rows::domain, index128_index>(
+                    fio_system_code, fio_system_scope, fio_domains_table, 4, domain_hash, abi, 1);
 
-            FIO_404_ASSERT(!domain_result.rows.empty(), "Public address not found", fioio::ErrorPubAddressNotFound);
+            FIO_404_ASSERT(!domain_result.empty(), "Public address not found", fioio::ErrorPubAddressNotFound);
 
-            uint32_t domain_expiration = (uint32_t) (domain_result.rows[0]["expiration"].as_uint64());
+            uint32_t domain_expiration = (uint32_t) (domain_result[0].expiration);
             uint32_t present_time = (uint32_t) time(0);
             FIO_400_ASSERT(!(present_time > domain_expiration), "fio_address", p.fio_address, "Invalid FIO Address",
                            fioio::ErrorFioNameEmpty);
 
-            //set name result to be the domain results.
-            name_result = domain_result;
-
             if (!fa.fioname.empty()) {
 
-                std::string hexvalnamehash = "0x";
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&name_hash), sizeof(name_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                        .code=fio_system_code,
-                        .scope=fio_system_scope,
-                        .table=fio_address_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="5"};
-
-                fioname_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
+                fioname_result = get_fio_rows_by_seckey<fio_rows::fioname, index128_index>(
+                        fio_system_code, fio_system_scope, fio_address_table, 5, name_hash, abi, 1);
 
-                FIO_404_ASSERT(!fioname_result.rows.empty(), "Public address not found",
+                FIO_404_ASSERT(!fioname_result.empty(), "Public address not found",
                                fioio::ErrorPubAddressNotFound);
 
-                uint32_t name_expiration = (uint32_t) fioname_result.rows[0]["expiration"].as_uint64();
+                uint32_t name_expiration = (uint32_t) fioname_result[0].expiration;
                 FIO_400_ASSERT(!(present_time > domain_expiration), "fio_address", p.fio_address, "Invalid FIO Address",
                                fioio::ErrorFioNameEmpty);
-
-                //set the result to the name results
-                name_result = fioname_result;
             } else {
                 FIO_404_ASSERT(!p.fio_address.empty(), "Public address not found", fioio::ErrorPubAddressNotFound);
             }
 
-            for (int i = 0; i < name_result.rows[0]["addresses"].size(); i++) {
-                string tToken = fioio::makeLowerCase(name_result.rows[0]["addresses"][i]["token_code"].as_string());
-                string tChain = fioio::makeLowerCase(name_result.rows[0]["addresses"][i]["chain_code"].as_string());
+            // domain records carry no addresses, only a fio name lookup can produce a match
+            if (!fioname_result.empty()) {
+                for (const auto &addr : fioname_result[0].addresses) {
+                    string tToken = fioio::makeLowerCase(addr.token_code);
+                    string tChain = fioio::makeLowerCase(addr.chain_code);
 
-                if ((tToken == tokenCode) && (tChain == chainCode)) {
-                    result.public_address = name_result.rows[0]["addresses"][i]["public_address"].as_string();
+                    if ((tToken == tokenCode) && (tChain == chainCode)) {
+                        result.public_address = addr.public_address;
+                    }
                 }
             }
             //   // Pick out chain specific key and populate result
@@ -3078,6 +2577,72 @@ if( options.count(name) ) { \
             return result;
         } // get_pub_address
 
+        /**
+         * Run one item of a batch request. FIO errors are returned as the body and http code the single
+         * item endpoint would have responded with, anything else fails the whole batch.
+         */
+        template<typename Function>
+        static optional<fio_batch_error> run_batch_item(Function &&f) {
+            try {
+                f();
+            } catch (const fc::exception &e) {
+                if (!fioio::is_fio_error(e.code())) throw;
+                return fio_batch_error{fioio::get_http_result(e.code()),
+                                       fc::json::from_string(e.what(), fc::json::legacy_parser)};
+            }
+            return optional<fio_batch_error>();
+        }
+
+        /*** v1/chain/get_pub_addresses
+        * Batch variant of get_pub_address. All lookups share one ABI and run within the same http callback.
+        * @param p
+        * @return one result per request, in request order
+        */
+        read_only::get_pub_addresses_result
+        read_only::get_pub_addresses(const read_only::get_pub_addresses_params &p) const {
+            FIO_400_ASSERT(!p.requests.empty() && p.requests.size() <= BATCHMAXITEMS, "requests",
+                           to_string(p.requests.size()), "Invalid batch size",
+                           fioio::ErrorBatchSizeInvalid);
+
+            const auto abi = get_cached_abi(fio_system_code);
+            get_pub_addresses_result result;
+            result.results.reserve(p.requests.size());
+            for (const auto &req : p.requests) {
+                get_pub_addresses_item item{req.fio_address, req.token_code, req.chain_code};
+                item.error = run_batch_item([&]() {
+                    item.public_address = get_pub_address(req, *abi).public_address;
+                });
+                result.results.emplace_back(std::move(item));
+            }
+            return result;
+        } // get_pub_addresses
+
+        /*** v1/chain/get_fio_names_batch
+        * Batch variant of get_fio_names. All lookups share one ABI and run within the same http callback.
+        * @param p
+        * @return one result per public key, in request order
+        */
+        read_only::get_fio_names_batch_result
+        read_only::get_fio_names_batch(const read_only::get_fio_names_batch_params &p) const {
+            FIO_400_ASSERT(!p.fio_public_keys.empty() && p.fio_public_keys.size() <= BATCHMAXITEMS, "fio_public_keys",
+                           to_string(p.fio_public_keys.size()), "Invalid batch size",
+                           fioio::ErrorBatchSizeInvalid);
+
+            const auto abi = get_cached_abi(fio_system_code);
+            get_fio_names_batch_result result;
+            result.results.reserve(p.fio_public_keys.size());
+            for (const auto &key : p.fio_public_keys) {
+                get_fio_names_batch_item item{key};
+                item.error = run_batch_item([&]() {
+                    auto names = get_fio_names(get_fio_names_params{key}, *abi);
+                    item.fio_domains = std::move(names.fio_domains);
+                    item.fio_addresses = std::move(names.fio_addresses);
+                });
+                result.results.emplace_back(std::move(item));
+            }
+            return result;
+        } // get_fio_names_batch
+
 
 
         /***
@@ -3095,57 +2660,26 @@ if( options.count(name) ) { \
             FIO_400_ASSERT(validateFioNameFormat(fa), "fio_name", fa.fioaddress, "Invalid FIO Name", fioio::ErrorInvalidFioNameFormat);
 
             //declare variables.
-            const abi_def abi = eosio::chain_apis::get_abi(db, fio_system_code);
+            const auto abi = get_cached_abi(fio_system_code);
             const uint128_t name_hash = fioio::string_to_uint128_t(fa.fioaddress.c_str());
             const uint128_t domain_hash = fioio::string_to_uint128_t(fa.fiodomain.c_str());
-            get_table_rows_result fioname_result;
-            get_table_rows_result name_result;
-            get_table_rows_result domain_result;
-
-            std::string hexvaldomainhash = "0x";
-            hexvaldomainhash.append(
-                    fioio::to_hex_little_endian(reinterpret_cast<const char *>(&domain_hash), sizeof(domain_hash)));
-
-            get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                    .code=fio_system_code,
-                    .scope=fio_system_scope,
-                    .table=fio_domains_table,
-                    .lower_bound=hexvaldomainhash,
-                    .upper_bound=hexvaldomainhash,
-                    .encode_type="hex",
-                    .index_position ="4"};
+            vector<fio_rows::fioname> fioname_result;
+            vector<fio_rows::domain> domain_result;
 
             // Do secondary key lookup
-            domain_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                    name_table_row_params, abi, [](uint128_t v) -> uint128_t {
-                        return v;
-                    });
+            domain_result = get_fio_rows_by_seckey<fio_rows::domain, index128_index>(
+                    fio_system_code, fio_system_scope, fio_domains_table, 4, domain_hash, *abi, 1);
 
             if (!fa.fioname.empty()) {
-                std::string hexvalnamehash = "0x";
-                hexvalnamehash.append(
-                        fioio::to_hex_little_endian(reinterpret_cast<const char *>(&name_hash), sizeof(name_hash)));
-
-                get_table_rows_params name_table_row_params = get_table_rows_params{.json=true,
-                        .code=fio_system_code,
-                        .scope=fio_system_scope,
-                        .table=fio_address_table,
-                        .lower_bound=hexvalnamehash,
-                        .upper_bound=hexvalnamehash,
-                        .encode_type="hex",
-                        .index_position ="5"};
-
                 // Do secondary key lookup
-                fioname_result = get_table_rows_by_seckey<index128_index, uint128_t>(
-                        name_table_row_params, abi, [](uint128_t v) -> uint128_t {
-                            return v;
-                        });
+                fioname_result = get_fio_rows_by_seckey<fio_rows::fioname, index128_index>(
+                        fio_system_code, fio_system_scope, fio_address_table, 5, name_hash, *abi, 1);
 
-                if (fioname_result.rows.empty()) {
+                if (fioname_result.empty()) {
                     return result;
                 }
 
-                uint32_t name_expiration = (uint32_t) (fioname_result.rows[0]["expiration"].as_uint64());
+                uint32_t name_expiration = (uint32_t) (fioname_result[0].expiration);
                 //This is not the local computer time, it is in fact the block time.
                 uint32_t present_time = (uint32_t) time(0);
                 //if the domain is expired then return an empty result.
@@ -3154,11 +2688,11 @@ if( options.count(name) ) { \
                 }
             }
 
-            if (domain_result.rows.empty()) {
+            if (domain_result.empty()) {
                 return result;
             }
 
-            uint32_t domain_expiration = (uint32_t) (domain_result.rows[0]["expiration"].as_uint64());
+            uint32_t domain_expiration = (uint32_t) (domain_result[0].expiration);
             uint32_t present_time = (uint32_t) time(0);
 
             if (present_time > domain_expiration) {
@@ -3174,7 +2708,7 @@ if( options.count(name) ) { \
 
 
         read_only::get_table_rows_result read_only::get_table_rows(const read_only::get_table_rows_params &p) const {
-            const abi_def abi = eosio::chain_apis::get_abi(db, p.code);
+            const auto abi = get_cached_abi(p.code);
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
             bool primary = false;
@@ -3182,38 +2716,38 @@ if( options.count(name) ) { \
             if (primary) {
                 EOS_ASSERT(p.table == table_with_index, chain::contract_table_query_exception,
                            "Invalid table name ${t}", ("t", p.table));
-                auto table_type = get_table_type(abi, p.table);
+                auto table_type = get_table_type(abi->abi, p.table);
                 if (table_type == KEYi64 || p.key_type == "i64" || p.key_type == "name") {
-                    return get_table_rows_ex<key_value_index>(p, abi);
+                    return get_table_rows_ex<key_value_index>(p, abi->serializer);
                 }
                 EOS_ASSERT(false, chain::contract_table_query_exception, "Invalid table type ${type}",
-                           ("type", table_type)("abi", abi));
+                           ("type", table_type)("abi", abi->abi));
             } else {
                 EOS_ASSERT(!p.key_type.empty(), chain::contract_table_query_exception,
                            "key type required for non-primary index");
 
                 if (p.key_type == chain_apis::i64 || p.key_type == "name") {
-                    return get_table_rows_by_seckey<index64_index, uint64_t>(p, abi, [](uint64_t v) -> uint64_t {
+                    return get_table_rows_by_seckey<index64_index, uint64_t>(p, abi->serializer, [](uint64_t v) -> uint64_t {
                         return v;
                     });
                 } else if (p.key_type == chain_apis::i128) {
-                    return get_table_rows_by_seckey<index128_index, uint128_t>(p, abi, [](uint128_t v) -> uint128_t {
+                    return get_table_rows_by_seckey<index128_index, uint128_t>(p, abi->serializer, [](uint128_t v) -> uint128_t {
                         return v;
                     });
                 } else if (p.key_type == chain_apis::i256) {
                     if (p.encode_type == chain_apis::hex) {
                         using conv = keytype_converter<chain_apis::sha256, chain_apis::hex>;
-                        return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+                        return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi->serializer, conv::function());
                     }
                     using conv = keytype_converter<chain_apis::i256>;
-                    return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+                    return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi->serializer, conv::function());
                 } else if (p.key_type == chain_apis::float64) {
-                    return get_table_rows_by_seckey<index_double_index, double>(p, abi, [](double v) -> float64_t {
+                    return get_table_rows_by_seckey<index_double_index, double>(p, abi->serializer, [](double v) -> float64_t {
                         float64_t f = *(float64_t *) &v;
                         return f;
                     });
                 } else if (p.key_type == chain_apis::float128) {
-                    return get_table_rows_by_seckey<index_long_double_index, double>(p, abi,
+                    return get_table_rows_by_seckey<index_long_double_index, double>(p, abi->serializer,
                                                                                      [](double v) -> float128_t {
                                                                                          float64_t f = *(float64_t *) &v;
                                                                                          float128_t f128;
@@ -3222,10 +2756,10 @@ if( options.count(name) ) { \
                                                                                      });
                 } else if (p.key_type == chain_apis::sha256) {
                     using conv = keytype_converter<chain_apis::sha256, chain_apis::hex>;
-                    return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+                    return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi->serializer, conv::function());
                 } else if (p.key_type == chain_apis::ripemd160) {
                     using conv = keytype_converter<chain_apis::ripemd160, chain_apis::hex>;
-                    return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+                    return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi->serializer, conv::function());
                 }
                 EOS_ASSERT(false, chain::contract_table_query_exception, "Unsupported secondary index type: ${t}",
                            ("t", p.key_type));
@@ -3359,9 +2893,10 @@ if( options.count(name) ) { \
         }
 
         read_only::get_producers_result read_only::get_producers(const read_only::get_producers_params &p) const {
-            const abi_def abi = eosio::chain_apis::get_abi(db, config::system_account_name);
+            const auto cached = get_cached_abi(config::system_account_name);
+            const abi_def &abi = cached->abi;
+            const abi_serializer &abis = cached->serializer;
             const auto table_type = get_table_type(abi, N(producers));
-            const abi_serializer abis{abi, abi_serializer_max_time};
 
             EOS_ASSERT(table_type == KEYi64, chain::contract_table_query_exception,
                        "Invalid table type ${type} for table producers", ("type", table_type));
@@ -5426,7 +4961,7 @@ if( options.count(name) ) { \
                     }
                 }
 
-                const abi_def system_abi = eosio::chain_apis::get_abi(db,"eosio");
+                const auto system_abi = get_cached_abi("eosio");
                 get_table_rows_params voter_table = get_table_rows_params{
                         .json        = true,
                         .code        = "eosio",
@@ -5439,7 +4974,7 @@ if( options.count(name) ) { \
                 };
 
                 get_table_rows_result voter_result = get_table_rows_by_seckey<index64_index, uint64_t>(
-                        voter_table, system_abi, [](uint64_t v) -> uint64_t {
+                        voter_table, system_abi->serializer, [](uint64_t v) -> uint64_t {
                             return v;
                         });
                         if (!voter_result.rows.empty()) {
@@ -5508,7 +5043,7 @@ if( options.count(name) ) { \
             serialize_json_result result;
 
             const int32_t HF1_BLOCK_TIME = 1600876800; //Wed Sep 23 16:00:00 UTC 2020
-            string actionname;
+            name code;
 
             action_name nm = params.action;
             if ( db.head_block_time().sec_since_epoch() > HF1_BLOCK_TIME) {
@@ -5516,13 +5051,11 @@ if( options.count(name) ) { \
                 fioaction_item = db.db().find<fioaction_object, by_actionname>(nm);
                 EOS_ASSERT(fioaction_item != nullptr, contract_query_exception, "Action can't be found ${contract}",
                            ("contract", params.action.to_string()));
-                actionname = fioaction_item->contractname;
+                code = ::eosio::string_to_name(fioaction_item->contractname.c_str());
             }else{
-                actionname = fioio::map_to_contract(params.action.to_string());
+                code = name(fioio::map_to_contract(nm.value));
             }
 
-            name code = ::eosio::string_to_name(actionname.c_str());
-
             const auto code_account = db.db().find<account_object, by_name>(code);
             EOS_ASSERT(code_account != nullptr, contract_query_exception, "Contract can't be found ${contract}",
                        ("contract", code));
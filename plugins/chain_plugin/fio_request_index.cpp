@@ -0,0 +1,286 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/chain_plugin/fio_request_index.hpp>
+#include <eosio/chain_plugin/fio_table_rows.hpp>
+#include <eosio/chain/account_object.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+
+namespace eosio {
+    namespace chain_apis {
+
+        using namespace eosio::chain;
+
+        namespace {
+
+            const name fio_reqobt_code = N(fio.reqobt);
+            const name fio_requests_table = N(fioreqctxts);
+            const name fio_request_status_table = N(fioreqstss);
+            const name fio_obt_table = N(recordobts);
+
+            const table_id_object *find_table(const controller &db, const cached_abi &abi, const name &table) {
+                if (abi.serializer.get_table_type(table).empty()) return nullptr;
+                return db.db().find<table_id_object, by_code_scope_table>(
+                        boost::make_tuple(fio_reqobt_code, fio_reqobt_code, table));
+            }
+
+            uint32_t table_rows(const controller &db, const cached_abi &abi, const name &table) {
+                const auto *t_id = find_table(db, abi, table);
+                return t_id == nullptr ? 0 : t_id->count;
+            }
+
+            /**
+             * Visit the rows of fio.reqobt::table with primary key >= cursor, advancing cursor past each one.
+             */
+            template<typename Row, typename Function>
+            void scan_table(const controller &db, const cached_abi &abi, const name &table, uint64_t &cursor,
+                            const fc::microseconds &max_serialization_time, Function f) {
+                const auto *t_id = find_table(db, abi, table);
+                if (t_id == nullptr) return;
+
+                const auto &idx = db.db().get_index<key_value_index, by_scope_primary>();
+                for (auto itr = idx.lower_bound(boost::make_tuple(t_id->id, cursor));
+                     itr != idx.end() && itr->t_id == t_id->id; ++itr) {
+                    f(itr->primary_key, fio_rows::decode_row<Row>(abi, table, *itr, max_serialization_time));
+                    cursor = itr->primary_key + 1;
+                }
+            }
+
+            /**
+             * Bring the entries of idx with id below cursor in line with the rows of fio.reqobt::table: entries
+             * whose row is gone are erased, rows without an entry are visited. Only those rows are decoded.
+             * @return whether any row was visited
+             */
+            template<typename Row, typename Index, typename Function>
+            bool sync_table(const controller &db, const cached_abi &abi, const name &table, uint64_t cursor,
+                            Index &idx, const fc::microseconds &max_serialization_time, Function f) {
+                bool visited = false;
+                auto entry = idx.begin();
+                if (const auto *t_id = find_table(db, abi, table)) {
+                    const auto &rows = db.db().get_index<key_value_index, by_scope_primary>();
+                    for (auto row = rows.lower_bound(boost::make_tuple(t_id->id, uint64_t(0)));
+                         row != rows.end() && row->t_id == t_id->id && row->primary_key < cursor; ++row) {
+                        while (entry != idx.end() && entry->id < row->primary_key) entry = idx.erase(entry);
+                        if (entry != idx.end() && entry->id == row->primary_key) {
+                            ++entry;
+                            continue;
+                        }
+                        f(row->primary_key, fio_rows::decode_row<Row>(abi, table, *row, max_serialization_time));
+                        visited = true;
+                    }
+                }
+                while (entry != idx.end() && entry->id < cursor) entry = idx.erase(entry);
+                return visited;
+            }
+
+            template<typename Index, typename Key, typename ToRef>
+            void collect(const Index &idx, const Key &key, ToRef to_ref, uint32_t &skip, uint32_t limit,
+                         fio_request_index::page &result, uint64_t &more) {
+                const auto lower = idx.lower_bound(key);
+                const auto upper = idx.upper_bound(key);
+                const auto first = idx.rank(lower);
+                const auto count = idx.rank(upper) - first;
+                if (skip >= count) {
+                    skip -= count;
+                    return;
+                }
+
+                auto remaining = count - skip;
+                for (auto itr = idx.nth(first + skip);
+                     itr != upper && (limit == 0 || result.refs.size() < limit); ++itr, --remaining) {
+                    result.refs.push_back(to_ref(*itr));
+                }
+                skip = 0;
+                more += remaining;
+            }
+
+        } // anonymous namespace
+
+        void fio_request_index::reset() {
+            requests.clear();
+            obts.clear();
+            next = cursors();
+            block_cursors.clear();
+            last_block_id = block_id_type();
+        }
+
+        void fio_request_index::update(const controller &db) {
+            if (db.db().find<account_object, by_name>(fio_reqobt_code) == nullptr) return;
+            const auto abi = abi_cache->get(db, fio_reqobt_code, max_serialization_time);
+
+            scan_table<fio_rows::fioreqctxt>(db, *abi, fio_requests_table, next.request, max_serialization_time,
+                                            [&](uint64_t, const fio_rows::fioreqctxt &row) {
+                requests.insert(request_entry{row.fio_request_id, row.payer_fio_address, row.payee_fio_address,
+                                              no_status, 0});
+            });
+
+            scan_statuses(db, *abi);
+
+            scan_table<fio_rows::recordobt_info>(db, *abi, fio_obt_table, next.obt, max_serialization_time,
+                                                [&](uint64_t id, const fio_rows::recordobt_info &row) {
+                obts.insert(obt_entry{id, row.payer_fio_address, row.payee_fio_address});
+            });
+
+            reconcile(db, *abi);
+        }
+
+        void fio_request_index::scan_statuses(const controller &db, const cached_abi &abi) {
+            // only the first status recorded for a request is reported by the endpoints
+            auto &by_request = requests.get<by_id>();
+            scan_table<fio_rows::fioreqsts>(db, abi, fio_request_status_table, next.status, max_serialization_time,
+                                           [&](uint64_t id, const fio_rows::fioreqsts &row) {
+                ++next.num_statuses;
+                auto itr = by_request.find(row.fio_request_id);
+                if (itr == by_request.end() || itr->status != no_status) return;
+                by_request.modify(itr, [&](request_entry &e) {
+                    e.status = static_cast<uint8_t>(row.status);
+                    e.status_id = id;
+                });
+            });
+        }
+
+        void fio_request_index::reconcile(const controller &db, const cached_abi &abi) {
+            bool rescan_statuses = false;
+            if (table_rows(db, abi, fio_requests_table) != requests.size()) {
+                ilog("FIO requests were erased or restored, reconciling the FIO request index");
+                rescan_statuses = sync_table<fio_rows::fioreqctxt>(
+                        db, abi, fio_requests_table, next.request, requests.get<by_id>(), max_serialization_time,
+                        [&](uint64_t, const fio_rows::fioreqctxt &row) {
+                    requests.insert(request_entry{row.fio_request_id, row.payer_fio_address, row.payee_fio_address,
+                                                  no_status, 0});
+                });
+            }
+
+            if (table_rows(db, abi, fio_obt_table) != obts.size()) {
+                ilog("FIO obt records were erased or restored, reconciling the FIO request index");
+                sync_table<fio_rows::recordobt_info>(
+                        db, abi, fio_obt_table, next.obt, obts.get<by_id>(), max_serialization_time,
+                        [&](uint64_t id, const fio_rows::recordobt_info &row) {
+                    obts.insert(obt_entry{id, row.payer_fio_address, row.payee_fio_address});
+                });
+            }
+
+            // which status comes first depends on all the status rows of a request, so they are scanned again;
+            // restored requests need their statuses, which were skipped while the requests were missing
+            if (rescan_statuses || table_rows(db, abi, fio_request_status_table) != next.num_statuses) {
+                ilog("FIO request statuses changed, rescanning them for the FIO request index");
+                auto &by_request = requests.get<by_id>();
+                for (auto itr = by_request.begin(); itr != by_request.end(); ++itr) {
+                    if (itr->status == no_status) continue;
+                    by_request.modify(itr, [](request_entry &e) {
+                        e.status = no_status;
+                        e.status_id = 0;
+                    });
+                }
+                next.status = 0;
+                next.num_statuses = 0;
+                scan_statuses(db, abi);
+            }
+        }
+
+        bool fio_request_index::undo_after(uint32_t block_num) {
+            auto itr = block_cursors.find(block_num);
+            if (itr == block_cursors.end()) return false;
+            const cursors c = itr->second;
+
+            auto &by_request = requests.get<by_id>();
+            by_request.erase(by_request.lower_bound(c.request), by_request.end());
+
+            auto &by_status = requests.get<by_status_id>();
+            std::vector<uint64_t> unset;
+            for (auto s = by_status.lower_bound(c.status); s != by_status.end(); ++s) {
+                if (s->status != no_status) unset.push_back(s->id);
+            }
+            for (const auto id : unset) {
+                by_request.modify(by_request.find(id), [](request_entry &e) {
+                    e.status = no_status;
+                    e.status_id = 0;
+                });
+            }
+
+            auto &obt_by_id = obts.get<by_id>();
+            obt_by_id.erase(obt_by_id.lower_bound(c.obt), obt_by_id.end());
+
+            next = c;
+            block_cursors.erase(std::next(itr), block_cursors.end());
+            return true;
+        }
+
+        void fio_request_index::rebuild(const controller &db) {
+            std::lock_guard<std::mutex> g(mtx);
+            reset();
+            update(db);
+            block_cursors[db.head_block_num()] = next;
+            last_block_id = db.head_block_id();
+        }
+
+        void fio_request_index::on_accepted_block(const controller &db, const block_state_ptr &bsp) {
+            std::lock_guard<std::mutex> g(mtx);
+            if (last_block_id != block_id_type() && bsp->header.previous != last_block_id) {
+                if (undo_after(bsp->block_num - 1)) {
+                    ilog("fork switch at block ${n}, dropping FIO requests indexed after it", ("n", bsp->block_num));
+                } else {
+                    // the fork point is before the first indexed block, which only happens right after startup
+                    ilog("fork switch at block ${n}, rebuilding FIO request index", ("n", bsp->block_num));
+                    reset();
+                }
+            }
+            try {
+                update(db);
+            } catch (const fc::exception &e) {
+                // the rows before the cursors are indexed, scanning resumes from there with the next block
+                wlog("unable to update FIO request index at block ${n}: ${e}",
+                     ("n", bsp->block_num)("e", e.to_detail_string()));
+            }
+            block_cursors[bsp->block_num] = next;
+            block_cursors.erase(block_cursors.begin(), block_cursors.lower_bound(bsp->dpos_irreversible_blocknum));
+            last_block_id = bsp->id;
+        }
+
+        fio_request_index::page fio_request_index::get_page(const std::vector<range> &ranges, uint32_t offset,
+                                                            uint32_t limit) const {
+            std::lock_guard<std::mutex> g(mtx);
+            page result;
+            uint64_t more = 0;
+
+            auto request_ref = [](const request_entry &e) { return ref{e.id, e.status, e.status_id, false}; };
+            auto obt_ref = [](const obt_entry &e) { return ref{e.id, no_status, 0, true}; };
+
+            for (const auto &r : ranges) {
+                switch (r.kind) {
+                    case range::payer_requests:
+                        if (r.status) {
+                            collect(requests.get<by_payer_status>(), boost::make_tuple(r.address, *r.status),
+                                    request_ref, offset, limit, result, more);
+                        } else {
+                            collect(requests.get<by_payer>(), boost::make_tuple(r.address),
+                                    request_ref, offset, limit, result, more);
+                        }
+                        break;
+                    case range::payee_requests:
+                        if (r.status) {
+                            collect(requests.get<by_payee_status>(), boost::make_tuple(r.address, *r.status),
+                                    request_ref, offset, limit, result, more);
+                        } else {
+                            collect(requests.get<by_payee>(), boost::make_tuple(r.address),
+                                    request_ref, offset, limit, result, more);
+                        }
+                        break;
+                    case range::payer_obts:
+                        collect(obts.get<by_payer>(), boost::make_tuple(r.address), obt_ref, offset, limit, result,
+                                more);
+                        break;
+                    case range::payee_obts:
+                        collect(obts.get<by_payee>(), boost::make_tuple(r.address), obt_ref, offset, limit, result,
+                                more);
+                        break;
+                }
+            }
+
+            result.more = static_cast<uint32_t>(std::min<uint64_t>(more, std::numeric_limits<uint32_t>::max()));
+            return result;
+        }
+
+    }
+} // eosio::chain_apis
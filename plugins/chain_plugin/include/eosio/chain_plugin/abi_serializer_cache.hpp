@@ -0,0 +1,124 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/controller.hpp>
+#include <eosio/chain/trace.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace eosio {
+    namespace chain_apis {
+
+        using chain::abi_def;
+        using chain::abi_serializer;
+        using chain::account_name;
+
+        /**
+         * A parsed contract ABI together with the serializer built from it. Entries are immutable
+         * once created so they can be shared between concurrent API calls.
+         */
+        struct cached_abi {
+            cached_abi(abi_def &&a, const fc::sha256 &abi_hash, const fc::microseconds &max_serialization_time)
+                    : abi(std::move(a)), abi_hash(abi_hash), serializer(abi, max_serialization_time) {}
+
+            const abi_def abi;
+            const fc::sha256 abi_hash; ///< hash of the packed ABI as stored on the account
+            const abi_serializer serializer;
+        };
+
+        using cached_abi_ptr = std::shared_ptr<const cached_abi>;
+
+        struct abi_serializer_cache_stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t entries = 0;
+            uint64_t evictions = 0;
+        };
+
+        /**
+         * Process-wide cache of parsed abi_serializer objects used by the read_only chain API.
+         *
+         * Entries are keyed by (account, abi_sequence). setabi bumps abi_sequence, so a lookup
+         * for an account whose sequence moved on replaces the stale entry. A speculative setabi
+         * can be rolled back and its sequence number reused by another setabi; that one is only
+         * ever applied through the controller, whose applied_transaction signal must be fed to
+         * on_applied_transaction so the entries of the account are dropped first.
+         *
+         * At most max_entries accounts are kept, the least recently used one is evicted first.
+         */
+        class abi_serializer_cache {
+        public:
+            static constexpr uint32_t default_max_entries = 1024;
+
+            explicit abi_serializer_cache(uint32_t max_entries = default_max_entries);
+
+            /**
+             * @return the cached ABI for account, parsed on first use or after a setabi
+             * @throws account_query_exception if the account does not exist
+             */
+            cached_abi_ptr get(const chain::controller &db, const account_name &account,
+                               const fc::microseconds &max_serialization_time);
+
+            /// drops the entries of the accounts a transaction ran setabi for
+            void on_applied_transaction(const chain::transaction_trace &trace);
+
+            abi_serializer_cache_stats get_stats() const;
+
+        private:
+            struct entry {
+                uint64_t abi_sequence = 0;
+                cached_abi_ptr abi;
+                std::list<account_name>::iterator lru_pos;
+            };
+
+            void erase(std::map<account_name, entry>::iterator itr);
+
+            const uint32_t max_entries;
+            mutable std::mutex mtx;
+            std::map<account_name, entry> entries;
+            std::list<account_name> lru; ///< accounts of the entries, most recently used first
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> evictions{0};
+        };
+
+        /**
+         * Resolver for abi_serializer::to_variant over a fixed set of cached ABIs. The ABIs are looked up
+         * beforehand on the main thread, so the conversion itself can run on any thread. Accounts missing
+         * from the set, or mapped to nullptr, are converted without an ABI.
+         */
+        class cached_abi_resolver {
+        public:
+            struct result {
+                cached_abi_ptr abi;
+
+                bool valid() const { return abi != nullptr; }
+
+                const abi_serializer *operator->() const { return &abi->serializer; }
+
+                const abi_serializer &operator*() const { return abi->serializer; }
+            };
+
+            explicit cached_abi_resolver(const std::map<account_name, cached_abi_ptr> &abis) : abis(abis) {}
+
+            result operator()(const account_name &account) const {
+                auto itr = abis.find(account);
+                return result{itr != abis.end() ? itr->second : cached_abi_ptr()};
+            }
+
+        private:
+            const std::map<account_name, cached_abi_ptr> &abis;
+        };
+
+    }
+} // eosio::chain_apis
+
+FC_REFLECT(eosio::chain_apis::abi_serializer_cache_stats, (hits)(misses)(entries)(evictions))
@@ -17,6 +17,9 @@
 #include <eosio/chain/abi_serializer.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/types.hpp>
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+#include <eosio/chain_plugin/fio_request_index.hpp>
+#include <eosio/chain_plugin/fio_table_rows.hpp>
 
 #include <boost/container/flat_set.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
@@ -67,6 +70,12 @@ namespace eosio {
             string expiration;
         };
 
+        // per item failure of a batch request, same body and http code as the single item endpoint
+        struct fio_batch_error {
+            uint16_t code;
+            fc::variant error;
+        };
+
         struct request_record {
             uint64_t fio_request_id;     // one up index starting at 0
             string payer_fio_address;   // sender FIO address e.g. john.xyz
@@ -133,12 +142,17 @@ namespace eosio {
             const controller &db;
             const fc::microseconds abi_serializer_max_time;
             bool shorten_abi_errors = true;
+            std::shared_ptr<abi_serializer_cache> abi_cache;
+            std::shared_ptr<const fio_request_index> fio_requests;
 
         public:
             static const string KEYi64;
 
-            read_only(const controller &db, const fc::microseconds &abi_serializer_max_time)
-                    : db(db), abi_serializer_max_time(abi_serializer_max_time) {}
+            read_only(const controller &db, const fc::microseconds &abi_serializer_max_time,
+                      std::shared_ptr<abi_serializer_cache> abi_cache,
+                      std::shared_ptr<const fio_request_index> fio_requests)
+                    : db(db), abi_serializer_max_time(abi_serializer_max_time), abi_cache(std::move(abi_cache)),
+                      fio_requests(std::move(fio_requests)) {}
 
             void validate() const {}
 
@@ -487,11 +501,13 @@ namespace eosio {
             struct get_actions_params {
                 int32_t offset = 0;
                 int32_t limit = 0;
+                string cursor;          // next_cursor of a previous call, resumes there and ignores offset
             };
 
             struct get_actions_result {
                 vector <action_record> actions;
                 uint32_t more;
+                string next_cursor;     // empty once the last action has been returned
             };
 
             get_actions_result get_actions(const get_actions_params &params) const;
@@ -619,11 +635,6 @@ namespace eosio {
 
             get_actor_result get_actor(const get_actor_params &params) const;
 
-            void obt_data_search(uint32_t search_limit, get_obt_data_result &result, const abi_def &reqobt_abi,
-                                 const get_table_rows_result &table_rows_result, uint32_t &search_results,
-                                 uint32_t &search_offset, uint32_t &returnCount, bool &search_finished,
-                                 const bool id_req) const;
-
             //Fio API get_fee
             struct get_fee_params {
                 string end_point;
@@ -636,6 +647,9 @@ namespace eosio {
             get_fee_result get_fee(const get_fee_params &params) const;
             //Fio API get_fee
 
+            /// the fee fio.fee schedules for an endpoint, before bundled transactions, or an empty optional if it has none
+            optional<uint64_t> get_scheduled_fee(const string &end_point) const;
+
             struct get_pub_address_params {
                 fc::string fio_address;
                 fc::string token_code;
@@ -647,6 +661,42 @@ namespace eosio {
             };
 
             get_pub_address_result get_pub_address(const get_pub_address_params &params) const;
+            get_pub_address_result get_pub_address(const get_pub_address_params &params, const cached_abi &abi) const;
+
+            struct get_pub_addresses_params {
+                vector<get_pub_address_params> requests;
+            };
+
+            struct get_pub_addresses_item {
+                fc::string fio_address;
+                fc::string token_code;
+                fc::string chain_code;
+                fc::string public_address;
+                optional<fio_batch_error> error;
+            };
+
+            struct get_pub_addresses_result {
+                vector<get_pub_addresses_item> results;
+            };
+
+            get_pub_addresses_result get_pub_addresses(const get_pub_addresses_params &params) const;
+
+            struct get_fio_names_batch_params {
+                vector<string> fio_public_keys;
+            };
+
+            struct get_fio_names_batch_item {
+                string fio_public_key;
+                vector<fiodomain_record> fio_domains;
+                vector<fioaddress_record> fio_addresses;
+                optional<fio_batch_error> error;
+            };
+
+            struct get_fio_names_batch_result {
+                vector<get_fio_names_batch_item> results;
+            };
+
+            get_fio_names_batch_result get_fio_names_batch(const get_fio_names_batch_params &params) const;
 
             /**
              * Lookup FIO domains and addresses based upon public address
@@ -654,6 +704,7 @@ namespace eosio {
              * @return
              */
             get_fio_names_result get_fio_names(const get_fio_names_params &params) const;
+            get_fio_names_result get_fio_names(const get_fio_names_params &params, const cached_abi &abi) const;
             get_fio_domains_result get_fio_domains(const get_fio_domains_params &params) const;
             get_fio_addresses_result get_fio_addresses(const get_fio_addresses_params &params) const;
 
@@ -687,6 +738,13 @@ namespace eosio {
             fio_key_lookup_result fio_key_lookup(const fio_key_lookup_params &params) const;
 
 
+            /**
+             * Fetch the parsed ABI of an account through the shared abi_serializer_cache
+             */
+            cached_abi_ptr get_cached_abi(const name &account) const {
+                return abi_cache->get(db, account, abi_serializer_max_time);
+            }
+
             static void copy_inline_row(const chain::key_value_object &obj, vector<char> &data) {
                 data.resize(obj.value.size());
                 memcpy(data.data(), obj.value.data(), obj.value.size());
@@ -713,187 +771,295 @@ namespace eosio {
 
             static uint64_t get_table_index_name(const read_only::get_table_rows_params &p, bool &primary);
 
-            template<typename IndexType, typename SecKeyType, typename ConvFn>
-            read_only::get_table_rows_result
-            get_table_rows_by_seckey(const read_only::get_table_rows_params &p, const abi_def &abi, ConvFn conv) const {
-                read_only::get_table_rows_result result;
+            /**
+             * Walk the rows selected by a secondary index query, calling f for each key_value_object.
+             * @return true if the walk stopped before reaching the upper bound
+             */
+            template<typename IndexType, typename SecKeyType, typename ConvFn, typename Function>
+            bool walk_table_rows_by_seckey(const read_only::get_table_rows_params &p, ConvFn conv, Function f) const {
                 const auto &d = db.db();
 
                 uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-                abi_serializer abis;
-                abis.set_abi(abi, abi_serializer_max_time);
                 bool primary = false;
                 const uint64_t table_with_index = get_table_index_name(p, primary);
                 const auto *t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(
                         boost::make_tuple(p.code, scope, p.table));
                 const auto *index_t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(
                         boost::make_tuple(p.code, scope, table_with_index));
-                if (t_id != nullptr && index_t_id != nullptr) {
-                    using secondary_key_type = std::result_of_t<decltype(conv)(SecKeyType)>;
-                    static_assert(
-                            std::is_same<typename IndexType::value_type::secondary_key_type, secondary_key_type>::value,
-                            "Return type of conv does not match type of secondary key for IndexType");
-
-                    const auto &secidx = d.get_index<IndexType, chain::by_secondary>();
-                    auto lower_bound_lookup_tuple = std::make_tuple(index_t_id->id._id,
-                                                                    eosio::chain::secondary_key_traits<secondary_key_type>::true_lowest(),
-                                                                    std::numeric_limits<uint64_t>::lowest());
-                    auto upper_bound_lookup_tuple = std::make_tuple(index_t_id->id._id,
-                                                                    eosio::chain::secondary_key_traits<secondary_key_type>::true_highest(),
-                                                                    std::numeric_limits<uint64_t>::max());
-
-                    if (p.lower_bound.size()) {
-                        if (p.key_type == "name") {
-                            name s(p.lower_bound);
-                            SecKeyType lv = convert_to_type<SecKeyType>(s.to_string(),
-                                                                        "lower_bound name"); // avoids compiler error
-                            std::get<1>(lower_bound_lookup_tuple) = conv(lv);
-                        } else {
-                            SecKeyType lv = convert_to_type<SecKeyType>(p.lower_bound, "lower_bound");
-                            std::get<1>(lower_bound_lookup_tuple) = conv(lv);
-                        }
-                    }
+                if (t_id == nullptr || index_t_id == nullptr) {
+                    return false;
+                }
 
-                    if (p.upper_bound.size()) {
-                        if (p.key_type == "name") {
-                            name s(p.upper_bound);
-                            SecKeyType uv = convert_to_type<SecKeyType>(s.to_string(), "upper_bound name");
-                            std::get<1>(upper_bound_lookup_tuple) = conv(uv);
-                        } else {
-                            SecKeyType uv = convert_to_type<SecKeyType>(p.upper_bound, "upper_bound");
-                            std::get<1>(upper_bound_lookup_tuple) = conv(uv);
-                        }
+                using secondary_key_type = std::result_of_t<decltype(conv)(SecKeyType)>;
+                static_assert(
+                        std::is_same<typename IndexType::value_type::secondary_key_type, secondary_key_type>::value,
+                        "Return type of conv does not match type of secondary key for IndexType");
+
+                const auto &secidx = d.get_index<IndexType, chain::by_secondary>();
+                auto lower_bound_lookup_tuple = std::make_tuple(index_t_id->id._id,
+                                                                eosio::chain::secondary_key_traits<secondary_key_type>::true_lowest(),
+                                                                std::numeric_limits<uint64_t>::lowest());
+                auto upper_bound_lookup_tuple = std::make_tuple(index_t_id->id._id,
+                                                                eosio::chain::secondary_key_traits<secondary_key_type>::true_highest(),
+                                                                std::numeric_limits<uint64_t>::max());
+
+                if (p.lower_bound.size()) {
+                    if (p.key_type == "name") {
+                        name s(p.lower_bound);
+                        SecKeyType lv = convert_to_type<SecKeyType>(s.to_string(),
+                                                                    "lower_bound name"); // avoids compiler error
+                        std::get<1>(lower_bound_lookup_tuple) = conv(lv);
+                    } else {
+                        SecKeyType lv = convert_to_type<SecKeyType>(p.lower_bound, "lower_bound");
+                        std::get<1>(lower_bound_lookup_tuple) = conv(lv);
                     }
+                }
 
-                    if (upper_bound_lookup_tuple < lower_bound_lookup_tuple)
-                        return result;
-
-                    auto walk_table_row_range = [&](auto itr, auto end_itr) {
-                        auto cur_time = fc::time_point::now();
-                        auto end_time = cur_time + fc::microseconds(WALKVALUE); /// 100ms max time
-                        vector<char> data;
-                        for (unsigned int count = 0; cur_time <= end_time && count < p.limit &&
-                                                     itr != end_itr; ++itr, cur_time = fc::time_point::now()) {
-                            const auto *itr2 = d.find<chain::key_value_object, chain::by_scope_primary>(
-                                    boost::make_tuple(t_id->id, itr->primary_key));
-                            if (itr2 == nullptr) continue;
-                            copy_inline_row(*itr2, data);
-
-                            fc::variant data_var;
-                            if (p.json) {
-                                data_var = abis.binary_to_variant(abis.get_table_type(p.table), data,
-                                                                  abi_serializer_max_time, shorten_abi_errors);
-                            } else {
-                                data_var = fc::variant(data);
-                            }
-
-                            if (p.show_payer && *p.show_payer) {
-                                result.rows.emplace_back(
-                                        fc::mutable_variant_object("data", std::move(data_var))("payer", itr->payer));
-                            } else {
-                                result.rows.emplace_back(std::move(data_var));
-                            }
-
-                            ++count;
-                        }
-                        if (itr != end_itr) {
-                            result.more = true;
-                        }
-                    };
-
-                    auto lower = secidx.lower_bound(lower_bound_lookup_tuple);
-                    auto upper = secidx.upper_bound(upper_bound_lookup_tuple);
-                    if (p.reverse && *p.reverse) {
-                        walk_table_row_range(boost::make_reverse_iterator(upper), boost::make_reverse_iterator(lower));
+                if (p.upper_bound.size()) {
+                    if (p.key_type == "name") {
+                        name s(p.upper_bound);
+                        SecKeyType uv = convert_to_type<SecKeyType>(s.to_string(), "upper_bound name");
+                        std::get<1>(upper_bound_lookup_tuple) = conv(uv);
                     } else {
-                        walk_table_row_range(lower, upper);
+                        SecKeyType uv = convert_to_type<SecKeyType>(p.upper_bound, "upper_bound");
+                        std::get<1>(upper_bound_lookup_tuple) = conv(uv);
                     }
                 }
-                return result;
+
+                if (upper_bound_lookup_tuple < lower_bound_lookup_tuple)
+                    return false;
+
+                bool more = false;
+                auto walk_table_row_range = [&](auto itr, auto end_itr) {
+                    auto cur_time = fc::time_point::now();
+                    auto end_time = cur_time + fc::microseconds(WALKVALUE); /// 100ms max time
+                    for (unsigned int count = 0; cur_time <= end_time && count < p.limit &&
+                                                 itr != end_itr; ++itr, cur_time = fc::time_point::now()) {
+                        const auto *itr2 = d.find<chain::key_value_object, chain::by_scope_primary>(
+                                boost::make_tuple(t_id->id, itr->primary_key));
+                        if (itr2 == nullptr) continue;
+                        f(*itr2);
+                        ++count;
+                    }
+                    more = (itr != end_itr);
+                };
+
+                auto lower = secidx.lower_bound(lower_bound_lookup_tuple);
+                auto upper = secidx.upper_bound(upper_bound_lookup_tuple);
+                if (p.reverse && *p.reverse) {
+                    walk_table_row_range(boost::make_reverse_iterator(upper), boost::make_reverse_iterator(lower));
+                } else {
+                    walk_table_row_range(lower, upper);
+                }
+                return more;
             }
 
-            template<typename IndexType>
-            read_only::get_table_rows_result
-            get_table_rows_ex(const read_only::get_table_rows_params &p, const abi_def &abi) const {
-                read_only::get_table_rows_result result;
+            /**
+             * Walk the rows selected by a primary key query, calling f for each key_value_object.
+             * @return true if the walk stopped before reaching the upper bound
+             */
+            template<typename IndexType, typename Function>
+            bool walk_table_rows_ex(const read_only::get_table_rows_params &p, Function f) const {
                 const auto &d = db.db();
 
                 uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-                abi_serializer abis;
-                abis.set_abi(abi, abi_serializer_max_time);
                 const auto *t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(
                         boost::make_tuple(p.code, scope, p.table));
-                if (t_id != nullptr) {
-                    const auto &idx = d.get_index<IndexType, chain::by_scope_primary>();
-                    auto lower_bound_lookup_tuple = std::make_tuple(t_id->id, std::numeric_limits<uint64_t>::lowest());
-                    auto upper_bound_lookup_tuple = std::make_tuple(t_id->id, std::numeric_limits<uint64_t>::max());
-
-                    if (p.lower_bound.size()) {
-                        if (p.key_type == "name") {
-                            name s(p.lower_bound);
-                            std::get<1>(lower_bound_lookup_tuple) = s.value;
-                        } else {
-                            auto lv = convert_to_type<typename IndexType::value_type::key_type>(p.lower_bound,
-                                                                                                "lower_bound");
-                            std::get<1>(lower_bound_lookup_tuple) = lv;
-                        }
+                if (t_id == nullptr) {
+                    return false;
+                }
+
+                const auto &idx = d.get_index<IndexType, chain::by_scope_primary>();
+                auto lower_bound_lookup_tuple = std::make_tuple(t_id->id, std::numeric_limits<uint64_t>::lowest());
+                auto upper_bound_lookup_tuple = std::make_tuple(t_id->id, std::numeric_limits<uint64_t>::max());
+
+                if (p.lower_bound.size()) {
+                    if (p.key_type == "name") {
+                        name s(p.lower_bound);
+                        std::get<1>(lower_bound_lookup_tuple) = s.value;
+                    } else {
+                        auto lv = convert_to_type<typename IndexType::value_type::key_type>(p.lower_bound,
+                                                                                            "lower_bound");
+                        std::get<1>(lower_bound_lookup_tuple) = lv;
                     }
+                }
 
-                    if (p.upper_bound.size()) {
-                        if (p.key_type == "name") {
-                            name s(p.upper_bound);
-                            std::get<1>(upper_bound_lookup_tuple) = s.value;
-                        } else {
-                            auto uv = convert_to_type<typename IndexType::value_type::key_type>(p.upper_bound,
-                                                                                                "upper_bound");
-                            std::get<1>(upper_bound_lookup_tuple) = uv;
-                        }
+                if (p.upper_bound.size()) {
+                    if (p.key_type == "name") {
+                        name s(p.upper_bound);
+                        std::get<1>(upper_bound_lookup_tuple) = s.value;
+                    } else {
+                        auto uv = convert_to_type<typename IndexType::value_type::key_type>(p.upper_bound,
+                                                                                            "upper_bound");
+                        std::get<1>(upper_bound_lookup_tuple) = uv;
                     }
+                }
 
-                    if (upper_bound_lookup_tuple < lower_bound_lookup_tuple)
-                        return result;
-
-                    auto walk_table_row_range = [&](auto itr, auto end_itr) {
-                        auto cur_time = fc::time_point::now();
-                        auto end_time = cur_time + fc::microseconds(WALKVALUE); /// 100ms max time
-                        vector<char> data;
-                        for (unsigned int count = 0; cur_time <= end_time && count < p.limit &&
-                                                     itr != end_itr; ++count, ++itr, cur_time = fc::time_point::now()) {
-                            copy_inline_row(*itr, data);
-
-                            fc::variant data_var;
-                            if (p.json) {
-                                data_var = abis.binary_to_variant(abis.get_table_type(p.table), data,
-                                                                  abi_serializer_max_time, shorten_abi_errors);
-                            } else {
-                                data_var = fc::variant(data);
-                            }
-
-                            if (p.show_payer && *p.show_payer) {
-                                result.rows.emplace_back(
-                                        fc::mutable_variant_object("data", std::move(data_var))("payer", itr->payer));
-                            } else {
-                                result.rows.emplace_back(std::move(data_var));
-                            }
-                        }
-                        if (itr != end_itr) {
-                            result.more = true;
-                        }
-                    };
+                if (upper_bound_lookup_tuple < lower_bound_lookup_tuple)
+                    return false;
 
-                    auto lower = idx.lower_bound(lower_bound_lookup_tuple);
-                    auto upper = idx.upper_bound(upper_bound_lookup_tuple);
-                    if (p.reverse && *p.reverse) {
-                        walk_table_row_range(boost::make_reverse_iterator(upper), boost::make_reverse_iterator(lower));
-                    } else {
-                        walk_table_row_range(lower, upper);
+                bool more = false;
+                auto walk_table_row_range = [&](auto itr, auto end_itr) {
+                    auto cur_time = fc::time_point::now();
+                    auto end_time = cur_time + fc::microseconds(WALKVALUE); /// 100ms max time
+                    for (unsigned int count = 0; cur_time <= end_time && count < p.limit &&
+                                                 itr != end_itr; ++count, ++itr, cur_time = fc::time_point::now()) {
+                        f(*itr);
                     }
+                    more = (itr != end_itr);
+                };
+
+                auto lower = idx.lower_bound(lower_bound_lookup_tuple);
+                auto upper = idx.upper_bound(upper_bound_lookup_tuple);
+                if (p.reverse && *p.reverse) {
+                    walk_table_row_range(boost::make_reverse_iterator(upper), boost::make_reverse_iterator(lower));
+                } else {
+                    walk_table_row_range(lower, upper);
+                }
+                return more;
+            }
+
+            void push_table_row(const read_only::get_table_rows_params &p, const abi_serializer &abis,
+                                const chain::key_value_object &obj, read_only::get_table_rows_result &result) const {
+                vector<char> data;
+                copy_inline_row(obj, data);
+
+                fc::variant data_var;
+                if (p.json) {
+                    data_var = abis.binary_to_variant(abis.get_table_type(p.table), data,
+                                                      abi_serializer_max_time, shorten_abi_errors);
+                } else {
+                    data_var = fc::variant(data);
+                }
+
+                if (p.show_payer && *p.show_payer) {
+                    result.rows.emplace_back(
+                            fc::mutable_variant_object("data", std::move(data_var))("payer", obj.payer));
+                } else {
+                    result.rows.emplace_back(std::move(data_var));
                 }
+            }
+
+            template<typename IndexType, typename SecKeyType, typename ConvFn>
+            read_only::get_table_rows_result
+            get_table_rows_by_seckey(const read_only::get_table_rows_params &p, const abi_serializer &abis, ConvFn conv) const {
+                read_only::get_table_rows_result result;
+                result.more = walk_table_rows_by_seckey<IndexType, SecKeyType>(p, conv, [&](const chain::key_value_object &obj) {
+                    push_table_row(p, abis, obj, result);
+                });
+                return result;
+            }
+
+            template<typename IndexType>
+            read_only::get_table_rows_result
+            get_table_rows_ex(const read_only::get_table_rows_params &p, const abi_serializer &abis) const {
+                read_only::get_table_rows_result result;
+                result.more = walk_table_rows_ex<IndexType>(p, [&](const typename IndexType::value_type &obj) {
+                    push_table_row(p, abis, obj, result);
+                });
                 return result;
             }
 
+            /**
+             * Walk the rows of code/scope/table whose secondary key at index_position (2 = first secondary
+             * index, as in get_table_rows_params) equals key. Internal callers pass the key in its native type
+             * so no bounds are formatted or parsed. At most limit rows are visited, as with
+             * get_table_rows_params::limit. The walk time limit is only armed once a second row is
+             * reached, so point lookups on unique keys never read the clock.
+             * @return true if the walk stopped before visiting every matching row
+             */
+            template<typename IndexType, typename Function>
+            bool walk_table_rows_by_seckey(name code, name scope, name table, uint64_t index_position,
+                                           const typename IndexType::value_type::secondary_key_type &key,
+                                           uint32_t limit, Function f) const {
+                EOS_ASSERT(index_position >= 2 && index_position <= 17, chain::contract_table_query_exception,
+                           "Invalid index_position: ${p}", ("p", index_position));
+                const auto &d = db.db();
+
+                const name table_with_index{(table.value & 0xFFFFFFFFFFFFFFF0ULL) | (index_position - 2)};
+                const auto *t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(
+                        boost::make_tuple(code, scope, table));
+                const auto *index_t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(
+                        boost::make_tuple(code, scope, table_with_index));
+                if (t_id == nullptr || index_t_id == nullptr) {
+                    return false;
+                }
+
+                const auto &secidx = d.get_index<IndexType, chain::by_secondary>();
+                auto itr = secidx.lower_bound(
+                        std::make_tuple(index_t_id->id._id, key, std::numeric_limits<uint64_t>::lowest()));
+                fc::time_point end_time;
+                for (unsigned int count = 0; itr != secidx.end() && itr->t_id == index_t_id->id &&
+                                             itr->secondary_key == key; ++itr) {
+                    if (count >= limit) {
+                        return true;
+                    }
+                    if (count == 1) {
+                        end_time = fc::time_point::now() + fc::microseconds(WALKVALUE); /// 100ms max time
+                    } else if (count > 1 && fc::time_point::now() > end_time) {
+                        return true;
+                    }
+                    const auto *obj = d.find<chain::key_value_object, chain::by_scope_primary>(
+                            boost::make_tuple(t_id->id, itr->primary_key));
+                    if (obj == nullptr) continue;
+                    f(*obj);
+                    ++count;
+                }
+                return false;
+            }
+
+            /**
+             * Count the rows of code/scope/table whose secondary key at index_position equals key without
+             * decoding them, so paged callers can report how many rows are left after a limited fetch.
+             */
+            template<typename IndexType>
+            uint32_t count_table_rows_by_seckey(name code, name scope, name table, uint64_t index_position,
+                                                const typename IndexType::value_type::secondary_key_type &key) const {
+                uint32_t count = 0;
+                walk_table_rows_by_seckey<IndexType>(code, scope, table, index_position, key,
+                                                     get_table_rows_params().limit,
+                                                     [&](const chain::key_value_object &) { ++count; });
+                return count;
+            }
+
+            /**
+             * Fetch FIO contract rows as compiled structs. Rows are unpacked directly from the table when
+             * the deployed ABI matches Row, otherwise they are decoded through the ABI serializer.
+             * At most limit rows are returned.
+             */
+            template<typename Row, typename IndexType>
+            vector<Row> get_fio_rows_by_seckey(name code, name scope, name table, uint64_t index_position,
+                                               const typename IndexType::value_type::secondary_key_type &key,
+                                               const cached_abi &abi,
+                                               uint32_t limit = get_table_rows_params().limit) const {
+                vector<Row> rows;
+                walk_table_rows_by_seckey<IndexType>(code, scope, table, index_position, key, limit,
+                                                     [&](const chain::key_value_object &obj) {
+                                                         rows.emplace_back(fio_rows::decode_row<Row>(
+                                                                 abi, table, obj, abi_serializer_max_time,
+                                                                 shorten_abi_errors));
+                                                     });
+                return rows;
+            }
+
+            /**
+             * Fetch a single FIO contract row by primary key.
+             */
+            template<typename Row>
+            optional<Row> get_fio_row(name code, name scope, name table, uint64_t primary_key,
+                                      const cached_abi &abi) const {
+                const auto &d = db.db();
+                const auto *t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(
+                        boost::make_tuple(code, scope, table));
+                if (t_id == nullptr) return optional<Row>();
+                const auto *obj = d.find<chain::key_value_object, chain::by_scope_primary>(
+                        boost::make_tuple(t_id->id, primary_key));
+                if (obj == nullptr) return optional<Row>();
+                return fio_rows::decode_row<Row>(abi, table, *obj, abi_serializer_max_time, shorten_abi_errors);
+            }
+
             chain::symbol extract_core_symbol() const;
 
             friend struct resolver_factory<read_only>;
@@ -1315,7 +1481,8 @@ namespace eosio {
         void plugin_shutdown();
 
         chain_apis::read_only get_read_only_api() const {
-            return chain_apis::read_only(chain(), get_abi_serializer_max_time());
+            return chain_apis::read_only(chain(), get_abi_serializer_max_time(), get_abi_serializer_cache(),
+                                         get_fio_request_index());
         }
 
         chain_apis::read_write get_read_write_api() {
@@ -1357,6 +1524,10 @@ namespace eosio {
 
         fc::microseconds get_abi_serializer_max_time() const;
 
+        std::shared_ptr<chain_apis::abi_serializer_cache> get_abi_serializer_cache() const;
+
+        std::shared_ptr<const chain_apis::fio_request_index> get_fio_request_index() const;
+
         static void handle_guard_exception(const chain::guard_exception &e);
 
         static void handle_db_exhaustion();
@@ -1395,8 +1566,8 @@ FC_REFLECT(eosio::chain_apis::read_only::get_cancelled_fio_requests_params, (fio
 FC_REFLECT(eosio::chain_apis::read_only::get_cancelled_fio_requests_result, (requests)(more))
 FC_REFLECT(eosio::chain_apis::read_only::get_sent_fio_requests_params, (fio_public_key)(offset)(limit))
 FC_REFLECT(eosio::chain_apis::read_only::get_sent_fio_requests_result, (requests)(more))
-FC_REFLECT(eosio::chain_apis::read_only::get_actions_params, (offset)(limit))
-FC_REFLECT(eosio::chain_apis::read_only::get_actions_result, (actions)(more))
+FC_REFLECT(eosio::chain_apis::read_only::get_actions_params, (offset)(limit)(cursor))
+FC_REFLECT(eosio::chain_apis::read_only::get_actions_result, (actions)(more)(next_cursor))
 FC_REFLECT(eosio::chain_apis::read_only::get_obt_data_params, (fio_public_key)(offset)(limit))
 FC_REFLECT(eosio::chain_apis::read_only::get_obt_data_result, (obt_data_records)(more))
 FC_REFLECT(eosio::chain_apis::read_only::get_whitelist_params, (fio_public_key))
@@ -1420,6 +1591,14 @@ FC_REFLECT(eosio::chain_apis::obt_records,
 
 FC_REFLECT(eosio::chain_apis::read_only::get_pub_address_params, (fio_address)(token_code)(chain_code))
 FC_REFLECT(eosio::chain_apis::read_only::get_pub_address_result, (public_address));
+FC_REFLECT(eosio::chain_apis::fio_batch_error, (code)(error))
+FC_REFLECT(eosio::chain_apis::read_only::get_pub_addresses_params, (requests))
+FC_REFLECT(eosio::chain_apis::read_only::get_pub_addresses_item,
+           (fio_address)(token_code)(chain_code)(public_address)(error))
+FC_REFLECT(eosio::chain_apis::read_only::get_pub_addresses_result, (results))
+FC_REFLECT(eosio::chain_apis::read_only::get_fio_names_batch_params, (fio_public_keys))
+FC_REFLECT(eosio::chain_apis::read_only::get_fio_names_batch_item, (fio_public_key)(fio_domains)(fio_addresses)(error))
+FC_REFLECT(eosio::chain_apis::read_only::get_fio_names_batch_result, (results))
 FC_REFLECT(eosio::chain_apis::fiodomain_record, (fio_domain)(expiration)(is_public))
 FC_REFLECT(eosio::chain_apis::fioaddress_record, (fio_address)(expiration))
 FC_REFLECT(eosio::chain_apis::read_only::get_fio_names_params, (fio_public_key))
@@ -0,0 +1,191 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+#include <eosio/chain/block_state.hpp>
+#include <eosio/chain/controller.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+
+#include <map>
+#include <mutex>
+
+namespace eosio {
+    namespace chain_apis {
+
+        using chain::uint128_t;
+
+        /**
+         * Derived index over the fio.reqobt tables used by the FIO request endpoints.
+         *
+         * It maps payer/payee fio address hashes to request ids together with the first status recorded
+         * for each request, and to recordobt ids. The request, status and obt tables add rows with
+         * increasing primary keys, so the index is kept current by scanning rows past a cursor after every
+         * accepted block. The cursors at the end of each reversible block are kept: a block that does not
+         * build on the last one is a fork switch, which drops what was indexed after the fork point and
+         * scans again from there. When a table holds fewer or more rows than were indexed, rows were
+         * erased, or came back on a fork switch, and the index is reconciled with the table.
+         *
+         * The index follows the head block, rows only applied speculatively are not visible until they
+         * are included in a block. Row contents are not stored; callers read them from state by id.
+         */
+        class fio_request_index {
+        public:
+            static constexpr uint8_t no_status = 0xff;
+
+            struct range {
+                enum kind_t : uint8_t {
+                    payer_requests,
+                    payee_requests,
+                    payer_obts,
+                    payee_obts
+                };
+
+                kind_t kind;
+                uint128_t address;
+                fc::optional<uint8_t> status; ///< requests only; restrict to one status, no_status for none recorded
+            };
+
+            struct ref {
+                uint64_t id = 0;               ///< fio_request_id, or recordobt id for obt ranges
+                uint8_t status = no_status;
+                uint64_t status_id = 0;        ///< primary key of the first fioreqstss row, if status is set
+                bool obt = false;
+            };
+
+            struct page {
+                std::vector<ref> refs;
+                uint32_t more = 0;             ///< matching entries after the returned page
+            };
+
+            fio_request_index(std::shared_ptr<abi_serializer_cache> abi_cache,
+                              const fc::microseconds &max_serialization_time)
+                    : abi_cache(std::move(abi_cache)), max_serialization_time(max_serialization_time) {}
+
+            void rebuild(const chain::controller &db);
+
+            void on_accepted_block(const chain::controller &db, const chain::block_state_ptr &bsp);
+
+            /**
+             * Concatenate ranges in order and return limit entries starting at offset; limit 0 returns all.
+             */
+            page get_page(const std::vector<range> &ranges, uint32_t offset, uint32_t limit) const;
+
+        private:
+            struct request_entry {
+                uint64_t id;
+                uint128_t payer;
+                uint128_t payee;
+                uint8_t status;
+                uint64_t status_id;
+            };
+
+            struct obt_entry {
+                uint64_t id;
+                uint128_t payer;
+                uint128_t payee;
+            };
+
+            struct cursors {
+                uint64_t request = 0;
+                uint64_t status = 0;
+                uint64_t obt = 0;
+                uint32_t num_statuses = 0;           ///< status rows scanned, whether or not they were first
+            };
+
+            struct by_id;
+            struct by_status_id;
+            struct by_payer;
+            struct by_payee;
+            struct by_payer_status;
+            struct by_payee_status;
+
+            typedef boost::multi_index_container<
+                    request_entry,
+                    boost::multi_index::indexed_by<
+                            boost::multi_index::ordered_unique<boost::multi_index::tag<by_id>,
+                                    boost::multi_index::member<request_entry, uint64_t, &request_entry::id>
+                            >,
+                            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_status_id>,
+                                    boost::multi_index::member<request_entry, uint64_t, &request_entry::status_id>
+                            >,
+                            boost::multi_index::ranked_unique<boost::multi_index::tag<by_payer>,
+                                    boost::multi_index::composite_key<request_entry,
+                                            boost::multi_index::member<request_entry, uint128_t, &request_entry::payer>,
+                                            boost::multi_index::member<request_entry, uint64_t, &request_entry::id>
+                                    >
+                            >,
+                            boost::multi_index::ranked_unique<boost::multi_index::tag<by_payee>,
+                                    boost::multi_index::composite_key<request_entry,
+                                            boost::multi_index::member<request_entry, uint128_t, &request_entry::payee>,
+                                            boost::multi_index::member<request_entry, uint64_t, &request_entry::id>
+                                    >
+                            >,
+                            boost::multi_index::ranked_unique<boost::multi_index::tag<by_payer_status>,
+                                    boost::multi_index::composite_key<request_entry,
+                                            boost::multi_index::member<request_entry, uint128_t, &request_entry::payer>,
+                                            boost::multi_index::member<request_entry, uint8_t, &request_entry::status>,
+                                            boost::multi_index::member<request_entry, uint64_t, &request_entry::id>
+                                    >
+                            >,
+                            boost::multi_index::ranked_unique<boost::multi_index::tag<by_payee_status>,
+                                    boost::multi_index::composite_key<request_entry,
+                                            boost::multi_index::member<request_entry, uint128_t, &request_entry::payee>,
+                                            boost::multi_index::member<request_entry, uint8_t, &request_entry::status>,
+                                            boost::multi_index::member<request_entry, uint64_t, &request_entry::id>
+                                    >
+                            >
+                    >
+            > request_index_type;
+
+            typedef boost::multi_index_container<
+                    obt_entry,
+                    boost::multi_index::indexed_by<
+                            boost::multi_index::ordered_unique<boost::multi_index::tag<by_id>,
+                                    boost::multi_index::member<obt_entry, uint64_t, &obt_entry::id>
+                            >,
+                            boost::multi_index::ranked_unique<boost::multi_index::tag<by_payer>,
+                                    boost::multi_index::composite_key<obt_entry,
+                                            boost::multi_index::member<obt_entry, uint128_t, &obt_entry::payer>,
+                                            boost::multi_index::member<obt_entry, uint64_t, &obt_entry::id>
+                                    >
+                            >,
+                            boost::multi_index::ranked_unique<boost::multi_index::tag<by_payee>,
+                                    boost::multi_index::composite_key<obt_entry,
+                                            boost::multi_index::member<obt_entry, uint128_t, &obt_entry::payee>,
+                                            boost::multi_index::member<obt_entry, uint64_t, &obt_entry::id>
+                                    >
+                            >
+                    >
+            > obt_index_type;
+
+            void update(const chain::controller &db);
+
+            void reconcile(const chain::controller &db, const cached_abi &abi);
+
+            void scan_statuses(const chain::controller &db, const cached_abi &abi);
+
+            bool undo_after(uint32_t block_num);
+
+            void reset();
+
+            std::shared_ptr<abi_serializer_cache> abi_cache;
+            const fc::microseconds max_serialization_time;
+
+            mutable std::mutex mtx;
+            request_index_type requests;
+            obt_index_type obts;
+            cursors next;                                ///< primary keys the next scan starts at
+            std::map<uint32_t, cursors> block_cursors;   ///< next at the end of each block from the LIB on
+            chain::block_id_type last_block_id;
+        };
+
+    }
+} // eosio::chain_apis
@@ -0,0 +1,278 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/chain/types.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <map>
+#include <mutex>
+
+namespace eosio {
+    namespace chain_apis {
+        namespace fio_rows {
+
+            using chain::name;
+            using chain::uint128_t;
+            using std::string;
+            using std::vector;
+
+            /**
+             * Compiled mirrors of the FIO contract table rows read by the chain API.
+             * Rows are unpacked straight from key_value_object bytes when the deployed ABI
+             * still describes the same layout, see has_native_layout().
+             */
+            struct tokenpubaddr {
+                string token_code;
+                string chain_code;
+                string public_address;
+            };
+
+            // fio.address :: fionames
+            struct fioname {
+                uint64_t id = 0;
+                string name;
+                uint128_t namehash = 0;
+                string domain;
+                uint128_t domainhash = 0;
+                uint64_t expiration = 0;
+                chain::name owner_account;
+                vector<tokenpubaddr> addresses;
+                uint64_t bundleeligiblecountdown = 0;
+            };
+
+            // fio.address :: domains
+            struct domain {
+                uint64_t id = 0;
+                string name;
+                uint128_t domainhash = 0;
+                chain::name account;
+                uint8_t is_public = 0;
+                uint64_t expiration = 0;
+            };
+
+            // fio.address :: accountmap
+            struct eosio_name {
+                chain::name account;
+                string clientkey;
+                uint128_t keyhash = 0;
+            };
+
+            // fio.fee :: fiofees
+            struct fiofee {
+                uint64_t fee_id = 0;
+                string end_point;
+                uint128_t end_point_hash = 0;
+                uint64_t type = 0;
+                uint64_t suf_amount = 0;
+            };
+
+            // fio.reqobt :: fioreqctxts
+            struct fioreqctxt {
+                uint64_t fio_request_id = 0;
+                uint128_t payer_fio_address = 0;
+                uint128_t payee_fio_address = 0;
+                string payer_fio_address_hex_str;
+                string payee_fio_address_hex_str;
+                uint64_t time_stamp = 0;
+                string payer_fio_addr;
+                string payee_fio_addr;
+                string content;
+                string payer_key;
+                string payee_key;
+            };
+
+            // fio.reqobt :: fioreqstss
+            struct fioreqsts {
+                uint64_t id = 0;
+                uint64_t fio_request_id = 0;
+                uint64_t status = 0;
+                string metadata;
+                uint64_t time_stamp = 0;
+            };
+
+            // fio.reqobt :: recordobts
+            struct recordobt_info {
+                uint64_t id = 0;
+                uint128_t payer_fio_address = 0;
+                uint128_t payee_fio_address = 0;
+                string payer_fio_address_hex_str;
+                string payee_fio_address_hex_str;
+                uint128_t payer_fio_address_with_time = 0;
+                uint128_t payee_fio_address_with_time = 0;
+                string content;
+                uint64_t time_stamp = 0;
+                string payer_fio_addr;
+                string payee_fio_addr;
+                string payer_key;
+                string payee_key;
+            };
+
+            namespace detail {
+
+                template<typename T, typename = void>
+                struct abi_field;
+
+                template<typename Row>
+                bool struct_matches(const abi_serializer &abis, const chain::type_name &type, bool allow_trailing);
+
+                inline bool builtin_matches(const abi_serializer &abis, const chain::type_name &type,
+                                            const char *expected) {
+                    return abis.resolve_type(type) == expected;
+                }
+
+                template<>
+                struct abi_field<uint8_t> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        return builtin_matches(abis, type, "uint8");
+                    }
+                };
+
+                template<>
+                struct abi_field<uint64_t> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        return builtin_matches(abis, type, "uint64");
+                    }
+                };
+
+                template<>
+                struct abi_field<uint128_t> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        return builtin_matches(abis, type, "uint128");
+                    }
+                };
+
+                template<>
+                struct abi_field<string> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        return builtin_matches(abis, type, "string");
+                    }
+                };
+
+                template<>
+                struct abi_field<chain::name> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        return builtin_matches(abis, type, "name");
+                    }
+                };
+
+                template<typename T>
+                struct abi_field<vector<T>> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        const auto resolved = abis.resolve_type(type);
+                        if (!abis.is_array(resolved)) return false;
+                        return abi_field<T>::matches(abis, resolved.substr(0, resolved.size() - 2));
+                    }
+                };
+
+                // nested structs must match exactly, a trailing field would shift every following element
+                template<typename T>
+                struct abi_field<T, std::enable_if_t<fc::reflector<T>::is_defined::value>> {
+                    static bool matches(const abi_serializer &abis, const chain::type_name &type) {
+                        return struct_matches<T>(abis, type, false);
+                    }
+                };
+
+                template<typename Row>
+                struct field_visitor {
+                    const abi_serializer &abis;
+                    const vector<chain::field_def> &fields;
+                    mutable size_t pos = 0;
+                    mutable bool ok = true;
+
+                    template<typename Member, class Class, Member (Class::*member)>
+                    void operator()(const char *name) const {
+                        if (!ok) return;
+                        if (pos >= fields.size() || fields[pos].name != name ||
+                            !abi_field<Member>::matches(abis, fields[pos].type)) {
+                            ok = false;
+                        }
+                        ++pos;
+                    }
+                };
+
+                template<typename Row>
+                bool struct_matches(const abi_serializer &abis, const chain::type_name &type, bool allow_trailing) {
+                    if (!abis.is_struct(type)) return false;
+                    const auto &st = abis.get_struct(type);
+                    if (!st.base.empty()) return false;
+                    field_visitor<Row> v{abis, st.fields};
+                    fc::reflector<Row>::visit(v);
+                    return v.ok && (allow_trailing || v.pos == st.fields.size());
+                }
+
+            } // namespace detail
+
+            /**
+             * @return true if the rows of table can be unpacked directly into Row.
+             *
+             * The layout check runs once per (ABI hash, table); a contract upgrade that changes
+             * the row layout produces a new ABI hash and makes callers fall back to the ABI path.
+             * Fields appended after the ones Row knows about are allowed since unpack only reads
+             * a prefix of the row.
+             */
+            template<typename Row>
+            bool has_native_layout(const cached_abi &abi, const name &table) {
+                static std::mutex mtx;
+                static std::map<std::pair<fc::sha256, uint64_t>, bool> checked;
+
+                const auto key = std::make_pair(abi.abi_hash, table.value);
+                std::lock_guard<std::mutex> g(mtx);
+                auto itr = checked.find(key);
+                if (itr == checked.end()) {
+                    const auto type = abi.serializer.get_table_type(table);
+                    bool matches = !type.empty() && detail::struct_matches<Row>(abi.serializer, type, true);
+                    if (!matches) {
+                        wlog("ABI layout of table ${t} does not match the native decoder, using ABI serializer",
+                             ("t", table));
+                    }
+                    itr = checked.emplace(key, matches).first;
+                }
+                return itr->second;
+            }
+
+            template<typename Row>
+            Row unpack_row(const chain::key_value_object &obj) {
+                Row row;
+                fc::datastream<const char *> ds(obj.value.data(), obj.value.size());
+                fc::raw::unpack(ds, row);
+                return row;
+            }
+
+            /**
+             * Decode one row of table, natively when has_native_layout() allows it and through the ABI otherwise.
+             */
+            template<typename Row>
+            Row decode_row(const cached_abi &abi, const name &table, const chain::key_value_object &obj,
+                           const fc::microseconds &max_serialization_time, bool short_path = false) {
+                if (has_native_layout<Row>(abi, table)) {
+                    return unpack_row<Row>(obj);
+                }
+                vector<char> data(obj.value.data(), obj.value.data() + obj.value.size());
+                return abi.serializer.binary_to_variant(abi.serializer.get_table_type(table), data,
+                                                        max_serialization_time, short_path).template as<Row>();
+            }
+
+        } // namespace fio_rows
+    }
+} // eosio::chain_apis
+
+FC_REFLECT(eosio::chain_apis::fio_rows::tokenpubaddr, (token_code)(chain_code)(public_address))
+FC_REFLECT(eosio::chain_apis::fio_rows::fioname,
+           (id)(name)(namehash)(domain)(domainhash)(expiration)(owner_account)(addresses)(bundleeligiblecountdown))
+FC_REFLECT(eosio::chain_apis::fio_rows::domain, (id)(name)(domainhash)(account)(is_public)(expiration))
+FC_REFLECT(eosio::chain_apis::fio_rows::eosio_name, (account)(clientkey)(keyhash))
+FC_REFLECT(eosio::chain_apis::fio_rows::fiofee, (fee_id)(end_point)(end_point_hash)(type)(suf_amount))
+FC_REFLECT(eosio::chain_apis::fio_rows::fioreqctxt,
+           (fio_request_id)(payer_fio_address)(payee_fio_address)(payer_fio_address_hex_str)(payee_fio_address_hex_str)
+                   (time_stamp)(payer_fio_addr)(payee_fio_addr)(content)(payer_key)(payee_key))
+FC_REFLECT(eosio::chain_apis::fio_rows::fioreqsts, (id)(fio_request_id)(status)(metadata)(time_stamp))
+FC_REFLECT(eosio::chain_apis::fio_rows::recordobt_info,
+           (id)(payer_fio_address)(payee_fio_address)(payer_fio_address_hex_str)(payee_fio_address_hex_str)
+                   (payer_fio_address_with_time)(payee_fio_address_with_time)(content)(time_stamp)(payer_fio_addr)
+                   (payee_fio_addr)(payer_key)(payee_key))
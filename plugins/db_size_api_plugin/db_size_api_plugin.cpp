@@ -36,7 +36,8 @@ namespace eosio {
     }
 
     db_size_stats db_size_api_plugin::get() {
-        const chainbase::database &db = app().get_plugin<chain_plugin>().chain().db();
+        const auto &chain_plug = app().get_plugin<chain_plugin>();
+        const chainbase::database &db = chain_plug.chain().db();
         db_size_stats ret;
 
         ret.free_bytes = db.get_segment_manager()->get_free_memory();
@@ -47,6 +48,8 @@ namespace eosio {
         for (const auto &i : indices)
             ret.indices.emplace_back(db_size_index_count{i.second, i.first});
 
+        ret.abi_cache = chain_plug.get_abi_serializer_cache()->get_stats();
+
         return ret;
     }
 
@@ -23,6 +23,7 @@ namespace eosio {
         uint64_t used_bytes;
         uint64_t size;
         vector<db_size_index_count> indices;
+        chain_apis::abi_serializer_cache_stats abi_cache;
     };
 
     class db_size_api_plugin : public plugin<db_size_api_plugin> {
@@ -57,4 +58,4 @@ namespace eosio {
 }
 
 FC_REFLECT(eosio::db_size_index_count, (index)(row_count))
-FC_REFLECT(eosio::db_size_stats, (free_bytes)(used_bytes)(size)(indices))
\ No newline at end of file
+FC_REFLECT(eosio::db_size_stats, (free_bytes)(used_bytes)(size)(indices)(abi_cache))
\ No newline at end of file
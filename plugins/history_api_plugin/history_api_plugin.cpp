@@ -33,6 +33,26 @@ namespace eosio {
           } \
        }}
 
+// actions are selected on the main thread, their conversion with the contract ABIs runs on an http thread
+#define GET_ACTIONS_CALL(api_handle) \
+{std::string("/v1/history/get_actions"), \
+   [api_handle](string, string body, url_response_callback cb) mutable { \
+          try { \
+             if (body.empty()) body = "{}"; \
+             auto page = api_handle.select_actions(fc::json::from_string(body).as<history_apis::read_only::get_actions_params>()); \
+             app().get_plugin<http_plugin>().post_http_thread_pool([page{std::move(page)}, body, cb]() mutable { \
+                try { \
+                   fc::variant result( history_apis::read_only::convert_actions(std::move(page)) ); \
+                   cb(200, std::move(result)); \
+                } catch (...) { \
+                   http_plugin::handle_exception("history", "get_actions", body, cb); \
+                } \
+             }); \
+          } catch (...) { \
+             http_plugin::handle_exception("history", "get_actions", body, cb); \
+          } \
+       }}
+
 #define CHAIN_RO_CALL(call_name) CALL(history, ro_api, history_apis::read_only, call_name)
 //#define CHAIN_RW_CALL(call_name) CALL(history, rw_api, history_apis::read_write, call_name)
 
@@ -43,7 +63,7 @@ namespace eosio {
 
         app().get_plugin<http_plugin>().add_api({
 //      CHAIN_RO_CALL(get_transaction),
-                                                        CHAIN_RO_CALL(get_actions),
+                                                        GET_ACTIONS_CALL(ro_api),
                                                         CHAIN_RO_CALL(get_transaction),
                                                         CHAIN_RO_CALL(get_block_txids),
                                                         CHAIN_RO_CALL(get_key_accounts),
@@ -1,6 +1,7 @@
 #include <eosio/history_plugin/history_plugin.hpp>
 #include <eosio/history_plugin/account_control_history_object.hpp>
 #include <eosio/history_plugin/public_key_history_object.hpp>
+#include <eosio/history_plugin/history_store.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
@@ -143,7 +144,9 @@ namespace eosio {
         std::set<filter_entry> filter_on;
         std::set<filter_entry> filter_out;
         chain_plugin *chain_plug = nullptr;
+        std::unique_ptr<history_store> store; ///< irreversible history, when the segments backend is selected
         fc::optional<scoped_connection> applied_transaction_connection;
+        fc::optional<scoped_connection> irreversible_block_connection;
 
         bool filter(const action_trace &act) {
             bool pass_on = false;
@@ -262,18 +265,22 @@ namespace eosio {
             return result;
         }
 
+        /// one past the highest sequence number recorded for account n, in chainbase or the history store
+        int64_t next_account_seq(account_name n) const {
+            const auto &idx = chain_plug->chain().hidb().get_index<account_history_index, by_account_action_seq>();
+            auto itr = idx.lower_bound(boost::make_tuple(name(n.value + 1), 0));
+            if (itr != idx.begin() && (--itr)->account == n)
+                return itr->account_sequence_num + 1;
+            return store ? store->next_account_sequence(n) : 0;
+        }
+
         void record_account_action(account_name n, const action_trace &act) {
             auto &chain = chain_plug->chain();
             chainbase::database& db = const_cast<chainbase::database&>( chain.hidb() ); // Override read-only access to state DB (highly unrecommended practice!)
             chainbase::database& hdb = const_cast<chainbase::database&>( chain.hdb() ); // Override read-only access to state DB (highly unrecommended practice!)
 
             const auto &idx = db.get_index<account_history_index, by_account_action_seq>();
-            auto itr = idx.lower_bound(boost::make_tuple(name(n.value + 1), 0));
-
-            int64_t asn = 0;
-            if (itr != idx.begin()) --itr;
-            if (itr->account == n)
-                asn = itr->account_sequence_num + 1;
+            const int64_t asn = next_account_seq(n);
 
             const auto &a = db.create<account_history_object>([&](auto &aho) {
                 aho.account = n;
@@ -281,7 +288,8 @@ namespace eosio {
                 aho.account_sequence_num = asn;
             });
 
-            if ( asn >= history_per_account ) {
+            // with a history store, retention is by segment and only the reversible tail stays in chainbase
+            if ( !store && asn >= history_per_account ) {
               auto ahi_itr = idx.lower_bound( boost::make_tuple( n, asn - history_per_account ) );
 
               const auto& target = hdb.get<action_history_object, by_action_sequence_num>(ahi_itr->action_sequence_num);
@@ -352,6 +360,46 @@ namespace eosio {
                 on_system_action(at);
         }
 
+        /**
+         * Move the actions of blocks up to bsp into the history store, dropping them from chainbase.
+         *
+         * This runs inside the undo session of the block being committed, so a fork switch can bring back
+         * actions that were already stored; those are only dropped again.
+         */
+        void on_irreversible_block(const block_state_ptr &bsp) {
+            auto &chain = chain_plug->chain();
+            chainbase::database& hdb = const_cast<chainbase::database&>( chain.hdb() ); // Override read-only access to state DB (highly unrecommended practice!)
+            chainbase::database& hidb = const_cast<chainbase::database&>( chain.hidb() ); // Override read-only access to state DB (highly unrecommended practice!)
+
+            const auto &idx = hdb.get_index<action_history_index, by_action_sequence_num>();
+            const auto &account_idx = hidb.get_index<account_history_index, by_account_action_seq>();
+            for (auto itr = idx.begin(); itr != idx.end() && itr->block_num <= bsp->block_num; itr = idx.begin()) {
+                fc::datastream<const char *> ds(itr->packed_action_trace.data(), itr->packed_action_trace.size());
+                action_trace t;
+                fc::raw::unpack(ds, t);
+
+                // archived in global order, so the action is the oldest one left of each of its accounts
+                std::vector<std::pair<account_name, int64_t>> accounts;
+                for (auto n : account_set(t)) {
+                    auto aitr = account_idx.lower_bound(boost::make_tuple(n, 0));
+                    if (aitr == account_idx.end() || aitr->account != n ||
+                        aitr->action_sequence_num != itr->action_sequence_num)
+                        continue;
+                    accounts.emplace_back(n, aitr->account_sequence_num);
+                    hidb.remove(*aitr);
+                }
+
+                if (itr->action_sequence_num > store->last_global_sequence()) {
+                    store->append(history_store::action_record{
+                            itr->action_sequence_num, itr->block_num, itr->block_time, itr->trx_id,
+                            std::vector<char>(itr->packed_action_trace.begin(), itr->packed_action_trace.end())},
+                                  accounts);
+                }
+                hdb.remove(*itr);
+            }
+            store->commit_block(bsp->block_num);
+        }
+
         void on_applied_transaction(const transaction_trace_ptr &trace) {
             if (!trace->receipt || (trace->receipt->status != transaction_receipt_header::executed &&
                                     trace->receipt->status != transaction_receipt_header::soft_fail))
@@ -380,7 +428,19 @@ namespace eosio {
                  "Do not track actions which match receiver:action:actor. Action and Actor both blank excludes all from Reciever. Actor blank excludes all from reciever:action. Receiver may not be blank.");
         cfg.add_options()
                 ("history-per-account", bpo::value<uint64_t>()->default_value(1000),
-                "Maximum history limit, i.e., the number of newest history actions stored, per account.");
+                "Maximum history limit, i.e., the number of newest history actions stored, per account. Ignored by the segments backend.");
+        cfg.add_options()
+                ("history-backend", bpo::value<string>()->default_value("chainbase"),
+                 "Where history is kept: chainbase keeps all of it in the history databases; segments keeps only reversible history there and moves irreversible history to append-only segment files.");
+        cfg.add_options()
+                ("history-segments-dir", bpo::value<bfs::path>()->default_value("history-segments"),
+                 "The location of the history segment files of the segments backend (absolute path or relative to application data dir)");
+        cfg.add_options()
+                ("history-segment-blocks", bpo::value<uint32_t>()->default_value(1000000),
+                 "Number of blocks whose history each segment file covers.");
+        cfg.add_options()
+                ("history-segments-retained", bpo::value<uint32_t>()->default_value(0),
+                 "Number of sealed history segments whose actions are kept, older ones only keep their account index. 0 keeps all.");
     }
 
     void history_plugin::plugin_initialize(const variables_map &options) {
@@ -434,6 +494,21 @@ namespace eosio {
             hidb.add_index<account_control_history_multi_index>();
             hidb.add_index<public_key_history_multi_index>();
 
+            const auto backend = options.at("history-backend").as<string>();
+            EOS_ASSERT(backend == "chainbase" || backend == "segments", plugin_config_exception,
+                       "Invalid value ${b} for --history-backend, expected chainbase or segments", ("b", backend));
+            if (backend == "segments") {
+                auto dir = options.at("history-segments-dir").as<bfs::path>();
+                if (dir.is_relative())
+                    dir = app().data_dir() / dir;
+                my->store = std::make_unique<history_store>(dir, options.at("history-segment-blocks").as<uint32_t>(),
+                                                            options.at("history-segments-retained").as<uint32_t>());
+                my->irreversible_block_connection.emplace(
+                        chain.irreversible_block.connect([&](const block_state_ptr &bsp) {
+                            my->on_irreversible_block(bsp);
+                        }));
+            }
+
             my->applied_transaction_connection.emplace(
                     chain.applied_transaction.connect(
                             [&](std::tuple<const transaction_trace_ptr &, const signed_transaction &> t) {
@@ -447,11 +522,17 @@ namespace eosio {
 
     void history_plugin::plugin_shutdown() {
         my->applied_transaction_connection.reset();
+        my->irreversible_block_connection.reset();
+        my->store.reset();
     }
 
 
     namespace history_apis {
         read_only::get_actions_result read_only::get_actions(const read_only::get_actions_params &params) const {
+            return convert_actions(select_actions(params));
+        }
+
+        read_only::get_actions_page read_only::select_actions(const read_only::get_actions_params &params) const {
             // edump((params));
             auto &chain = history->chain_plug->chain();
             const auto& hdb  = chain.hdb();
@@ -467,14 +548,9 @@ namespace eosio {
             auto n = params.account_name;
             // idump((pos));
             if (pos == -1) {
-                auto itr = idx.lower_bound(boost::make_tuple(name(n.value + 1), 0));
-                if (itr == idx.begin()) {
-                    if (itr->account == n)
-                        pos = itr->account_sequence_num + 1;
-                } else if (itr != idx.begin()) --itr;
-
-                if (itr->account == n)
-                    pos = itr->account_sequence_num + 1;
+                const auto next = history->next_account_seq(n);
+                if (next > 0)
+                    pos = next;
             }
 
             if (pos == -1) pos = 0xfffffffffffffff;
@@ -491,56 +567,92 @@ namespace eosio {
 
             // idump((start)(end));
 
-            // Find latest stored action (will have lowest available ACCOUNT seq number)
-            const auto max_itr = idx.lower_bound( boost::make_tuple( n, 0 ) );
-            const auto min_seq_number = max_itr->account_sequence_num;
-            if (min_seq_number > 0) {  // Reject outside of retention policy boundary.
-              const auto max_seq_number = min_seq_number + history->history_per_account;
-              EOS_ASSERT( start >= min_seq_number, chain::plugin_range_not_satisfiable, "start position is earlier than account retention policy (${p}). Latest available: ${l}. Requested start: ${r}", ("p",history->history_per_account)("l",min_seq_number)("r",start) );
-              // Below should actually never occur..?
-              EOS_ASSERT( end >= min_seq_number, chain::plugin_range_not_satisfiable,   "end position is earlier than account retention policy (${p}). Latest available: ${l}. Requested end: ${r}", ("p",history->history_per_account)("l",min_seq_number)("r",end) );
+            // (account sequence, global sequence) of the requested actions, stored ones before reversible ones
+            vector<history_store::account_action> refs;
+            if (history->store) {
+                const auto first_seq = history->store->first_account_sequence(n);
+                if (first_seq && *first_seq > 0) {  // Reject outside of retained segments.
+                  EOS_ASSERT( start >= *first_seq, chain::plugin_range_not_satisfiable, "start position is earlier than the retained history segments. Latest available: ${l}. Requested start: ${r}", ("l",*first_seq)("r",start) );
+                }
+                refs = history->store->get_account_actions(n, start, end);
+            } else {
+              // Find latest stored action (will have lowest available ACCOUNT seq number)
+              const auto max_itr = idx.lower_bound( boost::make_tuple( n, 0 ) );
+              const auto min_seq_number = max_itr->account_sequence_num;
+              if (min_seq_number > 0) {  // Reject outside of retention policy boundary.
+                const auto max_seq_number = min_seq_number + history->history_per_account;
+                EOS_ASSERT( start >= min_seq_number, chain::plugin_range_not_satisfiable, "start position is earlier than account retention policy (${p}). Latest available: ${l}. Requested start: ${r}", ("p",history->history_per_account)("l",min_seq_number)("r",start) );
+                // Below should actually never occur..?
+                EOS_ASSERT( end >= min_seq_number, chain::plugin_range_not_satisfiable,   "end position is earlier than account retention policy (${p}). Latest available: ${l}. Requested end: ${r}", ("p",history->history_per_account)("l",min_seq_number)("r",end) );
+              }
             }
 
             auto start_itr = idx.lower_bound(boost::make_tuple(n, start));
             auto end_itr = idx.upper_bound(boost::make_tuple(n, end));
+            for (; start_itr != end_itr; ++start_itr) {
+                const history_store::account_action ref{start_itr->account_sequence_num, start_itr->action_sequence_num};
+                if (history->store) {
+                    history->store->merge_reversible(refs, ref);
+                } else {
+                    refs.push_back(ref);
+                }
+            }
+
+            const auto abi_cache = history->chain_plug->get_abi_serializer_cache();
 
             auto start_time = fc::time_point::now();
             auto end_time = start_time;
 
-            get_actions_result result;
+            get_actions_page result;
             result.last_irreversible_block = chain.last_irreversible_block_num();
-            while (start_itr != end_itr) {
+            result.abi_serializer_max_time = abi_serializer_max_time;
+            result.actions.reserve(refs.size());
+            auto ref_begin = refs.begin();
+            auto ref_end = refs.end();
+            while (ref_begin != ref_end) {
                 uint64_t action_sequence_num;
                 int64_t account_sequence_num;
                 if (params.pos < 0) {
-                --end_itr;
-                action_sequence_num = end_itr->action_sequence_num;
-                account_sequence_num = end_itr->account_sequence_num;
+                --ref_end;
+                action_sequence_num = ref_end->global_sequence;
+                account_sequence_num = ref_end->account_sequence_num;
                 } else {
-                action_sequence_num = start_itr->action_sequence_num;
-                account_sequence_num = start_itr->account_sequence_num;
-                ++start_itr;
+                action_sequence_num = ref_begin->global_sequence;
+                account_sequence_num = ref_begin->account_sequence_num;
+                ++ref_begin;
                 }
 
-                const auto& a = hdb.get<action_history_object, by_action_sequence_num>( action_sequence_num );
-                fc::datastream<const char *> ds(a.packed_action_trace.data(), a.packed_action_trace.size());
+                uint32_t block_num;
+                block_timestamp_type block_time;
                 action_trace t;
-                fc::raw::unpack(ds, t);
-                if (params.pos < 0) {
-                  result.actions.emplace(result.actions.begin(), ordered_action_result{
-                                        action_sequence_num,
-                                        account_sequence_num,
-                                        a.block_num, a.block_time,
-                                        chain.to_variant_with_abi(t, abi_serializer_max_time)
-                                        });
+                if (const auto* a = hdb.find<action_history_object, by_action_sequence_num>( action_sequence_num )) {
+                  fc::datastream<const char *> ds(a->packed_action_trace.data(), a->packed_action_trace.size());
+                  fc::raw::unpack(ds, t);
+                  block_num = a->block_num;
+                  block_time = a->block_time;
                 } else {
-                  result.actions.emplace_back( ordered_action_result{
+                  const auto stored = history->store ? history->store->get_action( action_sequence_num ) : fc::optional<history_store::action_record>();
+                  EOS_ASSERT( stored, chain::plugin_exception, "action ${s} is missing from history", ("s",action_sequence_num) );
+                  fc::datastream<const char *> ds(stored->packed_action_trace.data(), stored->packed_action_trace.size());
+                  fc::raw::unpack(ds, t);
+                  block_num = stored->block_num;
+                  block_time = stored->block_time;
+                }
+                // resolved once per contract, the conversion then reuses the same serializer across the page
+                if (result.abis.find(t.act.account) == result.abis.end()) {
+                  chain_apis::cached_abi_ptr abi;
+                  try {
+                    abi = abi_cache->get(chain, t.act.account, abi_serializer_max_time);
+                  } catch (const chain::account_query_exception &) {
+                  }
+                  result.abis.emplace(t.act.account, std::move(abi));
+                }
+                result.actions.push_back(get_actions_page::entry{
                                         action_sequence_num,
                                         account_sequence_num,
-                                        a.block_num, a.block_time,
-                                        chain.to_variant_with_abi(t, abi_serializer_max_time)
+                                        block_num, block_time,
+                                        std::move(t)
                                         });
-                }
 
                 end_time = fc::time_point::now();
                 if (end_time - start_time > fc::microseconds(100000)) {
@@ -548,6 +660,25 @@ namespace eosio {
                     break;
                 }
             }
+            // collected newest first for a negative pos, results are always in ascending order
+            if (params.pos < 0)
+                std::reverse(result.actions.begin(), result.actions.end());
+            return result;
+        }
+
+        read_only::get_actions_result read_only::convert_actions(get_actions_page &&page) {
+            get_actions_result result;
+            result.last_irreversible_block = page.last_irreversible_block;
+            result.time_limit_exceeded_error = page.time_limit_exceeded_error;
+
+            const chain_apis::cached_abi_resolver resolver(page.abis);
+            result.actions.reserve(page.actions.size());
+            for (auto &a : page.actions) {
+                fc::variant trace;
+                abi_serializer::to_variant(a.trace, trace, resolver, page.abi_serializer_max_time);
+                result.actions.push_back(ordered_action_result{a.global_action_seq, a.account_action_seq,
+                                                               a.block_num, a.block_time, std::move(trace)});
+            }
             return result;
         }
 
@@ -582,22 +713,11 @@ namespace eosio {
             const auto &idx = db.get_index<action_history_index, by_trx_id>();
             auto itr = idx.lower_bound(boost::make_tuple(input_id));
 
-            bool in_history = (itr != idx.end() && txn_id_matched(itr->trx_id));
-
-            if (!in_history && !p.block_num_hint) {
-              EOS_THROW(chain::plugin_range_not_satisfiable, "Transaction ${id} not found in limited history and no block hint was given",
-                ("id",p.id));
-            }
-            if (!in_history && p.block_num_hint == 0) {  // Pro-tip, your tx is probable not in block 0... default param?
-              EOS_THROW(chain::plugin_range_not_satisfiable, "Transaction ${id} not found in limited history and block hint of 0 was given",
-                ("id",p.id));
-            }
-
             get_transaction_result result;
 
+            bool in_history = (itr != idx.end() && txn_id_matched(itr->trx_id));
             if (in_history) {
                 result.id = itr->trx_id;
-                result.last_irreversible_block = chain.last_irreversible_block_num();
                 result.block_num = itr->block_num;
                 result.block_time = itr->block_time;
 
@@ -610,6 +730,33 @@ namespace eosio {
 
                     ++itr;
                 }
+            } else if (history->store) {
+                const auto stored_id = history->store->lower_bound_transaction(input_id);
+                if (stored_id && txn_id_matched(*stored_id)) {
+                    for (const auto &a : history->store->get_transaction_actions(*stored_id)) {
+                        fc::datastream<const char *> ds(a.packed_action_trace.data(), a.packed_action_trace.size());
+                        action_trace t;
+                        fc::raw::unpack(ds, t);
+                        result.traces.emplace_back(chain.to_variant_with_abi(t, abi_serializer_max_time));
+                        result.block_num = a.block_num;
+                        result.block_time = a.block_time;
+                    }
+                    result.id = *stored_id;
+                    in_history = true;
+                }
+            }
+
+            if (!in_history && !p.block_num_hint) {
+              EOS_THROW(chain::plugin_range_not_satisfiable, "Transaction ${id} not found in limited history and no block hint was given",
+                ("id",p.id));
+            }
+            if (!in_history && p.block_num_hint == 0) {  // Pro-tip, your tx is probable not in block 0... default param?
+              EOS_THROW(chain::plugin_range_not_satisfiable, "Transaction ${id} not found in limited history and block hint of 0 was given",
+                ("id",p.id));
+            }
+
+            if (in_history) {
+                result.last_irreversible_block = chain.last_irreversible_block_num();
 
                 auto blk = chain.fetch_block_by_number(result.block_num);
                 if (blk || chain.is_building_block()) {
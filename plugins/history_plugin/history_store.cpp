@@ -0,0 +1,445 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/history_plugin/history_store.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <tuple>
+
+namespace eosio {
+
+    using namespace chain;
+
+    namespace {
+
+        const char *const actions_ext = ".actions";
+        const char *const traces_ext = ".traces";
+        const char *const accounts_ext = ".accounts";
+        const char *const trxids_ext = ".trxids";
+
+        template<typename T>
+        void write_sorted(const fc::path &file, const std::vector<T> &entries) {
+            const fc::path tmp = file.string() + ".tmp";
+            {
+                std::ofstream out(tmp.generic_string(), std::ios::binary | std::ios::trunc);
+                out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+                out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(T));
+                out.flush();
+            }
+            fc::rename(tmp, file);
+        }
+
+        bool account_less(uint64_t account, int64_t seq, uint64_t other_account, int64_t other_seq) {
+            return std::tie(account, seq) < std::tie(other_account, other_seq);
+        }
+
+    } // anonymous namespace
+
+    void history_store::mapped_file::open(const fc::path &file) {
+        const auto size = fc::file_size(file);
+        if (size > 0) {
+            mapping = boost::interprocess::file_mapping(file.generic_string().c_str(), boost::interprocess::read_only);
+            region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only, 0, size);
+        }
+    }
+
+    history_store::history_store(const fc::path &dir, uint32_t blocks_per_segment, uint32_t retained_segments)
+            : dir(dir), blocks_per_segment(blocks_per_segment), retained_segments(retained_segments) {
+        static_assert(sizeof(action_row) == 64, "action_row is stored on disk");
+        static_assert(sizeof(account_entry) == 24, "account_entry is stored on disk");
+        static_assert(sizeof(trx_entry) == 40, "trx_entry is stored on disk");
+        EOS_ASSERT(blocks_per_segment > 0, plugin_config_exception, "history segments must hold at least one block");
+        load();
+    }
+
+    fc::path history_store::segment_file(uint32_t first_block, const char *extension) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%010u%s", first_block, extension);
+        return dir / name;
+    }
+
+    uint32_t history_store::segment_start(uint32_t block_num) const {
+        return (std::max<uint32_t>(block_num, 1) - 1) / blocks_per_segment * blocks_per_segment + 1;
+    }
+
+    void history_store::load() {
+        if (!fc::exists(dir)) fc::create_directories(dir);
+
+        const fc::path head_path = dir / "head";
+        if (fc::exists(head_path) && fc::file_size(head_path) > 0) {
+            EOS_ASSERT(fc::file_size(head_path) == sizeof(head), plugin_exception,
+                       "unexpected size of history store head ${f}", ("f", head_path));
+            std::ifstream in(head_path.generic_string(), std::ios::binary);
+            in.read(reinterpret_cast<char *>(&head), sizeof(head));
+        } else {
+            std::ofstream create(head_path.generic_string(), std::ios::binary | std::ios::trunc);
+        }
+        head_file.exceptions(std::fstream::failbit | std::fstream::badbit);
+        head_file.open(head_path.generic_string(), std::ios::binary | std::ios::in | std::ios::out);
+
+        std::set<uint32_t> segments;
+        for (boost::filesystem::directory_iterator itr(dir.string()), end; itr != end; ++itr) {
+            if (itr->path().extension() != accounts_ext) continue;
+            segments.insert(static_cast<uint32_t>(std::stoul(itr->path().stem().string())));
+        }
+        for (const auto first_block : segments) {
+            if (head.open_first_block != 0 && first_block < head.open_first_block) {
+                open_sealed_segment(first_block);
+            } else if (first_block > head.open_first_block) {
+                // started after the head was last written
+                for (const auto *ext : {actions_ext, traces_ext, accounts_ext, trxids_ext}) {
+                    boost::filesystem::remove(segment_file(first_block, ext).string());
+                }
+            }
+        }
+        if (head.open_first_block != 0) load_open_segment();
+
+        ilog("Opened history store ${d} with ${s} sealed segments, last block ${b}",
+             ("d", dir)("s", sealed.size())("b", head.last_block));
+    }
+
+    void history_store::open_sealed_segment(uint32_t first_block) {
+        auto seg = std::make_unique<sealed_segment>();
+        seg->first_block = first_block;
+        seg->accounts.open(segment_file(first_block, accounts_ext));
+        if (fc::exists(segment_file(first_block, actions_ext))) {
+            seg->retained = true;
+            seg->actions.open(segment_file(first_block, actions_ext));
+            seg->traces.open(segment_file(first_block, traces_ext));
+            seg->trxids.open(segment_file(first_block, trxids_ext));
+        } else {
+            // left behind if retention was interrupted
+            boost::filesystem::remove(segment_file(first_block, traces_ext).string());
+            boost::filesystem::remove(segment_file(first_block, trxids_ext).string());
+        }
+        sealed.emplace_back(std::move(seg));
+    }
+
+    void history_store::load_open_segment() {
+        const auto first_block = head.open_first_block;
+        if (!fc::exists(segment_file(first_block, actions_ext))) {
+            // the head was written on roll over, but the new segment's files were not created yet
+            EOS_ASSERT(head.rows == 0, plugin_exception, "history segment ${f} is missing",
+                       ("f", segment_file(first_block, actions_ext)));
+            create_open_segment();
+            return;
+        }
+        {
+            mapped_file actions;
+            actions.open(segment_file(first_block, actions_ext));
+            EOS_ASSERT(actions.size() / sizeof(action_row) >= head.rows, plugin_exception,
+                       "history segment ${f} has fewer actions than recorded in its head",
+                       ("f", segment_file(first_block, actions_ext)));
+            const auto *rows = reinterpret_cast<const action_row *>(actions.data());
+            open_rows.assign(rows, rows + head.rows);
+
+            mapped_file accounts;
+            accounts.open(segment_file(first_block, accounts_ext));
+            EOS_ASSERT(accounts.size() / sizeof(account_entry) >= head.account_entries, plugin_exception,
+                       "history segment ${f} has fewer account entries than recorded in its head",
+                       ("f", segment_file(first_block, accounts_ext)));
+            const auto *entries = reinterpret_cast<const account_entry *>(accounts.data());
+            for (uint64_t i = 0; i < head.account_entries; ++i) {
+                open_accounts.emplace(std::make_pair(entries[i].account, entries[i].account_sequence_num),
+                                      entries[i].global_sequence);
+            }
+        }
+
+        for (uint64_t i = 0; i < open_rows.size(); ++i) {
+            transaction_id_type id;
+            memcpy(id.data(), open_rows[i].trx_id, sizeof(open_rows[i].trx_id));
+            open_trxs.emplace(id, i);
+        }
+        if (!open_rows.empty()) open_traces_size = open_rows.back().trace_offset + open_rows.back().trace_size;
+
+        boost::filesystem::resize_file(segment_file(first_block, actions_ext).string(), head.rows * sizeof(action_row));
+        boost::filesystem::resize_file(segment_file(first_block, traces_ext).string(), open_traces_size);
+        boost::filesystem::resize_file(segment_file(first_block, accounts_ext).string(),
+                                       head.account_entries * sizeof(account_entry));
+        create_open_segment();
+    }
+
+    void history_store::create_open_segment() {
+        for (auto *out : {&actions_out, &traces_out, &accounts_out}) {
+            out->exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        }
+        actions_out.open(segment_file(head.open_first_block, actions_ext).generic_string(), std::ios::binary | std::ios::app);
+        traces_out.open(segment_file(head.open_first_block, traces_ext).generic_string(), std::ios::binary | std::ios::app);
+        accounts_out.open(segment_file(head.open_first_block, accounts_ext).generic_string(), std::ios::binary | std::ios::app);
+    }
+
+    void history_store::write_head() {
+        head_file.seekp(0);
+        head_file.write(reinterpret_cast<const char *>(&head), sizeof(head));
+        head_file.flush();
+    }
+
+    void history_store::roll_to(uint32_t block_num) {
+        const auto first_block = segment_start(block_num);
+        if (first_block == head.open_first_block) return;
+        EOS_ASSERT(first_block > head.open_first_block, plugin_exception,
+                   "history store cannot go back to block ${b} from segment ${s}",
+                   ("b", block_num)("s", head.open_first_block));
+
+        if (head.open_first_block != 0) seal();
+        head.open_first_block = first_block;
+        head.rows = 0;
+        head.account_entries = 0;
+        write_head();
+        create_open_segment();
+    }
+
+    void history_store::seal() {
+        actions_out.close();
+        traces_out.close();
+        accounts_out.close();
+
+        const auto first_block = head.open_first_block;
+        if (open_rows.empty()) {
+            for (const auto *ext : {actions_ext, traces_ext, accounts_ext}) {
+                boost::filesystem::remove(segment_file(first_block, ext).string());
+            }
+            return;
+        }
+
+        // std::map and std::multimap already iterate in the sorted order used for lookups
+        std::vector<account_entry> accounts;
+        accounts.reserve(open_accounts.size());
+        for (const auto &a : open_accounts) {
+            accounts.push_back(account_entry{a.first.first, a.first.second, a.second});
+        }
+        std::vector<trx_entry> trxs;
+        trxs.reserve(open_trxs.size());
+        for (const auto &t : open_trxs) {
+            trx_entry e;
+            memcpy(e.trx_id, t.first.data(), sizeof(e.trx_id));
+            e.row = t.second;
+            trxs.push_back(e);
+        }
+        write_sorted(segment_file(first_block, trxids_ext), trxs);
+        write_sorted(segment_file(first_block, accounts_ext), accounts);
+
+        open_sealed_segment(first_block);
+        open_rows.clear();
+        open_accounts.clear();
+        open_trxs.clear();
+        open_traces_size = 0;
+        ilog("Sealed history segment ${f} with ${n} actions", ("f", segment_file(first_block, actions_ext))("n", sealed.back()->row_count()));
+
+        apply_retention();
+    }
+
+    void history_store::apply_retention() {
+        if (retained_segments == 0) return;
+        auto retained = std::count_if(sealed.begin(), sealed.end(), [](const auto &s) { return s->retained; });
+        for (auto &seg : sealed) {
+            if (retained <= retained_segments) break;
+            if (!seg->retained) continue;
+            seg->retained = false;
+            seg->actions = mapped_file();
+            seg->traces = mapped_file();
+            seg->trxids = mapped_file();
+            boost::filesystem::remove(segment_file(seg->first_block, actions_ext).string());
+            boost::filesystem::remove(segment_file(seg->first_block, traces_ext).string());
+            boost::filesystem::remove(segment_file(seg->first_block, trxids_ext).string());
+            --retained;
+            ilog("Dropped actions of history segment ${f}, beyond the retained segments",
+                 ("f", segment_file(seg->first_block, actions_ext)));
+        }
+    }
+
+    void history_store::append(const action_record &action,
+                               const std::vector<std::pair<account_name, int64_t>> &accounts) {
+        EOS_ASSERT(action.global_sequence > head.last_global_sequence && action.block_num > head.last_block,
+                   plugin_exception, "action ${s} of block ${b} is already in the history store",
+                   ("s", action.global_sequence)("b", action.block_num));
+        roll_to(action.block_num);
+
+        action_row row;
+        row.global_sequence = action.global_sequence;
+        row.block_num = action.block_num;
+        row.block_time = action.block_time.slot;
+        row.trace_offset = open_traces_size;
+        row.trace_size = action.packed_action_trace.size();
+        memcpy(row.trx_id, action.trx_id.data(), sizeof(row.trx_id));
+
+        traces_out.write(action.packed_action_trace.data(), action.packed_action_trace.size());
+        actions_out.write(reinterpret_cast<const char *>(&row), sizeof(row));
+        for (const auto &a : accounts) {
+            const account_entry e{a.first.value, a.second, action.global_sequence};
+            accounts_out.write(reinterpret_cast<const char *>(&e), sizeof(e));
+            open_accounts.emplace(std::make_pair(e.account, e.account_sequence_num), e.global_sequence);
+        }
+
+        open_trxs.emplace(action.trx_id, open_rows.size());
+        open_rows.push_back(row);
+        open_traces_size += row.trace_size;
+        head.last_global_sequence = action.global_sequence;
+    }
+
+    void history_store::commit_block(uint32_t block_num) {
+        if (block_num <= head.last_block) return;
+        roll_to(block_num);
+        actions_out.flush();
+        traces_out.flush();
+        accounts_out.flush();
+        head.last_block = block_num;
+        head.rows = open_rows.size();
+        head.account_entries = open_accounts.size();
+        write_head();
+    }
+
+    int64_t history_store::next_account_sequence(const account_name &account) const {
+        auto itr = open_accounts.upper_bound(std::make_pair(account.value, std::numeric_limits<int64_t>::max()));
+        if (itr != open_accounts.begin() && (--itr)->first.first == account.value) return itr->first.second + 1;
+
+        for (auto seg = sealed.rbegin(); seg != sealed.rend(); ++seg) {
+            const auto *first = (*seg)->account_entries();
+            const auto *last = first + (*seg)->account_count();
+            const auto *e = std::upper_bound(first, last, account.value, [](uint64_t a, const account_entry &e) {
+                return a < e.account;
+            });
+            if (e != first && (--e)->account == account.value) return e->account_sequence_num + 1;
+        }
+        return 0;
+    }
+
+    fc::optional<int64_t> history_store::first_account_sequence(const account_name &account) const {
+        for (const auto &seg : sealed) {
+            if (!seg->retained) continue;
+            const auto *first = seg->account_entries();
+            const auto *last = first + seg->account_count();
+            const auto *e = std::lower_bound(first, last, account.value, [](const account_entry &e, uint64_t a) {
+                return e.account < a;
+            });
+            if (e != last && e->account == account.value) return e->account_sequence_num;
+        }
+        auto itr = open_accounts.lower_bound(std::make_pair(account.value, std::numeric_limits<int64_t>::min()));
+        if (itr != open_accounts.end() && itr->first.first == account.value) return itr->first.second;
+        return {};
+    }
+
+    std::vector<history_store::account_action>
+    history_store::get_account_actions(const account_name &account, int64_t first, int64_t last) const {
+        std::vector<account_action> result;
+        for (const auto &seg : sealed) {
+            if (!seg->retained) continue;
+            const auto *begin = seg->account_entries();
+            const auto *end = begin + seg->account_count();
+            for (auto *e = std::lower_bound(begin, end, std::make_pair(account.value, first),
+                                            [](const account_entry &e, const std::pair<uint64_t, int64_t> &key) {
+                                                return account_less(e.account, e.account_sequence_num, key.first, key.second);
+                                            });
+                 e != end && e->account == account.value && e->account_sequence_num <= last; ++e) {
+                result.push_back(account_action{e->account_sequence_num, e->global_sequence});
+            }
+        }
+        for (auto itr = open_accounts.lower_bound(std::make_pair(account.value, first));
+             itr != open_accounts.end() && itr->first.first == account.value && itr->first.second <= last; ++itr) {
+            result.push_back(account_action{itr->first.second, itr->second});
+        }
+        return result;
+    }
+
+    bool history_store::merge_reversible(std::vector<account_action> &actions, const account_action &action) const {
+        // actions are stored in global sequence order, so every stored one is at or below the last
+        if (action.global_sequence <= head.last_global_sequence) return false;
+        actions.push_back(action);
+        return true;
+    }
+
+    history_store::action_record history_store::to_record(const action_row &row, const char *trace) const {
+        action_record r;
+        r.global_sequence = row.global_sequence;
+        r.block_num = row.block_num;
+        r.block_time = block_timestamp_type(row.block_time);
+        memcpy(r.trx_id.data(), row.trx_id, sizeof(row.trx_id));
+        r.packed_action_trace.assign(trace, trace + row.trace_size);
+        return r;
+    }
+
+    history_store::action_record history_store::read_open_row(uint64_t row) const {
+        const auto &r = open_rows[row];
+        std::vector<char> trace(r.trace_size);
+        std::ifstream in(segment_file(head.open_first_block, traces_ext).generic_string(), std::ios::binary);
+        in.seekg(r.trace_offset);
+        in.read(trace.data(), trace.size());
+        EOS_ASSERT(in.gcount() == static_cast<std::streamsize>(trace.size()), plugin_exception,
+                   "unable to read action ${s} from the history store", ("s", r.global_sequence));
+        return to_record(r, trace.data());
+    }
+
+    fc::optional<history_store::action_record> history_store::get_action(uint64_t global_sequence) const {
+        const auto by_sequence = [](const action_row &r, uint64_t s) { return r.global_sequence < s; };
+
+        if (!open_rows.empty() && global_sequence >= open_rows.front().global_sequence) {
+            auto itr = std::lower_bound(open_rows.begin(), open_rows.end(), global_sequence, by_sequence);
+            if (itr == open_rows.end() || itr->global_sequence != global_sequence) return {};
+            return read_open_row(itr - open_rows.begin());
+        }
+
+        for (auto seg = sealed.rbegin(); seg != sealed.rend(); ++seg) {
+            if (!(*seg)->retained || (*seg)->row_count() == 0) break;
+            const auto *first = (*seg)->rows();
+            const auto *last = first + (*seg)->row_count();
+            if (global_sequence < first->global_sequence) continue;
+            const auto *row = std::lower_bound(first, last, global_sequence, by_sequence);
+            if (row == last || row->global_sequence != global_sequence) return {};
+            return to_record(*row, (*seg)->traces.data() + row->trace_offset);
+        }
+        return {};
+    }
+
+    const history_store::trx_entry *history_store::lower_bound_trx(const sealed_segment &seg,
+                                                                   const transaction_id_type &id) {
+        const auto *first = seg.trx_entries();
+        const auto *last = first + seg.trx_count();
+        return std::lower_bound(first, last, id, [](const trx_entry &e, const transaction_id_type &id) {
+            return memcmp(e.trx_id, id.data(), sizeof(e.trx_id)) < 0;
+        });
+    }
+
+    fc::optional<transaction_id_type> history_store::lower_bound_transaction(const transaction_id_type &id) const {
+        fc::optional<transaction_id_type> result;
+        for (const auto &seg : sealed) {
+            if (!seg->retained) continue;
+            const auto *e = lower_bound_trx(*seg, id);
+            if (e == seg->trx_entries() + seg->trx_count()) continue;
+            transaction_id_type found;
+            memcpy(found.data(), e->trx_id, sizeof(e->trx_id));
+            if (!result || found < *result) result = found;
+        }
+        auto itr = open_trxs.lower_bound(id);
+        if (itr != open_trxs.end() && (!result || itr->first < *result)) result = itr->first;
+        return result;
+    }
+
+    std::vector<history_store::action_record>
+    history_store::get_transaction_actions(const transaction_id_type &id) const {
+        std::vector<action_record> result;
+        for (const auto &seg : sealed) {
+            if (!seg->retained) continue;
+            const auto *last = seg->trx_entries() + seg->trx_count();
+            for (const auto *e = lower_bound_trx(*seg, id);
+                 e != last && memcmp(e->trx_id, id.data(), sizeof(e->trx_id)) == 0; ++e) {
+                const auto &row = seg->rows()[e->row];
+                result.push_back(to_record(row, seg->traces.data() + row.trace_offset));
+            }
+        }
+        auto range = open_trxs.equal_range(id);
+        for (auto itr = range.first; itr != range.second; ++itr) {
+            result.push_back(read_open_row(itr->second));
+        }
+        return result;
+    }
+
+} // eosio
@@ -7,6 +7,7 @@
 #include <appbase/application.hpp>
 
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/chain/trace.hpp>
 
 namespace fc { class variant; }
 
@@ -52,8 +53,35 @@ namespace eosio {
             };
 
 
+            /**
+             * Actions selected by get_actions, not yet converted to variants. It holds the unpacked traces
+             * and the ABIs of their contracts, everything the conversion needs, so convert_actions() can
+             * run off the main thread.
+             */
+            struct get_actions_page {
+                struct entry {
+                    uint64_t global_action_seq = 0;
+                    int64_t account_action_seq = 0;
+                    uint32_t block_num = 0;
+                    chain::block_timestamp_type block_time;
+                    chain::action_trace trace;
+                };
+
+                vector<entry> actions;
+                uint32_t last_irreversible_block = 0;
+                optional<bool> time_limit_exceeded_error;
+                std::map<chain::account_name, chain_apis::cached_abi_ptr> abis; ///< nullptr for accounts without one
+                fc::microseconds abi_serializer_max_time;
+            };
+
             get_actions_result get_actions(const get_actions_params &) const;
 
+            /// the first half of get_actions, which has to run on the main thread
+            get_actions_page select_actions(const get_actions_params &) const;
+
+            /// the second half of get_actions, safe to call from any thread
+            static get_actions_result convert_actions(get_actions_page &&page);
+
 
             struct get_transaction_params {
                 string id;
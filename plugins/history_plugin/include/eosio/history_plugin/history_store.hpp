@@ -0,0 +1,189 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/block_timestamp.hpp>
+#include <eosio/chain/types.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+
+namespace eosio {
+
+    /**
+     * Append-only store of irreversible action history, used by the segments history backend.
+     *
+     * History is split into segments covering blocks_per_segment blocks each. A segment is kept in four files,
+     * one per column:
+     *   .actions   fixed-width row per action: global sequence, block, transaction id and location of the trace
+     *   .traces    packed action_traces back to back
+     *   .accounts  (account, account sequence, global sequence) triples
+     *   .trxids    (transaction id, row) pairs
+     * The open segment is appended to as blocks become irreversible and mirrored in memory. Once a block of the
+     * next range arrives it is sealed: its .accounts and .trxids are rewritten sorted, and from then on the segment
+     * is only read, through read-only mappings and binary search.
+     *
+     * When more than retained_segments sealed segments hold actions, the oldest loses all but its .accounts, so
+     * account sequences keep counting up across retention. The head file records how much of the open segment
+     * belongs to fully stored blocks; anything past that is truncated on open.
+     */
+    class history_store {
+    public:
+        struct action_record {
+            uint64_t                    global_sequence = 0;
+            uint32_t                    block_num = 0;
+            chain::block_timestamp_type block_time;
+            chain::transaction_id_type  trx_id;
+            std::vector<char>           packed_action_trace;
+        };
+
+        struct account_action {
+            int64_t  account_sequence_num = 0;
+            uint64_t global_sequence = 0;
+        };
+
+        history_store(const fc::path &dir, uint32_t blocks_per_segment, uint32_t retained_segments);
+
+        uint32_t last_block() const { return head.last_block; }
+
+        uint64_t last_global_sequence() const { return head.last_global_sequence; }
+
+        /**
+         * Append an action, linked to the given sequence number of each of its accounts. Actions must be appended
+         * in global sequence order, and a block's actions before commit_block() of that block.
+         */
+        void append(const action_record &action, const std::vector<std::pair<chain::account_name, int64_t>> &accounts);
+
+        /// record that all actions of block_num have been appended
+        void commit_block(uint32_t block_num);
+
+        /// one past the highest sequence number of account in the store, 0 if it has none
+        int64_t next_account_sequence(const chain::account_name &account) const;
+
+        /// lowest sequence number of account whose action is still retained
+        fc::optional<int64_t> first_account_sequence(const chain::account_name &account) const;
+
+        /// retained actions of account with sequence numbers in [first, last], in ascending order
+        std::vector<account_action> get_account_actions(const chain::account_name &account, int64_t first,
+                                                        int64_t last) const;
+
+        /**
+         * Append a reversible action of an account, read from chainbase, to actions read by get_account_actions().
+         * Undoing the block that moved actions into the store brings their chainbase rows back, so an action
+         * already stored is skipped rather than listed twice.
+         * @return true if action was appended
+         */
+        bool merge_reversible(std::vector<account_action> &actions, const account_action &action) const;
+
+        fc::optional<action_record> get_action(uint64_t global_sequence) const;
+
+        /// smallest retained transaction id that is not less than id
+        fc::optional<chain::transaction_id_type> lower_bound_transaction(const chain::transaction_id_type &id) const;
+
+        /// retained actions of transaction id, in global sequence order
+        std::vector<action_record> get_transaction_actions(const chain::transaction_id_type &id) const;
+
+    private:
+        struct action_row {
+            uint64_t global_sequence = 0;
+            uint32_t block_num = 0;
+            uint32_t block_time = 0; ///< block_timestamp_type::slot
+            uint64_t trace_offset = 0;
+            uint32_t trace_size = 0;
+            uint32_t reserved = 0;
+            char     trx_id[32] = {};
+        };
+
+        struct account_entry {
+            uint64_t account = 0;
+            int64_t  account_sequence_num = 0;
+            uint64_t global_sequence = 0;
+        };
+
+        struct trx_entry {
+            char     trx_id[32] = {};
+            uint64_t row = 0;
+        };
+
+        struct head_record {
+            uint32_t last_block = 0;
+            uint32_t open_first_block = 0;       ///< 0 before the first action is appended
+            uint64_t last_global_sequence = 0;
+            uint64_t rows = 0;                   ///< of the open segment, up to last_block
+            uint64_t account_entries = 0;        ///< of the open segment, up to last_block
+        };
+
+        struct mapped_file {
+            void open(const fc::path &file);
+
+            const char *data() const { return static_cast<const char *>(region.get_address()); }
+
+            uint64_t size() const { return region.get_size(); }
+
+            boost::interprocess::file_mapping  mapping;
+            boost::interprocess::mapped_region region;
+        };
+
+        struct sealed_segment {
+            uint32_t    first_block = 0;
+            bool        retained = false;  ///< whether .actions, .traces and .trxids are still there
+            mapped_file actions;
+            mapped_file traces;
+            mapped_file accounts;
+            mapped_file trxids;
+
+            const action_row *rows() const { return reinterpret_cast<const action_row *>(actions.data()); }
+            size_t row_count() const { return actions.size() / sizeof(action_row); }
+
+            const account_entry *account_entries() const { return reinterpret_cast<const account_entry *>(accounts.data()); }
+            size_t account_count() const { return accounts.size() / sizeof(account_entry); }
+
+            const trx_entry *trx_entries() const { return reinterpret_cast<const trx_entry *>(trxids.data()); }
+            size_t trx_count() const { return trxids.size() / sizeof(trx_entry); }
+        };
+
+        fc::path segment_file(uint32_t first_block, const char *extension) const;
+
+        uint32_t segment_start(uint32_t block_num) const;
+
+        void load();
+        void load_open_segment();
+        void open_sealed_segment(uint32_t first_block);
+        void create_open_segment();
+        void roll_to(uint32_t block_num);
+        void seal();
+        void apply_retention();
+        void write_head();
+
+        static const trx_entry *lower_bound_trx(const sealed_segment &seg, const chain::transaction_id_type &id);
+
+        action_record to_record(const action_row &row, const char *trace) const;
+
+        action_record read_open_row(uint64_t row) const;
+
+        const fc::path dir;
+        const uint32_t blocks_per_segment;
+        const uint32_t retained_segments;
+
+        head_record  head;
+        std::fstream head_file;
+
+        std::deque<std::unique_ptr<sealed_segment>> sealed;
+
+        std::vector<action_row>                                open_rows;
+        std::map<std::pair<uint64_t, int64_t>, uint64_t>       open_accounts; ///< (account, sequence) -> global sequence
+        std::multimap<chain::transaction_id_type, uint64_t>    open_trxs;     ///< transaction id -> row
+        uint64_t                                               open_traces_size = 0;
+        std::ofstream                                          actions_out;
+        std::ofstream                                          traces_out;
+        std::ofstream                                          accounts_out;
+    };
+
+} // eosio
@@ -654,6 +654,11 @@ namespace eosio {
         my->url_handlers.insert(std::make_pair(url, handler));
     }
 
+    void http_plugin::post_http_thread_pool(std::function<void()> f) {
+        if (f)
+            boost::asio::post(my->thread_pool->get_executor(), std::move(f));
+    }
+
     void http_plugin::httpify_exception(const fc::exception &e, url_response_callback cb) {
         uint32_t rescode = e.code();
         string message = "";
@@ -98,6 +98,9 @@ namespace eosio {
         static void
         handle_exception(const char *api_name, const char *call_name, const string &body, url_response_callback cb);
 
+        /// run f on an http thread, e.g. to convert a large response off the main thread before calling back
+        void post_http_thread_pool(std::function<void()> f);
+
         bool is_on_loopback() const;
 
         bool is_secure() const;
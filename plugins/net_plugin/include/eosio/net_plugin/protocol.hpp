@@ -39,6 +39,17 @@ namespace eosio {
       int16_t                    generation{0};
    };
 
+   /**
+    * Appended to handshake_message::os by nodes that send and accept compressed_message. The
+    * handshake keeps its encoding, peers that do not know the convention see a longer os string.
+    */
+   constexpr char os_compressed_blocks_suffix[] = "+zlib";
+
+   inline bool handshake_accepts_compressed_blocks( const handshake_message& msg ) {
+      constexpr size_t n = sizeof( os_compressed_blocks_suffix ) - 1;
+      return msg.os.size() > n && msg.os.compare( msg.os.size() - n, n, os_compressed_blocks_suffix ) == 0;
+   }
+
 
   enum go_away_reason {
     no_reason, ///< no reason to go away
@@ -132,6 +143,14 @@ namespace eosio {
       uint32_t end_block{0};
    };
 
+   /**
+    * A net_message packed and then zlib compressed. Only sent to peers whose handshake
+    * os carries os_compressed_blocks_suffix.
+    */
+   struct compressed_message {
+      bytes data;
+   };
+
    using net_message = static_variant<handshake_message,
                                       chain_size_message,
                                       go_away_message,
@@ -140,7 +159,8 @@ namespace eosio {
                                       request_message,
                                       sync_request_message,
                                       signed_block,         // which = 7
-                                      packed_transaction>;  // which = 8
+                                      packed_transaction,   // which = 8
+                                      compressed_message>;  // which = 9
 
 } // namespace eosio
 
@@ -159,6 +179,7 @@ FC_REFLECT( eosio::time_message, (org)(rec)(xmt)(dst) )
 FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
+FC_REFLECT( eosio::compressed_message, (data) )
 
 /**
  *
@@ -9,6 +9,7 @@
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/block.hpp>
+#include <eosio/chain/merkle.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/producer_plugin/producer_plugin.hpp>
@@ -27,6 +28,10 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 
 using namespace eosio::chain::plugin_interface::compat;
 
@@ -90,6 +95,19 @@ namespace eosio {
       >
    node_transaction_index;
 
+   /**
+    * A net_message unpacked off the main thread. Blocks and transactions are kept apart from
+    * msg so they can be handed to the chain as shared pointers without another copy.
+    */
+   struct decoded_message {
+      net_message              msg;
+      signed_block_ptr         block;
+      block_id_type            block_id;
+      packed_transaction_ptr   trx;
+      uint32_t                 size = 0;
+      optional<string>         error;
+   };
+
    class net_plugin_impl {
    public:
       unique_ptr<tcp::acceptor>        acceptor;
@@ -143,6 +161,7 @@ namespace eosio {
       node_transaction_index        local_txns;
 
       bool                          use_socket_read_watermark = false;
+      bool                          p2p_compression = false; ///< compress blocks for peers that support it
 
       channels::transaction_ack::channel_type::handle  incoming_transaction_ack_subscription;
 
@@ -160,10 +179,14 @@ namespace eosio {
        * Process the next message from the pending_message_buffer.
        * message_length is the already determined length of the data
        * part of the message that will handle the message.
+       * The message bytes are copied out and unpacked on the connection
+       * strand, see decode_message; the decoded message is handled on the
+       * main thread by process_decoded_message in the order received.
        * Returns true is successful. Returns false if an error was
-       * encountered unpacking or processing the message.
+       * encountered reading the message.
        */
       bool process_next_message(const connection_ptr& conn, uint32_t message_length);
+      void process_decoded_message(const connection_ptr& conn, decoded_message& dm);
 
       void close(const connection_ptr& c);
       size_t count_open_sockets() const;
@@ -199,6 +222,7 @@ namespace eosio {
       void handle_message(const connection_ptr& c, const sync_request_message& msg);
       void handle_message(const connection_ptr& c, const signed_block& msg) = delete; // signed_block_ptr overload used instead
       void handle_message(const connection_ptr& c, const signed_block_ptr& msg);
+      void accept_signed_block(const connection_ptr& c, const signed_block_ptr& msg);
       void handle_message(const connection_ptr& c, const packed_transaction& msg) = delete; // packed_transaction_ptr overload used instead
       void handle_message(const connection_ptr& c, const packed_transaction_ptr& msg);
 
@@ -296,10 +320,17 @@ namespace eosio {
    constexpr auto     def_txn_expire_wait = std::chrono::seconds(3);
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 100;
+   constexpr auto     def_sync_fetch_peers = 4;
+   constexpr auto     def_sync_send_span = 100;                   // max blocks read from block log per sync batch
+   constexpr auto     def_sync_send_batch_size = def_send_buffer_size; // max bytes read from block log per sync batch
+
+   constexpr auto     def_max_decode_queue_size = def_send_buffer_size*4; // bytes received but not yet handled, per connection
+   constexpr auto     def_compress_min_size = 1024; // smaller messages are sent uncompressed
 
    constexpr auto     message_header_size = 4;
    constexpr uint32_t signed_block_which = 7;        // see protocol net_message
    constexpr uint32_t packed_transaction_which = 8;  // see protocol net_message
+   constexpr uint32_t compressed_message_which = 9;  // see protocol net_message
 
    /**
     *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -506,6 +537,26 @@ namespace eosio {
       block_id_type          fork_head;
       uint32_t               fork_head_num = 0;
       optional<request_message> last_req;
+      bool                   sync_read_in_progress = false; // block log read for peer_requested on the net threads
+      uint32_t               decode_queue_size = 0; // bytes of messages being decoded for this connection
+      bool                   read_paused = false;   // reads resume when decode_queue_size drains
+
+      /// blocks sent to this peer are wrapped in compressed_message
+      bool compress_blocks() const {
+         return my_impl->p2p_compression && handshake_accepts_compressed_blocks( last_handshake_recv );
+      }
+
+      /// a block being compressed on the net threads, queued once it and all blocks before it are done
+      struct pending_compression {
+         std::shared_ptr<vector<char>> send_buffer; // empty until compressed
+         bool trigger_send = true;
+         bool to_sync_queue = false;
+         bool flushed = false; // write queue was flushed meanwhile, drop it
+      };
+      deque<pending_compression> pending_compressions; // in the order the blocks were enqueued
+      uint64_t               pending_compressions_base = 0; // sequence number of pending_compressions.front()
+      uint32_t               sync_rate = 0;      // blocks per second of the last sync span received from this peer
+      uint16_t               sync_failures = 0;  // sync spans taken away from this peer for timeouts or slowness
 
       connection_status get_status()const {
          connection_status stat;
@@ -575,9 +626,12 @@ namespace eosio {
       void enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
                            bool trigger_send, go_away_reason close_after_send,
                            bool to_sync_queue = false);
+      uint64_t reserve_compression( bool trigger_send, bool to_sync_queue );
+      void compression_done( uint64_t seq, const std::shared_ptr<std::vector<char>>& send_buffer );
       void cancel_sync(go_away_reason);
       void flush_queues();
       void enqueue_sync_block();
+      void enqueue_sync_buffers(uint32_t first, uint32_t last, const vector<std::shared_ptr<vector<char>>>& buffers);
       void request_sync_blocks(uint32_t start, uint32_t end);
 
       void cancel_wait();
@@ -638,6 +692,12 @@ namespace eosio {
       void operator()( packed_transaction& msg ) const {
          EOS_ASSERT( false, plugin_config_exception, "operator()(packed_transaction&&) should be called" );
       }
+      void operator()( const compressed_message& msg ) const {
+         EOS_ASSERT( false, plugin_exception, "compressed_message should be decompressed by decode_message" );
+      }
+      void operator()( compressed_message& msg ) const {
+         EOS_ASSERT( false, plugin_exception, "compressed_message should be decompressed by decode_message" );
+      }
 
       void operator()( signed_block&& msg ) const {
          impl.handle_message( c, std::make_shared<signed_block>( std::move( msg ) ) );
@@ -661,19 +721,41 @@ namespace eosio {
          in_sync
       };
 
+      /**
+       * A range of blocks requested from one peer during lib_catchup. A span whose peer failed keeps
+       * its place with an empty conn until it is handed to another peer.
+       */
+      struct sync_span {
+         uint32_t       end = 0;
+         uint32_t       start = 0;  ///< first block requested from conn
+         uint32_t       next = 0;   ///< next block expected from conn
+         connection_ptr conn;
+         fc::time_point requested;
+      };
+
       uint32_t       sync_known_lib_num{0};
       uint32_t       sync_last_requested_num{0};
       uint32_t       sync_next_expected_num{0};
       uint32_t       sync_req_span{0};
-      connection_ptr source;
+      uint32_t       sync_fetch_peers{0};
       stages         state{in_sync};
 
+      std::map<uint32_t, sync_span> spans; ///< outstanding requests keyed by first block
+      std::map<uint32_t, std::pair<connection_ptr, signed_block_ptr>> pending_blocks; ///< received ahead of sync_next_expected_num
+
       chain_plugin* chain_plug = nullptr;
 
       constexpr static auto stage_str(stages s);
 
+      void reset_spans();
+      connection_ptr select_sync_peer(uint32_t end, const connection_ptr& preferred);
+      void assign_span(std::map<uint32_t, sync_span>::iterator itr, const connection_ptr& c);
+      void release_span(const connection_ptr& c);
+      void reassign_slow_span();
+      void recv_span_block(const connection_ptr& c, uint32_t blk_num);
+
    public:
-      explicit sync_manager(uint32_t span);
+      sync_manager(uint32_t span, uint32_t peers);
       void set_state(stages s);
       bool sync_required();
       void send_handshakes();
@@ -686,6 +768,8 @@ namespace eosio {
       bool verify_catchup(const connection_ptr& c, uint32_t num, const block_id_type& id);
       void rejected_block(const connection_ptr& c, uint32_t blk_num);
       void recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num);
+      bool buffer_block(const connection_ptr& c, const signed_block_ptr& blk);
+      bool next_buffered_block(connection_ptr& c, signed_block_ptr& blk);
       void recv_handshake(const connection_ptr& c, const handshake_message& msg);
       void recv_notice(const connection_ptr& c, const notice_message& msg);
    };
@@ -784,6 +868,9 @@ namespace eosio {
 
    void connection::flush_queues() {
       buffer_queue.clear_write_queue();
+      for( auto& pc : pending_compressions ) {
+         pc.flushed = true;
+      }
    }
 
    void connection::close() {
@@ -796,6 +883,10 @@ namespace eosio {
          fc_wlog( logger, "no socket to close!" );
       }
       flush_queues();
+      pending_compressions.clear(); // completions for the old socket are dropped
+      pending_compressions_base = 0;
+      decode_queue_size = 0;
+      read_paused = false;
       connecting = false;
       syncing = false;
       consecutive_rejected_blocks = 0;
@@ -1027,51 +1118,6 @@ namespace eosio {
       }
    }
 
-   void connection::enqueue_sync_block() {
-         connection_wptr c(shared_from_this());
-         app().post( priority::low, [c]() {
-            auto conn = c.lock();
-            if(!conn) return;
-            if( !conn->peer_requested )
-               return;
-            uint32_t num = ++conn->peer_requested->last;
-            if( num == conn->peer_requested->end_block ) {
-               conn->peer_requested.reset();
-               fc_ilog( logger, "completing enqueue_sync_block ${num} to ${p}", ("num", num)( "p", conn->peer_name() ) );
-         }
-         try {
-                 controller& cc = my_impl->chain_plug->chain();
-                 signed_block_ptr sb = cc.fetch_block_by_number( num );
-                 if( sb ) {
-                    conn->enqueue_block( sb, true, true );
-                 }
-              } catch( ... ) {
-                 fc_wlog( logger, "write loop exception" );
-              }
-           } );
-   }
-
-   void connection::enqueue( const net_message& m, bool trigger_send ) {
-      go_away_reason close_after_send = no_reason;
-      if (m.contains<go_away_message>()) {
-         close_after_send = m.get<go_away_message>().reason;
-      }
-
-      const uint32_t payload_size = fc::raw::pack_size( m );
-
-      const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
-      constexpr size_t header_size = sizeof(payload_size);
-      static_assert( header_size == message_header_size, "invalid message_header_size" );
-      const size_t buffer_size = header_size + payload_size;
-
-      auto send_buffer = std::make_shared<vector<char>>(buffer_size);
-      fc::datastream<char*> ds( send_buffer->data(), buffer_size);
-      ds.write( header, header_size );
-      fc::raw::pack( ds, m );
-
-      enqueue_buffer( send_buffer, trigger_send, close_after_send );
-   }
-
    template< typename T>
    static std::shared_ptr<std::vector<char>> create_send_buffer( uint32_t which, const T& v ) {
       // match net_message static_variant pack
@@ -1104,8 +1150,234 @@ namespace eosio {
       return create_send_buffer( packed_transaction_which, trx );
    }
 
+   static std::shared_ptr<std::vector<char>> create_send_buffer( const std::vector<char>& packed_block ) {
+      // packed_block is a signed_block as stored in the block log, which is also its net_message encoding
+      const uint32_t which_size = fc::raw::pack_size( unsigned_int( signed_block_which ) );
+      const uint32_t payload_size = which_size + packed_block.size();
+
+      const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+      constexpr size_t header_size = sizeof( payload_size );
+      static_assert( header_size == message_header_size, "invalid message_header_size" );
+      const size_t buffer_size = header_size + payload_size;
+
+      auto send_buffer = std::make_shared<vector<char>>( buffer_size );
+      fc::datastream<char*> ds( send_buffer->data(), buffer_size );
+      ds.write( header, header_size );
+      fc::raw::pack( ds, unsigned_int( signed_block_which ) );
+      ds.write( packed_block.data(), packed_block.size() );
+
+      return send_buffer;
+   }
+
+   namespace bio = boost::iostreams;
+
+   static bytes zlib_compress( const char* data, size_t size ) {
+      bytes out;
+      bio::filtering_ostream comp;
+      comp.push( bio::zlib_compressor( bio::zlib::best_speed ) );
+      comp.push( bio::back_inserter( out ) );
+      bio::write( comp, data, size );
+      bio::close( comp );
+      return out;
+   }
+
+   static bytes zlib_decompress( const bytes& in, size_t max_size ) {
+      bytes out;
+      bio::filtering_istream decomp;
+      decomp.push( bio::zlib_decompressor() );
+      decomp.push( bio::array_source( in.data(), in.size() ) );
+      char buf[64*1024];
+      while( decomp ) {
+         decomp.read( buf, sizeof( buf ) );
+         const auto n = decomp.gcount();
+         EOS_ASSERT( out.size() + n <= max_size, plugin_exception,
+                     "compressed message expands beyond ${m} bytes", ("m", max_size) );
+         out.insert( out.end(), buf, buf + n );
+      }
+      return out;
+   }
+
+   /**
+    * Wrap the net_message in send_buffer in a compressed_message, or return send_buffer itself
+    * if it is small or does not compress.
+    */
+   static std::shared_ptr<std::vector<char>> create_compressed_send_buffer( const std::shared_ptr<std::vector<char>>& send_buffer ) {
+      if( send_buffer->size() < message_header_size + def_compress_min_size )
+         return send_buffer;
+      compressed_message cm;
+      cm.data = zlib_compress( send_buffer->data() + message_header_size, send_buffer->size() - message_header_size );
+      if( cm.data.size() + message_header_size + 2*sizeof(uint32_t) >= send_buffer->size() )
+         return send_buffer;
+      return create_send_buffer( compressed_message_which, cm );
+   }
+
+   /**
+    * Compress send_buffer once on the net threads and queue the result to each of conns. Each
+    * connection queues its compressed blocks in the order they were enqueued.
+    */
+   static void enqueue_compressed( const std::shared_ptr<std::vector<char>>& send_buffer,
+                                   const vector<connection_ptr>& conns, bool trigger_send, bool to_sync_queue ) {
+      struct reservation {
+         connection_wptr c;
+         socket_ptr socket;
+         uint64_t seq;
+      };
+      auto reservations = std::make_shared<vector<reservation>>();
+      reservations->reserve( conns.size() );
+      for( const auto& c : conns ) {
+         reservations->push_back( {c, c->socket, c->reserve_compression( trigger_send, to_sync_queue )} );
+      }
+      boost::asio::post( my_impl->thread_pool->get_executor(), [send_buffer, reservations]() {
+         auto buffer = create_compressed_send_buffer( send_buffer );
+         app().post( priority::medium, [buffer, reservations]() {
+            for( const auto& r : *reservations ) {
+               auto conn = r.c.lock();
+               // a closed connection dropped its pending compressions
+               if( !conn || conn->socket != r.socket ) continue;
+               conn->compression_done( r.seq, buffer );
+            }
+         } );
+      } );
+   }
+
+   uint64_t connection::reserve_compression( bool trigger_send, bool to_sync_queue ) {
+      pending_compressions.push_back( {nullptr, trigger_send, to_sync_queue} );
+      return pending_compressions_base + pending_compressions.size() - 1;
+   }
+
+   void connection::compression_done( uint64_t seq, const std::shared_ptr<std::vector<char>>& send_buffer ) {
+      if( seq < pending_compressions_base || seq - pending_compressions_base >= pending_compressions.size() )
+         return;
+      pending_compressions[seq - pending_compressions_base].send_buffer = send_buffer;
+      bool to_sync_queue = false;
+      while( !pending_compressions.empty() && pending_compressions.front().send_buffer ) {
+         pending_compression pc = std::move( pending_compressions.front() );
+         pending_compressions.pop_front();
+         ++pending_compressions_base;
+         if( pc.flushed ) continue;
+         to_sync_queue = to_sync_queue || pc.to_sync_queue;
+         enqueue_buffer( pc.send_buffer, pc.trigger_send, no_reason, pc.to_sync_queue ); // may close the connection
+      }
+      if( to_sync_queue && pending_compressions.empty() ) {
+         // enqueue_sync_block waits for sync blocks being compressed
+         enqueue_sync_block();
+         if( buffer_queue.is_out_queue_empty() ) {
+            do_queue_write();
+         }
+      }
+   }
+
+   /**
+    * Sync blocks are served straight from the block log: the net threads read the next range of
+    * peer_requested as packed bytes and wrap them in the signed_block net_message envelope, the main
+    * thread only queues the finished buffers. One batch is in flight per connection, the next one
+    * is read when the previous batch has been written out. Blocks not yet in the block log are
+    * fetched from the controller on the main thread.
+    */
+   void connection::enqueue_sync_block() {
+      if( !peer_requested || sync_read_in_progress || !pending_compressions.empty() )
+         return;
+      if( buffer_queue.write_queue_size() > def_max_write_queue_size )
+         return; // resumed by the write completion
+      const uint32_t first = peer_requested->last + 1;
+      const uint32_t last = std::min<uint32_t>( peer_requested->end_block, first + def_sync_send_span - 1 );
+      if( first > last ) {
+         peer_requested.reset();
+         return;
+      }
+      sync_read_in_progress = true;
+      connection_wptr c(shared_from_this());
+      const bool compress = compress_blocks();
+      boost::asio::post( my_impl->thread_pool->get_executor(), [c, first, last, compress]() {
+         auto buffers = std::make_shared<vector<std::shared_ptr<vector<char>>>>();
+         try {
+            controller& cc = my_impl->chain_plug->chain();
+            for( const auto& raw : cc.fetch_blocks_raw_by_number( first, last, def_sync_send_batch_size ) ) {
+               auto buff = create_send_buffer( raw );
+               buffers->emplace_back( compress ? create_compressed_send_buffer( buff ) : buff );
+            }
+         } catch( const fc::exception& ex ) {
+            fc_wlog( logger, "unable to read blocks ${f} - ${l} from block log: ${e}",
+                     ("f", first)("l", last)("e", ex.to_string()) );
+         } catch( ... ) {
+            fc_wlog( logger, "unable to read blocks ${f} - ${l} from block log", ("f", first)("l", last) );
+         }
+         app().post( priority::low, [c, first, last, buffers]() {
+            auto conn = c.lock();
+            if( !conn ) return;
+            conn->sync_read_in_progress = false;
+            conn->enqueue_sync_buffers( first, last, *buffers );
+         } );
+      } );
+   }
+
+   void connection::enqueue_sync_buffers( uint32_t first, uint32_t last,
+                                          const vector<std::shared_ptr<vector<char>>>& buffers ) {
+      // the request may have been cancelled or replaced while the block log was read
+      if( !peer_requested || peer_requested->last + 1 != first ) {
+         enqueue_sync_block();
+         return;
+      }
+      for( const auto& buff : buffers ) {
+         uint32_t num = ++peer_requested->last;
+         if( num == peer_requested->end_block ) {
+            peer_requested.reset();
+            fc_ilog( logger, "completing enqueue_sync_block ${num} to ${p}", ("num", num)( "p", peer_name() ) );
+         }
+         enqueue_buffer( buff, false, no_reason, true );
+         if( !peer_requested ) // completed, or connection closed on a full write queue
+            break;
+      }
+      if( peer_requested && first + buffers.size() <= last ) {
+         // next block is still reversible
+         uint32_t num = ++peer_requested->last;
+         if( num == peer_requested->end_block ) {
+            peer_requested.reset();
+            fc_ilog( logger, "completing enqueue_sync_block ${num} to ${p}", ("num", num)( "p", peer_name() ) );
+         }
+         try {
+            controller& cc = my_impl->chain_plug->chain();
+            signed_block_ptr sb = cc.fetch_block_by_number( num );
+            if( sb ) {
+               enqueue_block( sb, false, true );
+            }
+         } catch( ... ) {
+            fc_wlog( logger, "write loop exception" );
+         }
+      }
+      if( buffer_queue.is_out_queue_empty() ) {
+         do_queue_write();
+      }
+   }
+
+   void connection::enqueue( const net_message& m, bool trigger_send ) {
+      go_away_reason close_after_send = no_reason;
+      if (m.contains<go_away_message>()) {
+         close_after_send = m.get<go_away_message>().reason;
+      }
+
+      const uint32_t payload_size = fc::raw::pack_size( m );
+
+      const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+      constexpr size_t header_size = sizeof(payload_size);
+      static_assert( header_size == message_header_size, "invalid message_header_size" );
+      const size_t buffer_size = header_size + payload_size;
+
+      auto send_buffer = std::make_shared<vector<char>>(buffer_size);
+      fc::datastream<char*> ds( send_buffer->data(), buffer_size);
+      ds.write( header, header_size );
+      fc::raw::pack( ds, m );
+
+      enqueue_buffer( send_buffer, trigger_send, close_after_send );
+   }
+
    void connection::enqueue_block( const signed_block_ptr& sb, bool trigger_send, bool to_sync_queue) {
-      enqueue_buffer( create_send_buffer( sb ), trigger_send, no_reason, to_sync_queue);
+      auto send_buffer = create_send_buffer( sb );
+      if( compress_blocks() ) {
+         enqueue_compressed( send_buffer, {shared_from_this()}, trigger_send, to_sync_queue );
+         return;
+      }
+      enqueue_buffer( send_buffer, trigger_send, no_reason, to_sync_queue);
    }
 
    void connection::enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
@@ -1231,12 +1503,12 @@ namespace eosio {
 
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t req_span )
+    sync_manager::sync_manager( uint32_t req_span, uint32_t peers )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_req_span( req_span )
-      ,source()
+      ,sync_fetch_peers( peers )
       ,state(in_sync)
    {
       chain_plug = app().find_plugin<chain_plugin>();
@@ -1258,6 +1530,15 @@ namespace eosio {
       }
       fc_dlog(logger, "old state ${os} becoming ${ns}",("os",stage_str(state))("ns",stage_str(newstate)));
       state = newstate;
+      if( state != lib_catchup ) {
+         reset_spans();
+      }
+   }
+
+   void sync_manager::reset_spans() {
+      spans.clear();
+      pending_blocks.clear();
+      sync_last_requested_num = 0;
    }
 
    bool sync_manager::is_active(const connection_ptr& c) {
@@ -1271,16 +1552,12 @@ namespace eosio {
    }
 
    void sync_manager::reset_lib_num(const connection_ptr& c) {
-      if(state == in_sync) {
-         source.reset();
-      }
       if( c->current() ) {
          if( c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num) {
             sync_known_lib_num =c->last_handshake_recv.last_irreversible_block_num;
          }
-      } else if( c == source ) {
-         sync_last_requested_num = 0;
-         request_next_chunk();
+      } else {
+         release_span( c );
       }
    }
 
@@ -1292,94 +1569,141 @@ namespace eosio {
               chain_plug->chain().fork_db_pending_head_block_num() < sync_last_requested_num );
    }
 
-   void sync_manager::request_next_chunk( const connection_ptr& conn ) {
-      uint32_t head_block = chain_plug->chain().fork_db_pending_head_block_num();
-
-      if (head_block < sync_last_requested_num && source && source->current()) {
-         fc_ilog(logger, "ignoring request, head is ${h} last req = ${r} source is ${p}",
-                  ("h",head_block)("r",sync_last_requested_num)("p",source->peer_name()));
-         return;
+   connection_ptr sync_manager::select_sync_peer( uint32_t end, const connection_ptr& preferred ) {
+      auto idle = [this]( const connection_ptr& c ) {
+         if( !c->current() ) return false;
+         for( const auto& sp : spans ) {
+            if( sp.second.conn == c ) return false;
+         }
+         return true;
+      };
+      if( preferred && idle( preferred ) ) {
+         return preferred;
       }
 
       /* ----------
-       * next chunk provider selection criteria
-       * a provider is supplied and able to be used, use it.
-       * otherwise select the next available from the list, round-robin style.
+       * next span provider selection criteria
+       * among idle current peers, prefer one that has the whole span irreversible, then the fewest
+       * reassigned spans, then the highest measured rate.
        */
-
-      if (conn && conn->current() ) {
-         source = conn;
+      connection_ptr best;
+      auto better = [end]( const connection_ptr& a, const connection_ptr& b ) {
+         bool a_has = a->last_handshake_recv.last_irreversible_block_num >= end;
+         bool b_has = b->last_handshake_recv.last_irreversible_block_num >= end;
+         if( a_has != b_has ) return a_has;
+         if( a->sync_failures != b->sync_failures ) return a->sync_failures < b->sync_failures;
+         return a->sync_rate > b->sync_rate;
+      };
+      for( const auto& c : my_impl->connections ) {
+         if( idle( c ) && (!best || better( c, best )) ) {
+            best = c;
+         }
       }
-      else {
-         if( my_impl->connections.size() == 0 ) {
-            source.reset();
-         } else if( my_impl->connections.size() == 1 ) {
-            if (!source) {
-               source = *my_impl->connections.begin();
-            }
-         } else {
-            // init to a linear array search
-            auto cptr = my_impl->connections.begin();
-            auto cend = my_impl->connections.end();
-            // do we remember the previous source?
-            if( source ) {
-               //try to find it in the list
-               cptr = my_impl->connections.find( source );
-               cend = cptr;
-               if( cptr == my_impl->connections.end() ) {
-                  //not there - must have been closed! cend is now connections.end, so just flatten the ring.
-                  source.reset();
-                  cptr = my_impl->connections.begin();
-               } else {
-                  //was found - advance the start to the next. cend is the old source.
-                  if( ++cptr == my_impl->connections.end() && cend != my_impl->connections.end() ) {
-                     cptr = my_impl->connections.begin();
-                  }
-               }
-            }
+      return best;
+   }
 
-            //scan the list of peers looking for another able to provide sync blocks.
-            if( cptr != my_impl->connections.end() ) {
-               auto cstart_it = cptr;
-               do {
-                  //select the first one which is current and break out.
-                  if( (*cptr)->current() ) {
-                     source = *cptr;
-                     break;
-                  }
-                  if( ++cptr == my_impl->connections.end() )
-                     cptr = my_impl->connections.begin();
-               } while( cptr != cstart_it );
-            }
-            // no need to check the result, either source advanced or the whole list was checked and the old source is reused.
+   void sync_manager::assign_span( std::map<uint32_t, sync_span>::iterator itr, const connection_ptr& c ) {
+      auto& sp = itr->second;
+      sp.conn = c;
+      sp.start = sp.next;
+      sp.requested = fc::time_point::now();
+      fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
+              ("n",c->peer_name())("s",sp.next)("e",sp.end));
+      c->request_sync_blocks(sp.next, sp.end);
+   }
+
+   void sync_manager::release_span( const connection_ptr& c ) {
+      for( auto& sp : spans ) {
+         if( sp.second.conn == c ) {
+            fc_ilog(logger, "releasing range ${s} to ${e} from ${p}",
+                    ("s",sp.second.next)("e",sp.second.end)("p",c->peer_name()));
+            sp.second.conn.reset();
+            ++c->sync_failures;
+            c->sync_rate = 0;
+            request_next_chunk();
+            return;
          }
       }
+   }
 
-      // verify there is an available source
-      if (!source || !source->current() ) {
-         fc_elog( logger, "Unable to continue syncing at this time");
-         sync_known_lib_num = chain_plug->chain().last_irreversible_block_num();
-         sync_last_requested_num = 0;
-         set_state(in_sync); // probably not, but we can't do anything else
+   void sync_manager::reassign_slow_span() {
+      // every other block waits on the first span; hand it over if its peer is well behind an idle one
+      auto itr = spans.begin();
+      if( itr == spans.end() || !itr->second.conn ) return;
+      auto& sp = itr->second;
+      const auto elapsed = fc::time_point::now() - sp.requested;
+      if( elapsed < fc::seconds(1) ) return;
+
+      connection_ptr c = select_sync_peer( sp.end, connection_ptr() );
+      if( !c || c->sync_rate == 0 ) return;
+      const uint64_t received = sp.next - sp.start;
+      const uint64_t rate = received * 1000000 / elapsed.count();
+      if( rate * 2 >= c->sync_rate ) return;
+
+      fc_ilog(logger, "sync peer ${p} at ${r} blocks/s, moving range ${s} to ${e} to ${n} at ${nr} blocks/s",
+              ("p",sp.conn->peer_name())("r",rate)("s",sp.next)("e",sp.end)("n",c->peer_name())("nr",c->sync_rate));
+      auto slow = sp.conn;
+      ++slow->sync_failures;
+      slow->sync_rate = rate;
+      slow->cancel_sync( benign_other );
+      assign_span( itr, c );
+   }
+
+   /**
+    * Keep up to sync_fetch_peers spans of sync_req_span blocks outstanding with different peers.
+    * Spans are requested in order, blocks that arrive ahead of the next block to apply are held in
+    * pending_blocks, so the requested range is capped at twice the outstanding spans past head.
+    */
+   void sync_manager::request_next_chunk( const connection_ptr& conn ) {
+      if( state != lib_catchup ) {
          return;
       }
+      uint32_t head_block = chain_plug->chain().fork_db_pending_head_block_num();
+
+      // spans that lost their peer come first, everything behind them is waiting
+      for( auto itr = spans.begin(); itr != spans.end(); ++itr ) {
+         if( itr->second.conn ) continue;
+         connection_ptr c = select_sync_peer( itr->second.end, conn );
+         if( !c ) break;
+         assign_span( itr, c );
+      }
 
-      bool request_sent = false;
-      if( sync_last_requested_num != sync_known_lib_num ) {
-         uint32_t start = sync_next_expected_num;
+      const uint32_t window = 2 * sync_fetch_peers * sync_req_span;
+      uint32_t start = std::max( sync_last_requested_num + 1, sync_next_expected_num );
+      while( spans.size() < sync_fetch_peers && start <= sync_known_lib_num && start <= head_block + window ) {
          uint32_t end = start + sync_req_span - 1;
          if( end > sync_known_lib_num )
             end = sync_known_lib_num;
-         if( end > 0 && end >= start ) {
-            fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
-                    ("n",source->peer_name())("s",start)("e",end));
-            request_sent = true;
-            source->request_sync_blocks(start, end);
-            sync_last_requested_num = end;
+         connection_ptr c = select_sync_peer( end, conn );
+         if( !c ) break;
+         auto itr = spans.emplace( start, sync_span{end, start, start, connection_ptr(), fc::time_point()} ).first;
+         assign_span( itr, c );
+         sync_last_requested_num = end;
+         start = end + 1;
+      }
+
+      if( spans.size() == sync_fetch_peers || start > head_block + window ) {
+         reassign_slow_span();
+      }
+
+      // verify there is an available source
+      bool have_source = false;
+      for( const auto& sp : spans ) {
+         if( sp.second.conn ) {
+            have_source = true;
+            break;
          }
       }
-      if( !request_sent ) {
-         source->send_handshake();
+      const bool more_to_request = sync_last_requested_num < sync_known_lib_num && start <= head_block + window;
+      if( !have_source && (!spans.empty() || more_to_request) ) {
+         fc_elog( logger, "Unable to continue syncing at this time");
+         sync_known_lib_num = chain_plug->chain().last_irreversible_block_num();
+         set_state(in_sync); // probably not, but we can't do anything else
+         return;
+      }
+
+      if( spans.empty() && conn && conn->current() ) {
+         conn->send_handshake();
       }
    }
 
@@ -1420,10 +1744,12 @@ namespace eosio {
       fc_ilog(logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
               ( "cc",sync_last_requested_num)("ne",sync_next_expected_num)("p",c->peer_name()));
 
-      if (c == source) {
-         c->cancel_sync(reason);
-         sync_last_requested_num = 0;
-         request_next_chunk();
+      for( const auto& sp : spans ) {
+         if( sp.second.conn == c ) {
+            c->cancel_sync(reason);
+            release_span(c);
+            return;
+         }
       }
    }
 
@@ -1592,18 +1918,70 @@ namespace eosio {
    void sync_manager::rejected_block(const connection_ptr& c, uint32_t blk_num) {
       if ( ++c->consecutive_rejected_blocks > def_max_consecutive_rejected_blocks ) {
          fc_wlog( logger, "block ${bn} not accepted from ${p}, closing connection", ("bn",blk_num)("p",c->peer_name()) );
-         sync_last_requested_num = 0;
-         source.reset();
-         my_impl->close(c);
          set_state(in_sync);
+         my_impl->close(c);
          send_handshakes();
       } else {
          c->send_handshake();
       }
    }
+   void sync_manager::recv_span_block(const connection_ptr& c, uint32_t blk_num) {
+      for( auto itr = spans.begin(); itr != spans.end(); ++itr ) {
+         auto& sp = itr->second;
+         if( sp.conn != c ) continue;
+         if( blk_num != sp.next ) return;
+         if( ++sp.next <= sp.end ) {
+            fc_dlog(logger,"calling sync_wait on connection ${p}",("p",c->peer_name()));
+            c->sync_wait();
+            return;
+         }
+         const auto elapsed = fc::time_point::now() - sp.requested;
+         c->sync_rate = uint64_t(sp.end - sp.start + 1) * 1000000 / std::max<int64_t>( elapsed.count(), 1 );
+         c->cancel_wait();
+         spans.erase( itr );
+         return;
+      }
+   }
+
+   bool sync_manager::buffer_block(const connection_ptr& c, const signed_block_ptr& blk) {
+      if( state != lib_catchup ) {
+         return false;
+      }
+      const uint32_t blk_num = blk->block_num();
+      if( blk_num <= sync_next_expected_num || blk_num > sync_last_requested_num ) {
+         return false;
+      }
+      fc_dlog(logger, "holding block ${bn} from ${p} until ${ne} is applied",
+              ("bn",blk_num)("p",c->peer_name())("ne",sync_next_expected_num));
+      recv_span_block( c, blk_num );
+      pending_blocks.emplace( blk_num, std::make_pair( c, blk ) );
+      request_next_chunk();
+      return true;
+   }
+
+   bool sync_manager::next_buffered_block(connection_ptr& c, signed_block_ptr& blk) {
+      while( !pending_blocks.empty() ) {
+         auto itr = pending_blocks.begin();
+         if( itr->first > sync_next_expected_num ) {
+            return false;
+         }
+         bool next = itr->first == sync_next_expected_num;
+         if( next ) {
+            c = itr->second.first;
+            blk = itr->second.second;
+         }
+         pending_blocks.erase( itr );
+         if( next ) {
+            return true;
+         }
+      }
+      return false;
+   }
+
    void sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num) {
       fc_dlog(logger, "got block ${bn} from ${p}",("bn",blk_num)("p",c->peer_name()));
       if (state == lib_catchup) {
+         recv_span_block( c, blk_num );
          if (blk_num != sync_next_expected_num) {
             fc_wlog( logger, "expected block ${ne} but got ${bn}, from connection: ${p}",
                      ("ne",sync_next_expected_num)("bn",blk_num)("p",c->peer_name()) );
@@ -1614,7 +1992,6 @@ namespace eosio {
       if (state == head_catchup) {
          fc_dlog(logger, "sync_manager in head_catchup state");
          set_state(in_sync);
-         source.reset();
 
          block_id_type null_id;
          for (const auto& cp : my_impl->connections) {
@@ -1640,12 +2017,8 @@ namespace eosio {
             set_state(in_sync);
             send_handshakes();
          }
-         else if (blk_num == sync_last_requested_num) {
-            request_next_chunk();
-         }
          else {
-            fc_dlog(logger,"calling sync_wait on connection ${p}",("p",c->peer_name()));
-            c->sync_wait();
+            request_next_chunk();
          }
       }
    }
@@ -1664,6 +2037,7 @@ namespace eosio {
       peer_block_state pbstate{bs->id, bnum};
 
       std::shared_ptr<std::vector<char>> send_buffer;
+      vector<connection_ptr> compress_conns;
       for( auto& cp : my_impl->connections ) {
          if( skips.find( cp ) != skips.end() || !cp->current() ) {
             continue;
@@ -1678,9 +2052,16 @@ namespace eosio {
                send_buffer = create_send_buffer( bs->block );
             }
             fc_dlog(logger, "bcast block ${b} to ${p}", ("b", bnum)("p", cp->peer_name()));
-            cp->enqueue_buffer( send_buffer, true, no_reason );
+            if( cp->compress_blocks() ) {
+               compress_conns.push_back( cp );
+            } else {
+               cp->enqueue_buffer( send_buffer, true, no_reason );
+            }
          }
       }
+      if( !compress_conns.empty() ) {
+         enqueue_compressed( send_buffer, compress_conns, true, false );
+      }
 
    }
 
@@ -2130,7 +2511,12 @@ namespace eosio {
                            }
                         }
                      }
-                     start_read_message(conn);
+                     if( conn->decode_queue_size > def_max_decode_queue_size ) {
+                        // resumed by process_decoded_message
+                        conn->read_paused = true;
+                     } else {
+                        start_read_message(conn);
+                     }
                   } else {
                      auto pname = conn->peer_name();
                      if (ec.value() != boost::asio::error::eof) {
@@ -2164,19 +2550,101 @@ namespace eosio {
       }
    }
 
-   bool net_plugin_impl::process_next_message(const connection_ptr& conn, uint32_t message_length) {
+   /**
+    * Runs on the connection strand. Unpacks the message, and for blocks computes the id and checks
+    * the transaction receipts against the transaction_mroot of the header so a corrupted block is
+    * dropped before it reaches the main thread.
+    */
+   static void decode_message( const vector<char>& bytes, decoded_message& dm, bool allow_compressed = true ) {
       try {
-         // if next message is a block we already have, exit early
-         auto peek_ds = conn->pending_message_buffer.create_peek_datastream();
+         fc::datastream<const char*> peek_ds( bytes.data(), bytes.size() );
          unsigned_int which{};
          fc::raw::unpack( peek_ds, which );
+         if( which == compressed_message_which ) {
+            EOS_ASSERT( allow_compressed, plugin_exception, "nested compressed_message" );
+            compressed_message cm;
+            fc::raw::unpack( peek_ds, cm );
+            decode_message( zlib_decompress( cm.data, def_send_buffer_size*2 ), dm, false );
+            return;
+         }
          if( which == signed_block_which ) {
-            block_header bh;
-            fc::raw::unpack( peek_ds, bh );
+            auto block = std::make_shared<signed_block>();
+            fc::raw::unpack( peek_ds, *block );
+            dm.block_id = block->id();
+
+            vector<digest_type> receipt_digests;
+            receipt_digests.reserve( block->transactions.size() );
+            for( const auto& receipt : block->transactions ) {
+               receipt_digests.emplace_back( receipt.digest() );
+            }
+            EOS_ASSERT( merkle( std::move( receipt_digests ) ) == block->transaction_mroot, block_validate_exception,
+                        "transaction_mroot does not match the transactions of block ${n} ${id}",
+                        ("n", block->block_num())("id", dm.block_id) );
+            dm.block = std::move( block );
+         } else if( which == packed_transaction_which ) {
+            auto trx = std::make_shared<packed_transaction>();
+            fc::raw::unpack( peek_ds, *trx );
+            dm.trx = std::move( trx );
+         } else {
+            fc::datastream<const char*> ds( bytes.data(), bytes.size() );
+            fc::raw::unpack( ds, dm.msg );
+         }
+      } catch( const fc::exception& e ) {
+         dm.error = e.to_detail_string();
+      } catch( const std::exception& e ) {
+         dm.error = e.what();
+      }
+   }
+
+   bool net_plugin_impl::process_next_message(const connection_ptr& conn, uint32_t message_length) {
+      try {
+         auto bytes = std::make_shared<vector<char>>( message_length );
+         auto peek_ds = conn->pending_message_buffer.create_peek_datastream();
+         peek_ds.read( bytes->data(), message_length );
+         conn->pending_message_buffer.advance_read_ptr( message_length );
+         conn->decode_queue_size += message_length;
+
+         // the strand keeps messages of a connection in order, handling posts them to the main thread in that order
+         connection_wptr weak_conn = conn;
+         boost::asio::post( conn->strand, [weak_conn, socket=conn->socket, bytes]() {
+            auto dm = std::make_shared<decoded_message>();
+            dm->size = bytes->size();
+            decode_message( *bytes, *dm );
+            app().post( priority::medium, [weak_conn, socket, dm]() {
+               auto conn = weak_conn.lock();
+               // a closed connection resets its decode queue, drop anything decoded for the old socket
+               if( !conn || conn->socket != socket ) return;
+               my_impl->process_decoded_message( conn, *dm );
+            } );
+         } );
+      } catch( const fc::exception& e ) {
+         fc_elog( logger, "Exception in handling message from ${p}: ${s}",
+                  ("p", conn->peer_name())("s", e.to_detail_string()) );
+         close( conn );
+         return false;
+      }
+      return true;
+   }
 
+   void net_plugin_impl::process_decoded_message(const connection_ptr& conn, decoded_message& dm) {
+      conn->decode_queue_size -= dm.size;
+      if( conn->read_paused && conn->decode_queue_size <= def_max_decode_queue_size / 2 ) {
+         conn->read_paused = false;
+         start_read_message( conn );
+      }
+      if( !conn->socket->is_open() ) {
+         return;
+      }
+
+      try {
+         if( dm.error ) {
+            EOS_THROW( plugin_exception, "unable to unpack message: ${e}", ("e", *dm.error) );
+         }
+         if( dm.block ) {
+            // if the message is a block we already have, exit early
             const controller& cc = chain_plug->chain();
-            const block_id_type blk_id = bh.id();
-            const uint32_t blk_num = bh.block_num();
+            const block_id_type& blk_id = dm.block_id;
+            const uint32_t blk_num = dm.block->block_num();
             if( !sync_master->syncing_with_peer() ) {
                uint32_t lib = cc.last_irreversible_block_num();
                if( blk_num < lib ) {
@@ -2190,38 +2658,27 @@ namespace eosio {
                      conn->send_handshake();
                      conn->cancel_wait();
                   }
-
-                  conn->pending_message_buffer.advance_read_ptr( message_length );
-                  return true;
+                  return;
                }
             }
             if( cc.fetch_block_by_id( blk_id ) ) {
                if( sync_master->syncing_with_peer() )
                   sync_master->recv_block( conn, blk_id, blk_num );
                conn->cancel_wait();
-               conn->pending_message_buffer.advance_read_ptr( message_length );
-               return true;
+               return;
             }
-         }
-
-         auto ds = conn->pending_message_buffer.create_datastream();
-         net_message msg;
-         fc::raw::unpack( ds, msg );
-         msg_handler m( *this, conn );
-         if( msg.contains<signed_block>() ) {
-            m( std::move( msg.get<signed_block>() ) );
-         } else if( msg.contains<packed_transaction>() ) {
-            m( std::move( msg.get<packed_transaction>() ) );
+            handle_message( conn, dm.block );
+         } else if( dm.trx ) {
+            handle_message( conn, dm.trx );
          } else {
-            msg.visit( m );
+            msg_handler m( *this, conn );
+            dm.msg.visit( m );
          }
       } catch( const fc::exception& e ) {
          fc_elog( logger, "Exception in handling message from ${p}: ${s}",
                   ("p", conn->peer_name())("s", e.to_detail_string()) );
          close( conn );
-         return false;
       }
-      return true;
    }
 
    size_t net_plugin_impl::count_open_sockets() const
@@ -2591,17 +3048,31 @@ namespace eosio {
    }
 
    void net_plugin_impl::handle_message(const connection_ptr& c, const signed_block_ptr& msg) {
+      fc_dlog(logger, "canceling wait on ${p}", ("p",c->peer_name()));
+      c->cancel_wait();
+
+      // blocks of later sync spans are held until the blocks before them are applied
+      if( sync_master->buffer_block( c, msg ) ) {
+         return;
+      }
+      accept_signed_block( c, msg );
+
+      connection_ptr bc;
+      signed_block_ptr blk;
+      while( sync_master->next_buffered_block( bc, blk ) ) {
+         accept_signed_block( bc, blk );
+      }
+   }
+
+   void net_plugin_impl::accept_signed_block(const connection_ptr& c, const signed_block_ptr& msg) {
       controller &cc = chain_plug->chain();
       block_id_type blk_id = msg->id();
       uint32_t blk_num = msg->block_num();
-      fc_dlog(logger, "canceling wait on ${p}", ("p",c->peer_name()));
-      c->cancel_wait();
 
       try {
          if( cc.fetch_block_by_id(blk_id)) {
             if( sync_master->syncing_with_peer() )
                sync_master->recv_block( c, blk_id, blk_num );
-            c->cancel_wait();
             return;
          }
       } catch( ...) {
@@ -2896,6 +3367,8 @@ namespace eosio {
 #else
       hello.os = "other";
 #endif
+      if( my_impl->p2p_compression )
+         hello.os += os_compressed_blocks_suffix;
       hello.agent = my_impl->user_agent_name;
 
 
@@ -2951,7 +3424,10 @@ namespace eosio {
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+         ( "sync-fetch-peers", bpo::value<uint32_t>()->default_value(def_sync_fetch_peers), "maximum number of peers to retrieve chunks from concurrently during synchronization")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable expirimental socket read watermark optimization")
+         ( "p2p-compression", bpo::value<bool>()->default_value(false),
+           "Compress blocks, including sync ranges, with zlib when sending to peers that enable it as well")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
            "Available Variables:\n"
@@ -2979,7 +3455,10 @@ namespace eosio {
          if( my->network_version_match )
             wlog( "network-version-match is DEPRECATED as it is a needless restriction" );
 
-         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>()));
+         const uint32_t sync_fetch_peers = options.at( "sync-fetch-peers" ).as<uint32_t>();
+         EOS_ASSERT( sync_fetch_peers > 0, chain::plugin_config_exception,
+                     "sync-fetch-peers ${num} must be greater than 0", ("num", sync_fetch_peers) );
+         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>(), sync_fetch_peers ));
          my->dispatcher.reset( new dispatch_manager );
 
          my->connector_period = std::chrono::seconds( options.at( "connection-cleanup-period" ).as<int>());
@@ -2992,6 +3471,7 @@ namespace eosio {
          my->started_sessions = 0;
 
          my->use_socket_read_watermark = options.at( "use-socket-read-watermark" ).as<bool>();
+         my->p2p_compression = options.at( "p2p-compression" ).as<bool>();
 
          if( options.count( "p2p-listen-endpoint" ) && options.at("p2p-listen-endpoint").as<string>().length()) {
             my->p2p_address = options.at( "p2p-listen-endpoint" ).as<string>();
@@ -0,0 +1,105 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/plugin_interface.hpp>
+#include <eosio/chain/trace.hpp>
+#include <eosio/chain/transaction_metadata.hpp>
+
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace eosio {
+
+   /**
+    * Queue of incoming transactions waiting for a block, ordered by a configurable policy.
+    *
+    *  - fifo:   arrival order
+    *  - fee:    highest fee per estimated CPU microsecond first. The fee of an action is the fee fio.fee schedules
+    *            for it, capped by its max_fee. The estimate is a moving average of the CPU billed to each action
+    *            name, see record_cpu_usage()
+    *  - fair:   round robin over first authorizers, so one account queueing many transactions only delays its own
+    *  - system: transactions carrying one of the priority actions first, then arrival order
+    *
+    * Ties keep arrival order. The queue is a binary heap, push and pop are O(log n).
+    */
+   class incoming_transaction_queue {
+   public:
+      enum class order_policy {
+         fifo,
+         fee,
+         fair,
+         system
+      };
+
+      struct entry {
+         chain::transaction_metadata_ptr                                         trx;
+         bool                                                                    persist_until_expired = false;
+         chain::plugin_interface::next_function<chain::transaction_trace_ptr>  next;
+         uint64_t                                                                fee = 0; ///< summed over actions, fee policy only
+      };
+
+      void set_policy( order_policy p, chain::flat_set<chain::action_name> priority_actions );
+
+      order_policy policy() const { return _policy; }
+
+      void push( entry e );
+
+      /// remove and return the entry the policy selects next, the queue must not be empty
+      entry pop();
+
+      size_t size() const { return _heap.size(); }
+
+      bool empty() const { return _heap.empty(); }
+
+      bool contains( const chain::transaction_id_type& id ) const { return _ids.count( id ) > 0; }
+
+      /// feed the CPU estimate of the fee policy with the billed CPU of an executed transaction
+      void record_cpu_usage( const chain::transaction& trx, uint32_t billed_cpu_us );
+
+      /// endpoint of the fio.fee fiofees table whose fee a FIO action charges, or nullptr if it charges none
+      static const char* fee_endpoint( chain::action_name action );
+
+      /// fee of a transaction after adding an action with max_fee whose endpoint fio.fee schedules scheduled_fee for,
+      /// saturating instead of wrapping
+      static uint64_t add_action_fee( uint64_t fee, int64_t max_fee, uint64_t scheduled_fee );
+
+   private:
+      struct node {
+         uint64_t              rank = 0;
+         uint64_t              seq = 0;
+         chain::account_name   account; ///< fair policy only
+         entry                 e;
+      };
+
+      struct node_after {
+         bool operator()( const node& a, const node& b ) const {
+            return std::tie( a.rank, a.seq ) > std::tie( b.rank, b.seq );
+         }
+      };
+
+      struct account_share {
+         uint64_t last_tag = 0;
+         uint32_t queued = 0;
+      };
+
+      uint64_t rank( const entry& e, const chain::account_name& account );
+      uint64_t estimate_cpu_us( const chain::transaction& trx ) const;
+
+      order_policy                               _policy = order_policy::fifo;
+      chain::flat_set<chain::action_name>        _priority_actions;
+      std::vector<node>                          _heap;
+      std::multiset<chain::transaction_id_type>  _ids;                ///< of the queued entries
+      uint64_t                                   _next_seq = 0;
+      uint64_t                                   _virtual_time = 0;   ///< tag of the last entry popped, fair policy
+      std::map<chain::account_name, account_share> _accounts;         ///< accounts with queued entries, fair policy
+      std::map<chain::action_name, uint64_t>     _cpu_estimates;      ///< moving average of billed CPU per action
+   };
+
+   std::istream& operator>>( std::istream& in, incoming_transaction_queue::order_policy& p );
+   std::ostream& operator<<( std::ostream& osm, incoming_transaction_queue::order_policy p );
+
+} // eosio
@@ -0,0 +1,121 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
+#include <fstream>
+#include <future>
+
+namespace eosio {
+
+   /**
+    * Append-only file of the transactions queued by the producer plugin, so that they can be resubmitted after a
+    * restart instead of being retried by every client at once.
+    *
+    * Each record is [uint32 payload size][uint32 crc32 of payload][payload]. The payload is a record_kind followed by
+    * the transaction id, then for added transactions the expiration, the persist_until_expired flag and the
+    * packed_transaction. A record torn by a crash fails its size or checksum check and is truncated away on open,
+    * along with anything after it.
+    *
+    * Only the id, file offset and expiration of live transactions are kept in memory. read() unpacks transactions
+    * from a read-only mapping of the file. Expired and removed transactions become dead bytes, which compact()
+    * drops by copying the live records to a new file on a background thread. The next compact() call after the
+    * copy completes appends the records logged in the meantime and renames the new file over the log.
+    */
+   class pending_transaction_log {
+   public:
+      struct logged_transaction {
+         chain::packed_transaction_ptr trx;
+         bool                          persist_until_expired = false;
+      };
+
+      explicit pending_transaction_log( const fc::path& file );
+
+      /// waits for a running rewrite and completes it
+      ~pending_transaction_log();
+
+      bool contains( const chain::transaction_id_type& id ) const;
+
+      /// no-op if id is already in the log
+      void add( const chain::transaction_id_type& id, const chain::packed_transaction& trx, bool persist_until_expired );
+
+      /// no-op if id is not in the log
+      void remove( const chain::transaction_id_type& id );
+
+      /// push appended records to the OS, they then survive a crash of the process
+      void flush();
+
+      /// forget transactions that expire before now
+      void drop_expired( const fc::time_point& now );
+
+      /**
+       * drop_expired(now), then start rewriting the file once dead bytes outweigh live ones, or complete a
+       * rewrite whose copy is done. Completing a rewrite moves the live records, so it invalidates offsets
+       * returned by live_offsets().
+       */
+      void compact( const fc::time_point& now );
+
+      size_t size() const { return entries.size(); }
+
+      /// file offsets of the live transactions, in the order they were added
+      std::vector<uint64_t> live_offsets() const;
+
+      /// unpack the transactions at offsets[first, first + count), skipping any no longer live
+      std::vector<logged_transaction> read( const std::vector<uint64_t>& offsets, size_t first, size_t count ) const;
+
+   private:
+      enum class record_kind : uint8_t {
+         add = 0,
+         remove = 1
+      };
+
+      struct entry {
+         chain::transaction_id_type id;
+         uint64_t                   offset = 0;
+         uint32_t                   size = 0;   ///< of the whole record
+         fc::time_point             expiry;
+      };
+
+      struct by_id;
+      struct by_expiry;
+      struct by_offset;
+
+      using entry_index = boost::multi_index_container<
+         entry,
+         boost::multi_index::indexed_by<
+            boost::multi_index::hashed_unique<boost::multi_index::tag<by_id>,
+               BOOST_MULTI_INDEX_MEMBER(entry, chain::transaction_id_type, id)>,
+            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_expiry>,
+               BOOST_MULTI_INDEX_MEMBER(entry, fc::time_point, expiry)>,
+            boost::multi_index::ordered_unique<boost::multi_index::tag<by_offset>,
+               BOOST_MULTI_INDEX_MEMBER(entry, uint64_t, offset)>
+         >
+      >;
+
+      /// offset and size of a record copied by a rewrite
+      using record_span = std::pair<uint64_t, uint32_t>;
+
+      void load();
+      uint32_t append( const std::vector<char>& payload );
+      void start_rewrite();
+      void finish_rewrite();
+
+      fc::path                  file;
+      std::ofstream             out;
+      uint64_t                  end = 0;        ///< file size
+      uint64_t                  live_bytes = 0; ///< bytes of the add records in entries
+      entry_index               entries;
+      std::future<void>         rewrite_copy;    ///< valid while a rewrite is running
+      std::vector<record_span>  rewrite_records; ///< live records when the rewrite started, in file order
+      uint64_t                  rewrite_end = 0; ///< file size when the rewrite started
+   };
+
+} // eosio
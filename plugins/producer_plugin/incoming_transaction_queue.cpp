@@ -0,0 +1,168 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/producer_plugin/incoming_transaction_queue.hpp>
+#include <eosio/chain/config.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace eosio {
+
+   using namespace eosio::chain;
+
+   namespace {
+      const uint64_t default_action_cpu_us = config::default_min_transaction_cpu_usage;
+
+      // fiofees endpoint of every FIO action that charges a fee
+      const flat_map<action_name, const char*> fee_endpoints = {
+         // fio.address actions
+         {N(regaddress), "register_fio_address"}, {N(regdomain), "register_fio_domain"},
+         {N(addaddress), "add_pub_address"}, {N(remaddress), "remove_pub_address"},
+         {N(remalladdr), "remove_all_pub_addresses"}, {N(renewdomain), "renew_fio_domain"},
+         {N(renewaddress), "renew_fio_address"}, {N(setdomainpub), "set_fio_domain_public"},
+         {N(burnexpired), "burn_expired"}, {N(xferdomain), "transfer_fio_domain"},
+         {N(xferaddress), "transfer_fio_address"},
+
+         // fio.fee actions
+         {N(setfeemult), "submit_fee_multiplier"}, {N(bundlevote), "submit_bundled_transaction"},
+         {N(setfeevote), "submit_fee_ratios"},
+
+         // fio.treasury actions
+         {N(tpidclaim), "pay_tpid_rewards"}, {N(bpclaim), "claim_bp_rewards"},
+
+         // fio.token actions
+         {N(trnsfiopubky), "transfer_tokens_pub_key"},
+
+         // fio.request.obt actions
+         {N(recordobt), "record_obt_data"}, {N(rejectfndreq), "reject_funds_request"},
+         {N(cancelfndreq), "cancel_funds_request"}, {N(newfundsreq), "new_funds_request"},
+
+         // system actions
+         {N(regproducer), "register_producer"}, {N(unregprod), "unregister_producer"},
+         {N(regproxy), "register_proxy"}, {N(unregproxy), "unregister_proxy"},
+         {N(voteproducer), "vote_producer"}, {N(voteproxy), "proxy_vote"}
+      };
+   }
+
+   void incoming_transaction_queue::set_policy( order_policy p, flat_set<action_name> priority_actions ) {
+      EOS_ASSERT( _heap.empty(), producer_exception, "cannot change the order of a non-empty incoming transaction queue" );
+      _policy = p;
+      _priority_actions = std::move( priority_actions );
+   }
+
+   uint64_t incoming_transaction_queue::estimate_cpu_us( const transaction& trx ) const {
+      uint64_t cpu_us = 0;
+      for( const auto& act : trx.actions ) {
+         auto itr = _cpu_estimates.find( act.name );
+         cpu_us += itr == _cpu_estimates.end() ? default_action_cpu_us : itr->second;
+      }
+      return std::max<uint64_t>( cpu_us, 1 );
+   }
+
+   uint64_t incoming_transaction_queue::rank( const entry& e, const account_name& account ) {
+      switch( _policy ) {
+         case order_policy::fifo:
+            return 0;
+         case order_policy::fee:
+            return std::numeric_limits<uint64_t>::max() - e.fee / estimate_cpu_us( e.trx->packed_trx->get_transaction() );
+         case order_policy::fair: {
+            // start-time fair queueing: each account's entries are spaced one tag apart, starting no earlier than now
+            auto& share = _accounts[account];
+            share.last_tag = std::max( share.last_tag, _virtual_time ) + 1;
+            ++share.queued;
+            return share.last_tag;
+         }
+         case order_policy::system:
+            for( const auto& act : e.trx->packed_trx->get_transaction().actions ) {
+               if( _priority_actions.find( act.name ) != _priority_actions.end() ) return 0;
+            }
+            return 1;
+      }
+      return 0;
+   }
+
+   void incoming_transaction_queue::push( entry e ) {
+      node n;
+      if( _policy == order_policy::fair ) {
+         n.account = e.trx->packed_trx->get_transaction().first_authorizer();
+      }
+      n.rank = rank( e, n.account );
+      n.seq = _next_seq++;
+      _ids.insert( e.trx->id );
+      n.e = std::move( e );
+      _heap.push_back( std::move( n ) );
+      std::push_heap( _heap.begin(), _heap.end(), node_after() );
+   }
+
+   incoming_transaction_queue::entry incoming_transaction_queue::pop() {
+      std::pop_heap( _heap.begin(), _heap.end(), node_after() );
+      node n = std::move( _heap.back() );
+      _heap.pop_back();
+      _ids.erase( _ids.find( n.e.trx->id ) );
+
+      if( _policy == order_policy::fair ) {
+         _virtual_time = std::max( _virtual_time, n.rank );
+         auto itr = _accounts.find( n.account );
+         if( itr != _accounts.end() && --itr->second.queued == 0 ) {
+            _accounts.erase( itr );
+         }
+      }
+      return std::move( n.e );
+   }
+
+   void incoming_transaction_queue::record_cpu_usage( const transaction& trx, uint32_t billed_cpu_us ) {
+      if( _policy != order_policy::fee || trx.actions.empty() ) return;
+      const uint64_t per_action = billed_cpu_us / trx.actions.size();
+      for( const auto& act : trx.actions ) {
+         auto itr = _cpu_estimates.find( act.name );
+         if( itr == _cpu_estimates.end() ) {
+            _cpu_estimates.emplace( act.name, std::max<uint64_t>( per_action, 1 ) );
+         } else {
+            itr->second = std::max<uint64_t>( ( itr->second * 7 + per_action ) / 8, 1 );
+         }
+      }
+   }
+
+   const char* incoming_transaction_queue::fee_endpoint( action_name action ) {
+      auto itr = fee_endpoints.find( action );
+      return itr == fee_endpoints.end() ? nullptr : itr->second;
+   }
+
+   uint64_t incoming_transaction_queue::add_action_fee( uint64_t fee, int64_t max_fee, uint64_t scheduled_fee ) {
+      if( max_fee <= 0 ) return fee;
+      const uint64_t action_fee = std::min<uint64_t>( max_fee, scheduled_fee );
+      return action_fee > std::numeric_limits<uint64_t>::max() - fee ? std::numeric_limits<uint64_t>::max()
+                                                                     : fee + action_fee;
+   }
+
+   std::istream& operator>>( std::istream& in, incoming_transaction_queue::order_policy& p ) {
+      std::string s;
+      in >> s;
+      if( s == "fifo" ) {
+         p = incoming_transaction_queue::order_policy::fifo;
+      } else if( s == "fee" ) {
+         p = incoming_transaction_queue::order_policy::fee;
+      } else if( s == "fair" ) {
+         p = incoming_transaction_queue::order_policy::fair;
+      } else if( s == "system" ) {
+         p = incoming_transaction_queue::order_policy::system;
+      } else {
+         in.setstate( std::ios_base::failbit );
+      }
+      return in;
+   }
+
+   std::ostream& operator<<( std::ostream& osm, incoming_transaction_queue::order_policy p ) {
+      switch( p ) {
+         case incoming_transaction_queue::order_policy::fifo:   osm << "fifo"; break;
+         case incoming_transaction_queue::order_policy::fee:    osm << "fee"; break;
+         case incoming_transaction_queue::order_policy::fair:   osm << "fair"; break;
+         case incoming_transaction_queue::order_policy::system: osm << "system"; break;
+      }
+      return osm;
+   }
+
+} // eosio
@@ -0,0 +1,330 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE
+ */
+#include <eosio/producer_plugin/pending_transaction_log.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/scoped_exit.hpp>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace eosio {
+
+   using namespace eosio::chain;
+
+   namespace {
+
+      constexpr uint32_t record_header_size = 2 * sizeof(uint32_t);
+      constexpr uint64_t min_compact_bytes = 1024 * 1024;
+
+      template<typename... Ts>
+      std::vector<char> pack_payload( const Ts&... values ) {
+         fc::datastream<size_t> ps;
+         ( fc::raw::pack( ps, values ), ... );
+         std::vector<char> payload( ps.tellp() );
+         fc::datastream<char*> ds( payload.data(), payload.size() );
+         ( fc::raw::pack( ds, values ), ... );
+         return payload;
+      }
+
+      uint32_t crc32( const char* data, size_t size ) {
+         boost::crc_32_type crc;
+         crc.process_bytes( data, size );
+         return crc.checksum();
+      }
+
+      /// read-only mapping of the whole file, empty for an empty file
+      struct file_view {
+         explicit file_view( const fc::path& file ) {
+            const auto size = fc::file_size( file );
+            if( size > 0 ) {
+               mapping = boost::interprocess::file_mapping( file.generic_string().c_str(), boost::interprocess::read_only );
+               region = boost::interprocess::mapped_region( mapping, boost::interprocess::read_only, 0, size );
+            }
+         }
+
+         const char* data() const { return static_cast<const char*>( region.get_address() ); }
+         uint64_t size() const { return region.get_size(); }
+
+         boost::interprocess::file_mapping  mapping;
+         boost::interprocess::mapped_region region;
+      };
+
+      fc::path tmp_path( const fc::path& file ) {
+         return file.string() + ".tmp";
+      }
+
+      /// push what was written to path to the device, path may be a directory
+      void sync_path( const fc::path& path ) {
+         const int fd = ::open( path.generic_string().c_str(), O_RDONLY );
+         EOS_ASSERT( fd >= 0, producer_exception, "unable to open ${f} to sync it", ("f", path) );
+         const int r = ::fsync( fd );
+         ::close( fd );
+         EOS_ASSERT( r == 0, producer_exception, "unable to sync ${f}", ("f", path) );
+      }
+
+      /**
+       * Copy the records at (offset, size) of from to a new file to, and sync it. Runs off the main thread, from
+       * is only read up to the end of the last record, which the main thread no longer writes.
+       */
+      void copy_records( const fc::path& from, const fc::path& to, const std::vector<std::pair<uint64_t, uint32_t>>& records ) {
+         file_view view( from );
+         {
+            std::ofstream tmp_out( to.generic_string(), std::ios::binary | std::ios::trunc );
+            tmp_out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+            for( const auto& r : records ) {
+               tmp_out.write( view.data() + r.first, r.second );
+            }
+            tmp_out.flush();
+         }
+         // the copy must be on disk before it can replace the log, or a power loss could leave a log of garbage
+         sync_path( to );
+         sync_path( to.parent_path() );
+      }
+
+   } // anonymous namespace
+
+   pending_transaction_log::pending_transaction_log( const fc::path& file )
+   : file( file ) {
+      load();
+   }
+
+   pending_transaction_log::~pending_transaction_log() {
+      if( rewrite_copy.valid() ) {
+         try {
+            rewrite_copy.wait();
+            finish_rewrite();
+         } FC_LOG_AND_DROP()
+      }
+   }
+
+   void pending_transaction_log::load() {
+      boost::system::error_code ec;
+      boost::filesystem::remove( tmp_path( file ).string(), ec );
+      if( !fc::exists( file ) ) {
+         std::ofstream create( file.generic_string(), std::ios::binary );
+      }
+
+      uint64_t pos = 0;
+      {
+         file_view view( file );
+         while( pos + record_header_size <= view.size() ) {
+            uint32_t payload_size = 0;
+            uint32_t checksum = 0;
+            memcpy( &payload_size, view.data() + pos, sizeof(payload_size) );
+            memcpy( &checksum, view.data() + pos + sizeof(payload_size), sizeof(checksum) );
+            const uint64_t record_size = record_header_size + uint64_t( payload_size );
+            if( pos + record_size > view.size() ) break;
+            const char* payload = view.data() + pos + record_header_size;
+            if( crc32( payload, payload_size ) != checksum ) break;
+
+            fc::datastream<const char*> ds( payload, payload_size );
+            uint8_t kind = 0;
+            transaction_id_type id;
+            fc::raw::unpack( ds, kind );
+            fc::raw::unpack( ds, id );
+            if( kind == static_cast<uint8_t>( record_kind::add ) ) {
+               uint32_t expiration = 0;
+               fc::raw::unpack( ds, expiration );
+               if( entries.insert( entry{id, pos, static_cast<uint32_t>( record_size ), fc::time_point( fc::seconds( expiration ) )} ).second ) {
+                  live_bytes += record_size;
+               }
+            } else {
+               auto& by_id_idx = entries.get<by_id>();
+               auto itr = by_id_idx.find( id );
+               if( itr != by_id_idx.end() ) {
+                  live_bytes -= itr->size;
+                  by_id_idx.erase( itr );
+               }
+            }
+            pos += record_size;
+         }
+         if( pos < view.size() ) {
+            wlog( "Dropping ${n} bytes of incomplete records at the end of ${f}", ("n", view.size() - pos)("f", file) );
+         }
+      }
+      boost::filesystem::resize_file( file, pos );
+      end = pos;
+
+      out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+      out.open( file.generic_string(), std::ios::binary | std::ios::app );
+      ilog( "Loaded ${n} pending transactions from ${f}", ("n", entries.size())("f", file) );
+   }
+
+   bool pending_transaction_log::contains( const transaction_id_type& id ) const {
+      const auto& by_id_idx = entries.get<by_id>();
+      return by_id_idx.find( id ) != by_id_idx.end();
+   }
+
+   uint32_t pending_transaction_log::append( const std::vector<char>& payload ) {
+      const uint32_t payload_size = payload.size();
+      const uint32_t checksum = crc32( payload.data(), payload.size() );
+      out.write( reinterpret_cast<const char*>( &payload_size ), sizeof(payload_size) );
+      out.write( reinterpret_cast<const char*>( &checksum ), sizeof(checksum) );
+      out.write( payload.data(), payload.size() );
+      const uint32_t record_size = record_header_size + payload_size;
+      end += record_size;
+      return record_size;
+   }
+
+   void pending_transaction_log::add( const transaction_id_type& id, const packed_transaction& trx, bool persist_until_expired ) {
+      if( contains( id ) ) return;
+      const uint32_t expiration = trx.expiration().sec_since_epoch();
+      const auto offset = end;
+      const auto record_size = append( pack_payload( static_cast<uint8_t>( record_kind::add ), id, expiration,
+                                                     persist_until_expired, trx ) );
+      entries.insert( entry{id, offset, record_size, fc::time_point( fc::seconds( expiration ) )} );
+      live_bytes += record_size;
+   }
+
+   void pending_transaction_log::remove( const transaction_id_type& id ) {
+      auto& by_id_idx = entries.get<by_id>();
+      auto itr = by_id_idx.find( id );
+      if( itr == by_id_idx.end() ) return;
+      live_bytes -= itr->size;
+      by_id_idx.erase( itr );
+      append( pack_payload( static_cast<uint8_t>( record_kind::remove ), id ) );
+   }
+
+   void pending_transaction_log::flush() {
+      out.flush();
+   }
+
+   void pending_transaction_log::drop_expired( const fc::time_point& now ) {
+      auto& by_expiry_idx = entries.get<by_expiry>();
+      while( !by_expiry_idx.empty() && by_expiry_idx.begin()->expiry < now ) {
+         live_bytes -= by_expiry_idx.begin()->size;
+         by_expiry_idx.erase( by_expiry_idx.begin() );
+      }
+   }
+
+   void pending_transaction_log::compact( const fc::time_point& now ) {
+      drop_expired( now );
+
+      if( rewrite_copy.valid() ) {
+         if( rewrite_copy.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready ) {
+            finish_rewrite();
+         }
+         return;
+      }
+
+      const uint64_t dead_bytes = end - live_bytes;
+      if( dead_bytes > live_bytes && dead_bytes > min_compact_bytes ) {
+         start_rewrite();
+      }
+   }
+
+   void pending_transaction_log::start_rewrite() {
+      out.flush();
+      rewrite_records.clear();
+      rewrite_records.reserve( entries.size() );
+      for( const auto& e : entries.get<by_offset>() ) {
+         rewrite_records.emplace_back( e.offset, e.size );
+      }
+      rewrite_end = end;
+      rewrite_copy = std::async( std::launch::async, [from = file, to = tmp_path( file ), records = rewrite_records]() {
+         copy_records( from, to, records );
+      } );
+   }
+
+   void pending_transaction_log::finish_rewrite() {
+      auto clear = fc::make_scoped_exit( [this]() {
+         rewrite_records = std::vector<record_span>();
+      } );
+      const fc::path tmp = tmp_path( file );
+      auto abandon = [&]( const std::string& why ) {
+         wlog( "Compacting ${f} failed, keeping it as is: ${e}", ("f", file)("e", why) );
+         boost::system::error_code ec;
+         boost::filesystem::remove( tmp.string(), ec );
+      };
+      try {
+         rewrite_copy.get();
+      } catch( const fc::exception& e ) {
+         return abandon( e.to_detail_string() );
+      } catch( const std::exception& e ) {
+         return abandon( e.what() );
+      }
+
+      // records logged while the copy ran follow the copied ones
+      out.flush();
+      uint64_t copied = 0;
+      for( const auto& r : rewrite_records ) {
+         copied += r.second;
+      }
+      if( end > rewrite_end ) {
+         file_view view( file );
+         std::ofstream tmp_out( tmp.generic_string(), std::ios::binary | std::ios::app );
+         tmp_out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+         tmp_out.write( view.data() + rewrite_end, end - rewrite_end );
+         tmp_out.flush();
+      }
+
+      // entries only lost records older than the rewrite since it started, so each of those left was copied
+      entry_index rewritten;
+      auto rec = rewrite_records.begin();
+      uint64_t pos = 0;
+      for( const auto& e : entries.get<by_offset>() ) {
+         if( e.offset < rewrite_end ) {
+            for( ; rec->first != e.offset; ++rec ) {
+               pos += rec->second;
+            }
+            rewritten.insert( entry{e.id, pos, e.size, e.expiry} );
+         } else {
+            rewritten.insert( entry{e.id, copied + e.offset - rewrite_end, e.size, e.expiry} );
+         }
+      }
+
+      out.close();
+      fc::rename( tmp, file );
+      out.open( file.generic_string(), std::ios::binary | std::ios::app );
+      const uint64_t new_end = copied + ( end - rewrite_end );
+      dlog( "Compacted ${f} from ${o} to ${n} bytes", ("f", file)("o", end)("n", new_end) );
+      entries = std::move( rewritten );
+      end = new_end;
+   }
+
+   std::vector<uint64_t> pending_transaction_log::live_offsets() const {
+      std::vector<uint64_t> offsets;
+      offsets.reserve( entries.size() );
+      for( const auto& e : entries.get<by_offset>() ) {
+         offsets.push_back( e.offset );
+      }
+      return offsets;
+   }
+
+   std::vector<pending_transaction_log::logged_transaction>
+   pending_transaction_log::read( const std::vector<uint64_t>& offsets, size_t first, size_t count ) const {
+      std::vector<logged_transaction> result;
+      const auto& by_offset_idx = entries.get<by_offset>();
+      file_view view( file );
+      for( size_t i = first; i < offsets.size() && i < first + count; ++i ) {
+         auto itr = by_offset_idx.find( offsets[i] );
+         if( itr == by_offset_idx.end() || itr->offset + itr->size > view.size() ) continue;
+
+         fc::datastream<const char*> ds( view.data() + itr->offset + record_header_size, itr->size - record_header_size );
+         uint8_t kind = 0;
+         transaction_id_type id;
+         uint32_t expiration = 0;
+         bool persist_until_expired = false;
+         fc::raw::unpack( ds, kind );
+         fc::raw::unpack( ds, id );
+         fc::raw::unpack( ds, expiration );
+         fc::raw::unpack( ds, persist_until_expired );
+         auto trx = std::make_shared<packed_transaction>();
+         fc::raw::unpack( ds, *trx );
+         result.push_back( logged_transaction{std::move( trx ), persist_until_expired} );
+      }
+      return result;
+   }
+
+} // eosio
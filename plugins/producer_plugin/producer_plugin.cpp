@@ -3,12 +3,16 @@
  *  @copyright defined in eos/LICENSE
  */
 #include <eosio/producer_plugin/producer_plugin.hpp>
+#include <eosio/producer_plugin/incoming_transaction_queue.hpp>
+#include <eosio/producer_plugin/pending_transaction_log.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
 #include <eosio/chain/transaction_object.hpp>
+#include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/fioio/actionmapping.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
@@ -87,6 +91,93 @@ namespace {
              (code == block_net_usage_exceeded::code_value) ||
              (code == deadline_exception::code_value && deadline_is_subjective);
    }
+
+   const size_t pending_trx_reload_batch = 1000; ///< logged transactions resubmitted while admission is backed up
+
+   /**
+    * Chain values read on the main thread for the stateless checks run on incoming transactions
+    * by the producer thread pool.
+    */
+   struct admission_context {
+      chain_id_type                   chain_id;
+      fc::time_point                  reference_time;
+      uint32_t                        max_transaction_lifetime = 0;
+      chain_config                    config;
+      fc::microseconds                max_recover_time;
+      bool                            action_registry = false; ///< after HF1 actions are checked against registered_actions
+      flat_set<uint64_t>              registered_actions;
+      std::map<account_name, chain_apis::cached_abi_ptr> abis; ///< contracts of the admitted actions, fee order only
+      std::map<action_name, uint64_t> scheduled_fees; ///< fio.fee fees of the admitted actions, fee order only
+      fc::microseconds                abi_max_time;
+   };
+
+   /**
+    * Fee the actions of t are expected to pay: for each action the fee fio.fee schedules for it, capped by its
+    * max_fee argument. The sum saturates.
+    */
+   uint64_t expected_fee( const admission_context& ctx, const transaction& t ) {
+      uint64_t fee = 0;
+      for( const auto& act : t.actions ) {
+         if( act.account.value != fioio::map_to_contract( act.name.value ) ) continue;
+         auto scheduled = ctx.scheduled_fees.find( act.name );
+         if( scheduled == ctx.scheduled_fees.end() || scheduled->second == 0 ) continue;
+         auto itr = ctx.abis.find( act.account );
+         if( itr == ctx.abis.end() || !itr->second ) continue;
+         const auto& serializer = itr->second->serializer;
+         const auto type = serializer.get_action_type( act.name );
+         if( type.empty() ) continue;
+         try {
+            const auto args = serializer.binary_to_variant( type, act.data, ctx.abi_max_time );
+            if( args.is_object() && args.get_object().contains( "max_fee" ) ) {
+               fee = incoming_transaction_queue::add_action_fee( fee, args["max_fee"].as_int64(), scheduled->second );
+            }
+         } catch( const fc::exception& ) {
+            // malformed action data only costs the transaction its place, execution rejects it
+         }
+      }
+      return fee;
+   }
+
+   void check_fio_action( const admission_context& ctx, const action& act ) {
+      if( act.name == name("nonce") ) return;
+      if( ctx.action_registry ) {
+         EOS_ASSERT( ctx.registered_actions.find( act.name.value ) != ctx.registered_actions.end(), action_validate_exception,
+                     "Unknown action ${action} in contract ${contract}", ("action", act.name)("contract", act.account) );
+      } else {
+         EOS_ASSERT( act.account.value == fioio::map_to_contract( act.name.value ), action_validate_exception,
+                     "Unknown action ${action} in contract ${contract}", ("action", act.name)("contract", act.account) );
+      }
+   }
+
+   /**
+    * Checks of an incoming transaction that do not read chain state: expiration window, initial net usage and
+    * the FIO action mapping applied by apply_context::exec_one. They reject early what the controller
+    * would reject once the transaction is pushed.
+    */
+   void check_incoming_transaction( const admission_context& ctx, const transaction_metadata& trx ) {
+      const transaction& t = trx.packed_trx->get_transaction();
+      EOS_ASSERT( fc::time_point( t.expiration ) >= ctx.reference_time, expired_tx_exception,
+                  "expired transaction ${id}", ("id", trx.id) );
+      EOS_ASSERT( fc::time_point( t.expiration ) <= ctx.reference_time + fc::seconds( ctx.max_transaction_lifetime ),
+                  tx_exp_too_far_exception,
+                  "Transaction expiration is too far in the future relative to the reference time of ${reference_time}, "
+                  "expiration is ${trx.expiration} and the maximum transaction lifetime is ${max_til_exp} seconds",
+                  ("trx.expiration", t.expiration)("reference_time", ctx.reference_time)
+                  ("max_til_exp", ctx.max_transaction_lifetime) );
+      // the net usage the chain bills before execution, which it rejects when over the objective limit
+      const uint64_t net_usage = transaction_context::initial_input_trx_net_usage( ctx.config, t,
+                                                                                  trx.packed_trx->get_unprunable_size(),
+                                                                                  trx.packed_trx->get_prunable_size() );
+      EOS_ASSERT( net_usage <= ctx.config.max_transaction_net_usage, tx_net_usage_exceeded,
+                  "transaction net usage ${s} exceeds the maximum transaction net usage ${m}",
+                  ("s", net_usage)("m", ctx.config.max_transaction_net_usage) );
+      for( const auto& act : t.context_free_actions ) {
+         check_fio_action( ctx, act );
+      }
+      for( const auto& act : t.actions ) {
+         check_fio_action( ctx, act );
+      }
+   }
 }
 
 struct transaction_id_with_expiry {
@@ -207,6 +298,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       bool process_unapplied_trxs( const fc::time_point& deadline );
       bool process_scheduled_and_incoming_trxs( const fc::time_point& deadline, size_t& orig_pending_txn_size );
       bool process_incoming_trxs( const fc::time_point& deadline, size_t& orig_pending_txn_size );
+      void admit_incoming_trxs();
+      void reject_incoming_transaction( const transaction_metadata_ptr& trx, const fc::exception_ptr& e,
+                                        const next_function<transaction_trace_ptr>& next, bool forget = true );
+      void reload_pending_trxs();
 
       boost::program_options::variables_map _options;
       bool     _production_enabled                 = false;
@@ -221,6 +316,11 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       pending_block_mode                                        _pending_block_mode;
       transaction_id_with_expiry_index                          _persistent_transactions;
       fc::optional<named_thread_pool>                           _thread_pool;
+      uint16_t                                                  _thread_pool_size = 0;
+      uint32_t                                                  _incoming_trx_batch_size = 0;
+      std::unique_ptr<pending_transaction_log>                  _pending_trx_log;
+      std::vector<uint64_t>                                     _reload_offsets; ///< logged transactions left to resubmit after startup
+      size_t                                                    _reload_pos = 0;
 
       int32_t                                                   _max_transaction_time_ms;
       fc::microseconds                                          _max_irreversible_block_age_us;
@@ -297,6 +397,17 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          _irreversible_block_time = lib->timestamp.to_time_point();
          const chain::controller& chain = chain_plug->chain();
 
+         if( _pending_trx_log && _pending_trx_log->size() > 0 ) {
+            for( const auto& receipt : lib->transactions ) {
+               if( receipt.trx.contains<packed_transaction>() ) {
+                  _pending_trx_log->remove( receipt.trx.get<packed_transaction>().id() );
+               }
+            }
+            if( _reload_offsets.empty() ) {
+               _pending_trx_log->compact( fc::time_point::now() );
+            }
+         }
+
          // promote any pending snapshots
          auto& snapshots_by_height = _pending_snapshot_index.get<by_height>();
          uint32_t lib_height = lib->block_num();
@@ -412,47 +523,54 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
       }
 
-      std::deque<std::tuple<transaction_metadata_ptr, bool, next_function<transaction_trace_ptr>>> _pending_incoming_transactions;
+      incoming_transaction_queue _pending_incoming_transactions;
+
+      struct incoming_transaction {
+         transaction_metadata_ptr               trx;
+         bool                                   persist_until_expired = false;
+         next_function<transaction_trace_ptr>   next;
+         fc::exception_ptr                      except;
+         uint64_t                               fee = 0;
+      };
+      using incoming_batch_ptr = std::shared_ptr<std::vector<incoming_transaction>>;
 
+      std::vector<incoming_transaction>                         _admission_queue;
+      bool                                                      _admission_scheduled = false;
+      std::set<transaction_id_type, sha256_less>                _admitting_trx_ids; ///< ids between admit_incoming_trxs and the main thread
+
+      /**
+       * Incoming transactions are queued and admitted in batches by admit_incoming_trxs, which runs once
+       * per main thread pass over the queue.
+       */
       void on_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
-         chain::controller& chain = chain_plug->chain();
-         const auto& cfg = chain.get_global_properties().configuration;
-         signing_keys_future_type future = transaction_metadata::start_recover_keys( trx, _thread_pool->get_executor(),
-               chain.get_chain_id(), fc::microseconds( cfg.max_transaction_cpu_usage ) );
-         boost::asio::post( _thread_pool->get_executor(), [self = this, future, trx, persist_until_expired, next]() {
-            if( future.valid() )
-               future.wait();
-            app().post(priority::low, [self, trx, persist_until_expired, next]() {
-               self->process_incoming_transaction_async( trx, persist_until_expired, next );
+         if( _pending_trx_log ) {
+            try {
+               _pending_trx_log->add( trx->id, *trx->packed_trx, persist_until_expired );
+            } LOG_AND_DROP();
+         }
+         _admission_queue.push_back( incoming_transaction{trx, persist_until_expired, std::move(next), nullptr} );
+         if( !_admission_scheduled ) {
+            _admission_scheduled = true;
+            app().post(priority::low, [self = this]() {
+               self->admit_incoming_trxs();
             });
-         });
+         }
       }
 
-      void process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
+      void process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next, uint64_t fee = 0) {
          chain::controller& chain = chain_plug->chain();
          if (!chain.is_building_block()) {
-            _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+            _pending_incoming_transactions.push({trx, persist_until_expired, next, fee});
             return;
          }
 
          auto block_time = chain.pending_block_time();
 
          auto send_response = [this, &trx, &chain, &next](const fc::static_variant<fc::exception_ptr, transaction_trace_ptr>& response) {
-            next(response);
             if (response.contains<fc::exception_ptr>()) {
-               _transaction_ack_channel.publish(priority::low, std::pair<fc::exception_ptr, transaction_metadata_ptr>(response.get<fc::exception_ptr>(), trx));
-               if (_pending_block_mode == pending_block_mode::producing) {
-                  fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} is REJECTING tx: ${txid} : ${why} ",
-                        ("block_num", chain.head_block_num() + 1)
-                        ("prod", chain.pending_block_producer())
-                        ("txid", trx->id)
-                        ("why",response.get<fc::exception_ptr>()->what()));
-               } else {
-                  fc_dlog(_trx_trace_log, "[TRX_TRACE] Speculative execution is REJECTING tx: ${txid} : ${why} ",
-                          ("txid", trx->id)
-                          ("why",response.get<fc::exception_ptr>()->what()));
-               }
+               reject_incoming_transaction(trx, response.get<fc::exception_ptr>(), next);
             } else {
+               next(response);
                _transaction_ack_channel.publish(priority::low, std::pair<fc::exception_ptr, transaction_metadata_ptr>(nullptr, trx));
                if (_pending_block_mode == pending_block_mode::producing) {
                   fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} is ACCEPTING tx: ${txid}",
@@ -473,7 +591,8 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
 
          if( chain.is_known_unexpired_transaction(id) ) {
-            send_response(std::static_pointer_cast<fc::exception>(std::make_shared<tx_duplicate>(FC_LOG_MESSAGE(error, "duplicate transaction ${id}", ("id", id)) )));
+            // the logged copy belongs to the transaction already in the chain
+            reject_incoming_transaction(trx, std::static_pointer_cast<fc::exception>(std::make_shared<tx_duplicate>(FC_LOG_MESSAGE(error, "duplicate transaction ${id}", ("id", id)) )), next, false);
             return;
          }
 
@@ -489,7 +608,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
             auto trace = chain.push_transaction(trx, deadline);
             if (trace->except) {
                if (failure_is_subjective(*trace->except, deadline_is_subjective)) {
-                  _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+                  _pending_incoming_transactions.push({trx, persist_until_expired, next, fee});
                   if (_pending_block_mode == pending_block_mode::producing) {
                      fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} COULD NOT FIT, tx: ${txid} RETRYING ",
                              ("block_num", chain.head_block_num() + 1)
@@ -509,6 +628,9 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                   // ensure its applied to all future speculative blocks as well.
                   _persistent_transactions.insert(transaction_id_with_expiry{trx->id, trx->packed_trx->expiration()});
                }
+               if (trace->receipt) {
+                  _pending_incoming_transactions.record_cpu_usage(trx->packed_trx->get_transaction(), trace->receipt->cpu_usage_us);
+               }
                send_response(trace);
             }
 
@@ -624,6 +746,20 @@ void producer_plugin::set_program_options(
           "ratio between incoming transations and deferred transactions when both are exhausted")
          ("producer-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
           "Number of worker threads in producer thread pool")
+         ("incoming-transaction-batch-size", bpo::value<uint32_t>()->default_value(64),
+          "Maximum number of incoming transactions checked and key recovered together by one producer thread")
+         ("persist-pending-transactions", bpo::value<bool>()->default_value(false),
+          "Log incoming transactions to pending_transactions.log in the data directory until they are irreversible, rejected or expired, and resubmit them on restart")
+         ("incoming-transaction-order", bpo::value<incoming_transaction_queue::order_policy>()->default_value(incoming_transaction_queue::order_policy::fifo),
+          "Order in which queued incoming transactions are applied:\n"
+          "   fifo   \tarrival order\n"
+          "   fee    \thighest scheduled fee, capped by max_fee, per estimated CPU microsecond first\n"
+          "   fair   \tround robin over the first authorizers of the transactions\n"
+          "   system \ttransactions with a priority-action first")
+         ("priority-action", bpo::value<vector<string>>()->composing()->multitoken()->default_value(
+               {"regproducer", "unregprod", "voteproducer", "voteproxy", "setfeevote", "setfeemult", "bundlevote"},
+               "regproducer unregprod voteproducer voteproxy setfeevote setfeemult bundlevote"),
+          "Action name given priority by the system incoming-transaction-order (may specify multiple times)")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
          ;
@@ -754,6 +890,20 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
 
    my->_max_scheduled_transaction_time_per_block_ms = options.at("max-scheduled-transaction-time-per-block-ms").as<int32_t>();
 
+   {
+      flat_set<action_name> priority_actions;
+      for( const auto& a : options.at( "priority-action" ).as<vector<string>>() ) {
+         priority_actions.insert( action_name( a ) );
+      }
+      my->_pending_incoming_transactions.set_policy(
+            options.at( "incoming-transaction-order" ).as<incoming_transaction_queue::order_policy>(),
+            std::move( priority_actions ) );
+   }
+
+   if( options.at( "persist-pending-transactions" ).as<bool>() ) {
+      my->_pending_trx_log = std::make_unique<pending_transaction_log>( app().data_dir() / "pending_transactions.log" );
+   }
+
    if( options.at( "subjective-cpu-leeway-us" ).as<int32_t>() != config::default_subjective_cpu_leeway_us ) {
       chain.set_subjective_cpu_leeway( fc::microseconds( options.at( "subjective-cpu-leeway-us" ).as<int32_t>() ) );
    }
@@ -768,6 +918,11 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
    EOS_ASSERT( thread_pool_size > 0, plugin_config_exception,
                "producer-threads ${num} must be greater than 0", ("num", thread_pool_size));
    my->_thread_pool.emplace( "prod", thread_pool_size );
+   my->_thread_pool_size = thread_pool_size;
+
+   my->_incoming_trx_batch_size = options.at( "incoming-transaction-batch-size" ).as<uint32_t>();
+   EOS_ASSERT( my->_incoming_trx_batch_size > 0, plugin_config_exception,
+               "incoming-transaction-batch-size ${num} must be greater than 0", ("num", my->_incoming_trx_batch_size));
 
    if( options.count( "snapshots-dir" )) {
       auto sd = options.at( "snapshots-dir" ).as<bfs::path>();
@@ -860,6 +1015,12 @@ void producer_plugin::plugin_startup()
 
    my->schedule_production_loop();
 
+   if( my->_pending_trx_log && my->_pending_trx_log->size() > 0 ) {
+      my->_pending_trx_log->drop_expired( fc::time_point::now() );
+      my->_reload_offsets = my->_pending_trx_log->live_offsets();
+      my->reload_pending_trxs();
+   }
+
    ilog("producer plugin:  plugin_startup() end");
    } catch( ... ) {
       // always call plugin_shutdown, even on exception
@@ -879,6 +1040,12 @@ void producer_plugin::plugin_shutdown() {
       my->_thread_pool->stop();
    }
 
+   if( my->_pending_trx_log ) {
+      try {
+         my->_pending_trx_log->flush();
+      } LOG_AND_DROP();
+   }
+
    app().post( 0, [me = my](){} ); // keep my pointer alive until queue is drained
 }
 
@@ -1676,11 +1843,10 @@ bool producer_plugin_impl::process_scheduled_and_incoming_trxs( const fc::time_p
             break;
          }
 
-         auto e = _pending_incoming_transactions.front();
-         _pending_incoming_transactions.pop_front();
+         auto e = _pending_incoming_transactions.pop();
          --pending_incoming_process_limit;
          incoming_trx_weight -= 1.0;
-         process_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+         process_incoming_transaction_async(e.trx, e.persist_until_expired, e.next, e.fee);
       }
 
       if (deadline <= fc::time_point::now()) {
@@ -1736,15 +1902,177 @@ bool producer_plugin_impl::process_incoming_trxs( const fc::time_point& deadline
             exhausted = true;
             break;
          }
-         auto e = _pending_incoming_transactions.front();
-         _pending_incoming_transactions.pop_front();
+         auto e = _pending_incoming_transactions.pop();
          --pending_incoming_process_limit;
-         process_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+         process_incoming_transaction_async(e.trx, e.persist_until_expired, e.next, e.fee);
       }
    }
    return !exhausted;
 }
 
+void producer_plugin_impl::reject_incoming_transaction( const transaction_metadata_ptr& trx, const fc::exception_ptr& e,
+                                                        const next_function<transaction_trace_ptr>& next, bool forget ) {
+   chain::controller& chain = chain_plug->chain();
+   if( _pending_trx_log && forget ) {
+      _pending_trx_log->remove( trx->id );
+   }
+   next(e);
+   _transaction_ack_channel.publish(priority::low, std::pair<fc::exception_ptr, transaction_metadata_ptr>(e, trx));
+   if (_pending_block_mode == pending_block_mode::producing && chain.is_building_block()) {
+      fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} is REJECTING tx: ${txid} : ${why} ",
+            ("block_num", chain.head_block_num() + 1)
+            ("prod", chain.pending_block_producer())
+            ("txid", trx->id)
+            ("why",e->what()));
+   } else {
+      fc_dlog(_trx_trace_log, "[TRX_TRACE] Speculative execution is REJECTING tx: ${txid} : ${why} ",
+              ("txid", trx->id)
+              ("why",e->what()));
+   }
+}
+
+/**
+ * Admission of the incoming transactions queued since the last call. Duplicates and transactions with a
+ * bad TaPoS reference are rejected here on the main thread, where they are cheap to look up. The rest are
+ * split across the producer threads, which run check_incoming_transaction and recover the signing keys
+ * of each batch before posting it back to the main thread in one go. The main thread then only executes
+ * transactions that passed the checks, with keys already recovered.
+ */
+void producer_plugin_impl::admit_incoming_trxs() {
+   _admission_scheduled = false;
+   if( _admission_queue.empty() ) return;
+   auto reload = fc::make_scoped_exit( [this]() { reload_pending_trxs(); } );
+   if( _pending_trx_log ) {
+      _pending_trx_log->flush();
+   }
+
+   std::vector<incoming_transaction> queue;
+   queue.swap( _admission_queue );
+
+   chain::controller& chain = chain_plug->chain();
+   const auto& cfg = chain.get_global_properties().configuration;
+   auto ctx = std::make_shared<admission_context>();
+   ctx->chain_id = chain.get_chain_id();
+   // the block the transactions are pushed into, the next one if none is being built yet
+   ctx->reference_time = chain.is_building_block() ? chain.pending_block_time() : calculate_pending_block_time();
+   ctx->max_transaction_lifetime = cfg.max_transaction_lifetime;
+   ctx->config = cfg;
+   ctx->max_recover_time = fc::microseconds( cfg.max_transaction_cpu_usage );
+   ctx->action_registry = chain.head_block_time().sec_since_epoch() > fioio::HF1_BLOCK_TIME;
+   if( ctx->action_registry ) {
+      ctx->registered_actions = chain.registered_fio_actions();
+   }
+
+   const bool fee_order = _pending_incoming_transactions.policy() == incoming_transaction_queue::order_policy::fee;
+   ctx->abi_max_time = chain_plug->get_abi_serializer_max_time();
+   const auto ro_api = chain_plug->get_read_only_api();
+
+   const auto& persisted_by_id = _persistent_transactions.get<by_id>();
+   const auto& unapplied_trxs = chain.get_unapplied_transactions();
+   size_t num_rejected = 0;
+   auto admitted = std::make_shared<std::vector<incoming_transaction>>();
+   admitted->reserve( queue.size() );
+   for( auto& e : queue ) {
+      const auto& id = e.trx->id;
+      if( chain.is_known_unexpired_transaction( id ) || persisted_by_id.find( id ) != persisted_by_id.end() ||
+          unapplied_trxs.find( e.trx->signed_id ) != unapplied_trxs.end() || _pending_incoming_transactions.contains( id ) ||
+          !_admitting_trx_ids.insert( id ).second ) {
+         ++num_rejected;
+         // the logged copy belongs to the earlier transaction, which removes it once it is irreversible or rejected
+         reject_incoming_transaction( e.trx, std::static_pointer_cast<fc::exception>(std::make_shared<tx_duplicate>(
+               FC_LOG_MESSAGE(error, "duplicate transaction ${id}", ("id", id)) )), e.next, false );
+         continue;
+      }
+      try {
+         chain.validate_tapos( e.trx->packed_trx->get_transaction() );
+      } catch( const fc::exception& er ) {
+         _admitting_trx_ids.erase( id );
+         ++num_rejected;
+         reject_incoming_transaction( e.trx, er.dynamic_copy_exception(), e.next );
+         continue;
+      }
+      if( fee_order ) {
+         for( const auto& act : e.trx->packed_trx->get_transaction().actions ) {
+            // only FIO contract actions with a fee endpoint pay fees, whatever their max_fee says
+            if( act.account.value != fioio::map_to_contract( act.name.value ) ) continue;
+            auto scheduled = ctx->scheduled_fees.find( act.name );
+            if( scheduled == ctx->scheduled_fees.end() ) {
+               optional<uint64_t> fee;
+               if( const char* endpoint = incoming_transaction_queue::fee_endpoint( act.name ) ) {
+                  try {
+                     fee = ro_api.get_scheduled_fee( endpoint );
+                  } LOG_AND_DROP();
+               }
+               scheduled = ctx->scheduled_fees.emplace( act.name, fee ? *fee : 0 ).first;
+            }
+            if( scheduled->second == 0 || ctx->abis.count( act.account ) ) continue;
+            try {
+               ctx->abis.emplace( act.account, chain_plug->get_abi_serializer_cache()->get( chain, act.account, ctx->abi_max_time ) );
+            } catch( const fc::exception& ) {
+               ctx->abis.emplace( act.account, nullptr ); // no such account, the transaction fails on execution
+            }
+         }
+      }
+      admitted->push_back( std::move( e ) );
+   }
+   if( admitted->empty() ) return;
+
+   fc_dlog( _log, "Admitting ${n} incoming transactions, rejected ${r}", ("n", admitted->size())("r", num_rejected) );
+
+   const size_t batch_size = std::min<size_t>( _incoming_trx_batch_size, (admitted->size() + _thread_pool_size - 1) / _thread_pool_size );
+   for( size_t first = 0; first < admitted->size(); first += batch_size ) {
+      auto batch = std::make_shared<std::vector<incoming_transaction>>(
+            std::make_move_iterator( admitted->begin() + first ),
+            std::make_move_iterator( admitted->begin() + std::min( first + batch_size, admitted->size() ) ) );
+      boost::asio::post( _thread_pool->get_executor(), [self = this, ctx, batch]() {
+         for( auto& e : *batch ) {
+            auto set_except = [&e]( const fc::exception_ptr& ep ) { e.except = ep; };
+            try {
+               check_incoming_transaction( *ctx, *e.trx );
+               transaction_metadata::recover_keys_now( e.trx, ctx->chain_id, ctx->max_recover_time );
+               if( !ctx->abis.empty() ) {
+                  e.fee = expected_fee( *ctx, e.trx->packed_trx->get_transaction() );
+               }
+            } CATCH_AND_CALL( set_except );
+         }
+         app().post( priority::low, [self, batch]() {
+            for( auto& e : *batch ) {
+               self->_admitting_trx_ids.erase( e.trx->id );
+               if( e.except ) {
+                  self->reject_incoming_transaction( e.trx, e.except, e.next );
+               } else {
+                  self->process_incoming_transaction_async( e.trx, e.persist_until_expired, e.next, e.fee );
+               }
+            }
+            self->reload_pending_trxs();
+         } );
+      } );
+   }
+}
+
+/**
+ * Resubmit the transactions of the pending transaction log after a restart, pending_trx_reload_batch at a time.
+ * Called again as admission drains so only a bounded number of them is held in memory at once.
+ */
+void producer_plugin_impl::reload_pending_trxs() {
+   if( _reload_offsets.empty() ) return;
+   if( _admitting_trx_ids.size() + _admission_queue.size() >= pending_trx_reload_batch ) return;
+
+   auto trxs = _pending_trx_log->read( _reload_offsets, _reload_pos, pending_trx_reload_batch );
+   _reload_pos += pending_trx_reload_batch;
+   if( _reload_pos >= _reload_offsets.size() ) {
+      ilog( "Resubmitted ${n} logged pending transactions", ("n", _reload_offsets.size()) );
+      _reload_offsets = std::vector<uint64_t>();
+      _reload_pos = 0;
+   }
+   for( auto& logged : trxs ) {
+      try {
+         on_incoming_transaction_async( std::make_shared<transaction_metadata>( logged.trx ), logged.persist_until_expired,
+                                        [](const auto&){} );
+      } LOG_AND_DROP();
+   }
+}
+
 void producer_plugin_impl::schedule_production_loop() {
    chain::controller& chain = chain_plug->chain();
    _timer.cancel();
@@ -11,6 +11,7 @@
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
 
 #include <contracts.hpp>
@@ -123,4 +124,53 @@ BOOST_AUTO_TEST_SUITE(chain_plugin_tests)
 
     } FC_LOG_AND_RETHROW() /// get_block_with_invalid_abi
 
+    BOOST_FIXTURE_TEST_CASE(abi_serializer_cache_evicts_and_follows_setabi, TESTER) try {
+        produce_blocks(2);
+
+        create_accounts({N(first), N(second), N(third)});
+        for (auto account : {N(first), N(second), N(third)})
+            set_abi(account, contracts::asserter_abi().data());
+        produce_block();
+
+        chain_apis::abi_serializer_cache cache(2);
+        auto connection = control->applied_transaction.connect(
+                [&](std::tuple<const transaction_trace_ptr &, const signed_transaction &> t) {
+                    cache.on_applied_transaction(*std::get<0>(t));
+                });
+
+        // the ABI the account holds now
+        auto current = [&](account_name account) {
+            const auto &accnt = control->db().get<account_object, by_name>(account);
+            return cache.get(*control, account, abi_serializer_max_time)->abi_hash ==
+                   fc::sha256::hash(accnt.abi.data(), accnt.abi.size());
+        };
+
+        BOOST_CHECK(current(N(first)));
+        BOOST_CHECK(current(N(second)));
+        BOOST_CHECK(current(N(first)));
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, 1u);
+
+        // second is the least recently used
+        BOOST_CHECK(current(N(third)));
+        BOOST_CHECK_EQUAL(cache.get_stats().entries, 2u);
+        BOOST_CHECK_EQUAL(cache.get_stats().evictions, 1u);
+        BOOST_CHECK(current(N(first)));
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, 2u);
+        BOOST_CHECK(current(N(second)));
+        BOOST_CHECK_EQUAL(cache.get_stats().misses, 4u);
+
+        // a setabi in a block that is aborted, then another one taking its abi_sequence
+        set_abi(N(first), contracts::noop_abi().data());
+        BOOST_CHECK(current(N(first)));
+        control->abort_block();
+        BOOST_CHECK(current(N(first)));
+        set_abi(N(first), contracts::proxy_abi().data());
+        BOOST_CHECK(current(N(first)));
+        control->abort_block();
+        set_abi(N(first), contracts::payloadless_abi().data());
+        BOOST_CHECK(current(N(first)));
+        produce_block();
+        BOOST_CHECK(current(N(first)));
+    } FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/history_plugin/history_store.hpp>
+
+#include <fc/filesystem.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+   const account_name alice = N(alice);
+
+   chain::transaction_id_type block_trx_id( uint32_t block_num ) {
+      return fc::sha256::hash( std::to_string( block_num ) );
+   }
+
+   // one action of alice per block, global sequence block_num, account sequence block_num - 1
+   void append_block( history_store& store, uint32_t block_num, bool commit = true ) {
+      history_store::action_record a;
+      a.global_sequence = block_num;
+      a.block_num = block_num;
+      a.block_time = block_timestamp_type( block_num );
+      a.trx_id = block_trx_id( block_num );
+      a.packed_action_trace = std::vector<char>( block_num % 7 + 1, static_cast<char>( block_num ) );
+      store.append( a, {{alice, int64_t( block_num ) - 1}} );
+      if( commit ) store.commit_block( block_num );
+   }
+
+   void check_action( const history_store& store, uint32_t block_num ) {
+      const auto a = store.get_action( block_num );
+      BOOST_REQUIRE( a );
+      BOOST_CHECK_EQUAL( a->block_num, block_num );
+      BOOST_CHECK( a->trx_id == block_trx_id( block_num ) );
+      BOOST_CHECK( a->packed_action_trace == std::vector<char>( block_num % 7 + 1, static_cast<char>( block_num ) ) );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(history_store_tests)
+
+   BOOST_AUTO_TEST_CASE(recovery_drops_uncommitted_blocks) {
+      fc::temp_directory tempdir;
+      {
+         history_store store( tempdir.path(), 10, 0 );
+         for( uint32_t b = 1; b <= 25; ++b ) {
+            append_block( store, b );
+         }
+         // a crash before block 26 was committed
+         append_block( store, 26, false );
+      }
+
+      history_store store( tempdir.path(), 10, 0 );
+      BOOST_CHECK_EQUAL( store.last_block(), 25u );
+      BOOST_CHECK_EQUAL( store.last_global_sequence(), 25u );
+      BOOST_CHECK( !store.get_action( 26 ) );
+      BOOST_CHECK_EQUAL( store.next_account_sequence( alice ), 25 );
+      check_action( store, 5 );   // sealed
+      check_action( store, 23 );  // open
+      BOOST_CHECK_EQUAL( store.get_transaction_actions( block_trx_id( 26 ) ).size(), 0u );
+
+      append_block( store, 26 );
+      check_action( store, 26 );
+      BOOST_CHECK_EQUAL( store.get_account_actions( alice, 0, 100 ).size(), 26u );
+   }
+
+   BOOST_AUTO_TEST_CASE(paging_across_segments) {
+      fc::temp_directory tempdir;
+      {
+         history_store store( tempdir.path(), 10, 0 );
+         for( uint32_t b = 1; b <= 25; ++b ) {
+            append_block( store, b );
+         }
+      }
+
+      // pages spanning the two sealed segments and the open one, before and after a reopen
+      for( int reopen = 0; reopen < 2; ++reopen ) {
+         history_store store( tempdir.path(), 10, 0 );
+         for( int64_t first = 0; first < 25; first += 4 ) {
+            const auto page = store.get_account_actions( alice, first, first + 7 );
+            BOOST_REQUIRE_EQUAL( page.size(), std::min<size_t>( 8, 25 - first ) );
+            for( size_t i = 0; i < page.size(); ++i ) {
+               BOOST_CHECK_EQUAL( page[i].account_sequence_num, first + int64_t( i ) );
+               BOOST_CHECK_EQUAL( page[i].global_sequence, uint64_t( first + i + 1 ) );
+            }
+         }
+         BOOST_CHECK_EQUAL( store.get_transaction_actions( block_trx_id( 10 ) ).size(), 1u );
+         BOOST_CHECK_EQUAL( store.get_transaction_actions( block_trx_id( 21 ) ).size(), 1u );
+      }
+   }
+
+   BOOST_AUTO_TEST_CASE(retention_keeps_account_sequences) {
+      fc::temp_directory tempdir;
+      history_store store( tempdir.path(), 10, 1 );
+      for( uint32_t b = 1; b <= 35; ++b ) {
+         append_block( store, b );
+      }
+
+      // only 21-30 is still retained among the sealed segments
+      BOOST_CHECK( !store.get_action( 5 ) );
+      BOOST_CHECK( !store.get_action( 20 ) );
+      check_action( store, 21 );
+      check_action( store, 35 );
+      BOOST_REQUIRE( store.first_account_sequence( alice ) );
+      BOOST_CHECK_EQUAL( *store.first_account_sequence( alice ), 20 );
+      BOOST_CHECK_EQUAL( store.next_account_sequence( alice ), 35 );
+
+      const auto page = store.get_account_actions( alice, 0, 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 15u );
+      BOOST_CHECK_EQUAL( page.front().account_sequence_num, 20 );
+      BOOST_CHECK_EQUAL( page.back().account_sequence_num, 34 );
+   }
+
+   BOOST_AUTO_TEST_CASE(fork_undo_does_not_duplicate_stored_actions) {
+      fc::temp_directory tempdir;
+      history_store store( tempdir.path(), 10, 0 );
+      for( uint32_t b = 1; b <= 3; ++b ) {
+         append_block( store, b );
+      }
+
+      auto refs = store.get_account_actions( alice, 0, 10 );
+      BOOST_REQUIRE_EQUAL( refs.size(), 3u );
+
+      // chainbase rows of blocks 2 and 3, brought back by undoing the block that stored them, then block 4
+      BOOST_CHECK( !store.merge_reversible( refs, history_store::account_action{1, 2} ) );
+      BOOST_CHECK( !store.merge_reversible( refs, history_store::account_action{2, 3} ) );
+      BOOST_CHECK( store.merge_reversible( refs, history_store::account_action{3, 4} ) );
+
+      BOOST_REQUIRE_EQUAL( refs.size(), 4u );
+      for( size_t i = 0; i < refs.size(); ++i ) {
+         BOOST_CHECK_EQUAL( refs[i].account_sequence_num, int64_t( i ) );
+         BOOST_CHECK_EQUAL( refs[i].global_sequence, uint64_t( i + 1 ) );
+      }
+   }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/producer_plugin/incoming_transaction_queue.hpp>
+
+#include <limits>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+   incoming_transaction_queue::entry make_entry( action_name act_name, uint32_t nonce, uint64_t fee ) {
+      signed_transaction t;
+      t.expiration = fc::time_point_sec( fc::time_point::now() + fc::hours( 1 ) );
+      t.ref_block_prefix = nonce;
+      action act;
+      act.account = N(fio.address);
+      act.name = act_name;
+      act.authorization = vector<permission_level>{{N(alice), config::active_name}};
+      t.actions.push_back( act );
+
+      incoming_transaction_queue::entry e;
+      e.trx = std::make_shared<transaction_metadata>( t );
+      e.fee = fee;
+      return e;
+   }
+
+   std::vector<uint32_t> pop_nonces( incoming_transaction_queue& queue ) {
+      std::vector<uint32_t> nonces;
+      while( !queue.empty() ) {
+         nonces.push_back( queue.pop().trx->packed_trx->get_transaction().ref_block_prefix );
+      }
+      return nonces;
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(incoming_transaction_queue_tests)
+
+   BOOST_AUTO_TEST_CASE(fee_order_pops_highest_fee_first) {
+      incoming_transaction_queue queue;
+      queue.set_policy( incoming_transaction_queue::order_policy::fee, {} );
+
+      queue.push( make_entry( N(regaddress), 1, 100 ) );
+      queue.push( make_entry( N(regaddress), 2, 300 ) );
+      queue.push( make_entry( N(regaddress), 3, 0 ) );
+      queue.push( make_entry( N(regaddress), 4, 200 ) );
+      queue.push( make_entry( N(regaddress), 5, 300 ) );
+      BOOST_CHECK_EQUAL( queue.size(), 5u );
+
+      // equal fees keep arrival order
+      BOOST_CHECK( pop_nonces( queue ) == std::vector<uint32_t>( {2, 5, 4, 1, 3} ) );
+   }
+
+   BOOST_AUTO_TEST_CASE(fee_order_weighs_billed_cpu) {
+      incoming_transaction_queue queue;
+      queue.set_policy( incoming_transaction_queue::order_policy::fee, {} );
+
+      // regdomain bills a hundred times the CPU of regaddress, so five times the fee still ranks it last
+      queue.record_cpu_usage( make_entry( N(regdomain), 0, 0 ).trx->packed_trx->get_transaction(), 10000 );
+      queue.record_cpu_usage( make_entry( N(regaddress), 0, 0 ).trx->packed_trx->get_transaction(), 100 );
+
+      queue.push( make_entry( N(regdomain), 1, 500 ) );
+      queue.push( make_entry( N(regaddress), 2, 100 ) );
+      BOOST_CHECK( pop_nonces( queue ) == std::vector<uint32_t>( {2, 1} ) );
+   }
+
+   BOOST_AUTO_TEST_CASE(action_fee_is_capped_by_the_schedule) {
+      // max_fee only caps what the schedule charges
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( 0, 1000000, 400 ), 400u );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( 0, 100, 400 ), 100u );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( 50, 400, 400 ), 450u );
+
+      // no fee offered, or none scheduled
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( 50, 0, 400 ), 50u );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( 50, -1, 400 ), 50u );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( 50, 400, 0 ), 50u );
+
+      // sums saturate instead of wrapping around to a low rank
+      const uint64_t max = std::numeric_limits<uint64_t>::max();
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( max - 5, 100, 100 ), max );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::add_action_fee( max, std::numeric_limits<int64_t>::max(), max ), max );
+   }
+
+   BOOST_AUTO_TEST_CASE(fee_endpoints) {
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::fee_endpoint( N(regaddress) ), "register_fio_address" );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::fee_endpoint( N(trnsfiopubky) ), "transfer_tokens_pub_key" );
+      BOOST_CHECK_EQUAL( incoming_transaction_queue::fee_endpoint( N(voteproxy) ), "proxy_vote" );
+      BOOST_CHECK( incoming_transaction_queue::fee_endpoint( N(nonce) ) == nullptr );
+      BOOST_CHECK( incoming_transaction_queue::fee_endpoint( N(transfer) ) == nullptr );
+   }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/net_plugin/protocol.hpp>
+
+#include <fc/io/raw.hpp>
+
+using namespace eosio;
+
+namespace {
+
+   // message framing of net_plugin: 4 byte payload size followed by the packed net_message
+   void append_message( std::vector<char>& stream, const net_message& m ) {
+      const uint32_t payload_size = fc::raw::pack_size( m );
+      const size_t start = stream.size();
+      stream.resize( start + sizeof( payload_size ) + payload_size );
+      fc::datastream<char*> ds( stream.data() + start, stream.size() - start );
+      ds.write( reinterpret_cast<const char*>( &payload_size ), sizeof( payload_size ) );
+      fc::raw::pack( ds, m );
+   }
+
+   /**
+    * Reads messages the way nodes before compression support do: the message is unpacked from the
+    * stream and the next header is read where unpacking stopped, without skipping to the length the
+    * header announced. Fails if those two positions differ.
+    */
+   std::vector<net_message> read_as_old_peer( const std::vector<char>& stream ) {
+      std::vector<net_message> msgs;
+      fc::datastream<const char*> ds( stream.data(), stream.size() );
+      while( ds.remaining() > 0 ) {
+         uint32_t payload_size = 0;
+         ds.read( reinterpret_cast<char*>( &payload_size ), sizeof( payload_size ) );
+         const size_t before = ds.remaining();
+         net_message m;
+         fc::raw::unpack( ds, m );
+         BOOST_REQUIRE_EQUAL( before - ds.remaining(), payload_size );
+         msgs.emplace_back( std::move( m ) );
+      }
+      return msgs;
+   }
+
+   handshake_message make_handshake( const std::string& os ) {
+      handshake_message hello;
+      hello.network_version = 0x04b5 + 1;
+      hello.p2p_address = "127.0.0.1:9876 - 0123456";
+      hello.os = os;
+      hello.agent = "\"interop\"";
+      hello.head_num = 42;
+      hello.last_irreversible_block_num = 40;
+      hello.generation = 1;
+      return hello;
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(net_protocol_tests)
+
+   BOOST_AUTO_TEST_CASE(compressing_handshake_reads_on_old_peer) {
+      const handshake_message plain = make_handshake( "linux" );
+      const handshake_message compressing = make_handshake( std::string( "linux" ) + os_compressed_blocks_suffix );
+
+      time_message tm;
+      tm.org = 1;
+      tm.xmt = 2;
+
+      std::vector<char> stream;
+      append_message( stream, compressing );
+      append_message( stream, tm );
+
+      const auto msgs = read_as_old_peer( stream );
+      BOOST_REQUIRE_EQUAL( msgs.size(), 2u );
+      BOOST_REQUIRE( msgs[0].contains<handshake_message>() );
+      BOOST_REQUIRE( msgs[1].contains<time_message>() );
+
+      const auto& received = msgs[0].get<handshake_message>();
+      BOOST_CHECK_EQUAL( received.os, compressing.os );
+      BOOST_CHECK_EQUAL( received.head_num, plain.head_num );
+      BOOST_CHECK_EQUAL( received.generation, plain.generation );
+      BOOST_CHECK_EQUAL( msgs[1].get<time_message>().xmt, tm.xmt );
+
+      // only the os string grows, the handshake has no fields of its own for compression
+      BOOST_CHECK_EQUAL( fc::raw::pack_size( compressing ),
+                         fc::raw::pack_size( plain ) + sizeof( os_compressed_blocks_suffix ) - 1 );
+   }
+
+   BOOST_AUTO_TEST_CASE(compression_only_toward_compressing_peers) {
+      // handshakes of old nodes, and of new nodes with p2p-compression off
+      BOOST_CHECK( !handshake_accepts_compressed_blocks( make_handshake( "linux" ) ) );
+      BOOST_CHECK( !handshake_accepts_compressed_blocks( make_handshake( "osx" ) ) );
+      BOOST_CHECK( !handshake_accepts_compressed_blocks( make_handshake( "" ) ) );
+      BOOST_CHECK( !handshake_accepts_compressed_blocks( make_handshake( os_compressed_blocks_suffix ) ) );
+      BOOST_CHECK( !handshake_accepts_compressed_blocks( make_handshake( std::string( "linux" ) + os_compressed_blocks_suffix + " " ) ) );
+
+      BOOST_CHECK( handshake_accepts_compressed_blocks( make_handshake( std::string( "linux" ) + os_compressed_blocks_suffix ) ) );
+      BOOST_CHECK( handshake_accepts_compressed_blocks( make_handshake( std::string( "other" ) + os_compressed_blocks_suffix ) ) );
+   }
+
+BOOST_AUTO_TEST_SUITE_END()
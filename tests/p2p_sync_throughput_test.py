@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+
+import shutil
+import time
+from Cluster import Cluster
+from Node import BlockType
+from TestHelper import AppArgs
+from TestHelper import TestHelper
+from WalletMgr import WalletMgr
+from testUtils import Utils
+
+###############################################################
+# p2p_sync_throughput_test
+#  Benchmark of net_plugin block sync against the number of peers it fetches from.
+#  Test configures a producing node and <--relay-nodes> non-producing nodes in a mesh, plus one
+#  unstarted catchup node connected to all of them.
+#  1) the producer runs until its LIB is <--blocks> blocks past the start
+#  2) the catchup node is started from genesis with --sync-fetch-peers set to each of
+#     <--peer-counts> and the time to reach the producer's LIB is measured
+#  3) the catchup node is stopped and its blocks and state removed before the next run
+#  The blocks per second of each run are reported. With <--min-speedup> the run with the most
+#  peers must be that much faster than the run with one peer.
+###############################################################
+
+Print = Utils.Print
+errorExit = Utils.errorExit
+
+appArgs = AppArgs()
+extraArgs = appArgs.add(flag="--relay-nodes", type=int, help="How many non-producing nodes to sync from", default=4)
+extraArgs = appArgs.add(flag="--blocks", type=int, help="How many blocks the catchup node has to sync", default=1200)
+extraArgs = appArgs.add(flag="--peer-counts", type=str, help="Comma separated values of --sync-fetch-peers to run",
+                        default="1,2,4")
+extraArgs = appArgs.add(flag="--sync-fetch-span", type=int, help="--sync-fetch-span of the catchup node", default=50)
+extraArgs = appArgs.add(flag="--min-speedup", type=float,
+                        help="Required ratio of the throughput with the most peers to the throughput with one peer, 0 to only report",
+                        default=0)
+args = TestHelper.parse_args(
+    {"--dump-error-details", "--keep-logs", "-v", "--leave-running", "--clean-run", "--wallet-port"},
+    applicationSpecificArgs=appArgs)
+Utils.Debug = args.v
+pnodes = 1
+relayNodes = args.relay_nodes if args.relay_nodes > 0 else 1
+totalNodes = pnodes + relayNodes + 1
+blocksToSync = args.blocks if args.blocks > 0 else 1200
+peerCounts = sorted(set(int(c) for c in args.peer_counts.split(",")))
+syncFetchSpan = args.sync_fetch_span
+minSpeedup = args.min_speedup
+cluster = Cluster(walletd=True)
+dumpErrorDetails = args.dump_error_details
+keepLogs = args.keep_logs
+dontKill = args.leave_running
+killAll = args.clean_run
+walletPort = args.wallet_port
+
+walletMgr = WalletMgr(True, port=walletPort)
+testSuccessful = False
+killEosInstances = not dontKill
+killWallet = not dontKill
+
+try:
+    TestHelper.printSystemInfo("BEGIN")
+    cluster.setWalletMgr(walletMgr)
+
+    cluster.killall(allInstances=killAll)
+    cluster.cleanup()
+    catchupNodeNum = totalNodes - 1
+    specificExtraNodeosArgs = {catchupNodeNum: "--sync-fetch-span %d" % (syncFetchSpan)}
+    Print("Stand up cluster")
+    if cluster.launch(prodCount=1, onlyBios=False, pnodes=pnodes, totalNodes=totalNodes, totalProducers=pnodes,
+                      useBiosBootFile=False, specificExtraNodeosArgs=specificExtraNodeosArgs,
+                      unstartedNodes=1, loadSystemContract=False) is False:
+        Utils.errorExit("Failed to stand up eos cluster.")
+
+
+    def lib(node):
+        return node.getBlockNum(BlockType.lib)
+
+
+    def waitForBlock(node, blockNum, blockType=BlockType.head, timeout=None, reportInterval=20):
+        if not node.waitForBlock(blockNum, timeout=timeout, blockType=blockType, reportInterval=reportInterval):
+            info = node.getInfo()
+            headBlockNum = info["head_block_num"]
+            libBlockNum = info["last_irreversible_block_num"]
+            Utils.errorExit("Failed to get to %s block number %d. Last had head block number %d and lib %d" % (
+            blockType, blockNum, headBlockNum, libBlockNum))
+
+
+    def waitForNodeStarted(node):
+        sleepTime = 0
+        while sleepTime < 10 and node.getInfo(silentErrors=True) is None:
+            time.sleep(1)
+            sleepTime += 1
+
+
+    node0 = cluster.getNode(0)
+
+    Print("Wait for producer LIB to reach %d" % (blocksToSync))
+    waitForBlock(node0, blocksToSync, blockType=BlockType.lib, timeout=blocksToSync, reportInterval=100)
+    targetLibNum = lib(node0)
+    for nodeNum in range(pnodes, pnodes + relayNodes):
+        waitForBlock(cluster.getNode(nodeNum), targetLibNum, blockType=BlockType.lib, timeout=60)
+
+    results = []
+    catchupNode = cluster.unstartedNodes[0]
+    baseCmd = catchupNode.cmd
+    catchupNodeNum = None
+    for peers in peerCounts:
+        if catchupNodeNum is None:
+            Print("Start catchup node fetching from %d peers" % (peers))
+            catchupNode.cmd = baseCmd + " --sync-fetch-peers %d" % (peers)
+            cluster.launchUnstarted(cachePopen=True)
+            catchupNodeNum = cluster.getNodes().index(catchupNode)
+        else:
+            Print("Restart catchup node with empty blocks and state, fetching from %d peers" % (peers))
+            for subDir in ["blocks", "state"]:
+                shutil.rmtree(Utils.getNodeDataDir(catchupNodeNum, subDir), ignore_errors=True)
+            catchupNode.cmd = baseCmd
+            if not catchupNode.relaunch(catchupNodeNum, chainArg="--sync-fetch-peers %d" % (peers), newChain=True,
+                                        cachePopen=True):
+                Utils.errorExit("Failed to relaunch catchup node")
+        start = time.perf_counter()
+        waitForNodeStarted(catchupNode)
+        startLibNum = lib(catchupNode)
+
+        waitForBlock(catchupNode, targetLibNum, blockType=BlockType.lib, timeout=blocksToSync, reportInterval=100)
+        elapsed = time.perf_counter() - start
+        synced = targetLibNum - (startLibNum if startLibNum is not None else 0)
+        rate = synced / elapsed
+        Print("Synced %d blocks from %d peers in %.2f s, %.1f blocks/s" % (synced, peers, elapsed, rate))
+        results.append((peers, rate))
+
+        catchupNode.interruptAndVerifyExitStatus(60)
+        catchupNode.popenProc = None
+
+    Print("sync-fetch-peers  blocks/s  speedup")
+    baseRate = results[0][1]
+    for peers, rate in results:
+        Print("%16d  %8.1f  %7.2f" % (peers, rate, rate / baseRate))
+
+    if minSpeedup > 0 and len(results) > 1:
+        speedup = results[-1][1] / baseRate
+        assert speedup >= minSpeedup, "Expected sync from %d peers to be at least %.2f times faster than from %d, got %.2f" % (
+            results[-1][0], minSpeedup, results[0][0], speedup)
+
+    testSuccessful = True
+
+finally:
+    TestHelper.shutdown(cluster, walletMgr, testSuccessful=testSuccessful, killEosInstances=killEosInstances,
+                        killWallet=killWallet, keepLogs=keepLogs, cleanRun=killAll, dumpErrorDetails=dumpErrorDetails)
+
+exit(0)
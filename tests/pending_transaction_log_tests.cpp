@@ -0,0 +1,202 @@
+/**
+ *  @file
+ *  @copyright defined in fio/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/producer_plugin/pending_transaction_log.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+   packed_transaction make_trx( const fc::time_point& expiration, uint32_t nonce, size_t data_size = 0 ) {
+      signed_transaction t;
+      t.expiration = fc::time_point_sec( expiration );
+      t.ref_block_prefix = nonce;
+      action act;
+      act.account = N(fio.address);
+      act.name = N(regaddress);
+      act.data.resize( data_size );
+      t.actions.push_back( act );
+      return packed_transaction( t );
+   }
+
+   std::vector<pending_transaction_log::logged_transaction> read_all( const pending_transaction_log& log ) {
+      const auto offsets = log.live_offsets();
+      return log.read( offsets, 0, offsets.size() );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(pending_transaction_log_tests)
+
+   BOOST_AUTO_TEST_CASE(round_trip) {
+      fc::temp_directory tempdir;
+      const fc::path file = tempdir.path() / "pending_transactions.log";
+      const auto expiration = fc::time_point::now() + fc::hours( 1 );
+      const auto a = make_trx( expiration, 1 );
+      const auto b = make_trx( expiration, 2 );
+      const auto c = make_trx( expiration, 3 );
+      {
+         pending_transaction_log log( file );
+         log.add( a.id(), a, false );
+         log.add( b.id(), b, true );
+         log.add( c.id(), c, false );
+         log.add( a.id(), a, true ); // already logged, keeps the first record
+         log.remove( c.id() );
+         log.flush();
+         BOOST_CHECK_EQUAL( log.size(), 2u );
+      }
+
+      pending_transaction_log log( file );
+      BOOST_REQUIRE_EQUAL( log.size(), 2u );
+      BOOST_CHECK( log.contains( a.id() ) );
+      BOOST_CHECK( log.contains( b.id() ) );
+      BOOST_CHECK( !log.contains( c.id() ) );
+
+      const auto logged = read_all( log );
+      BOOST_REQUIRE_EQUAL( logged.size(), 2u );
+      BOOST_CHECK( logged[0].trx->id() == a.id() );
+      BOOST_CHECK( !logged[0].persist_until_expired );
+      BOOST_CHECK( logged[1].trx->id() == b.id() );
+      BOOST_CHECK( logged[1].persist_until_expired );
+
+      const auto second = log.read( log.live_offsets(), 1, 1 );
+      BOOST_REQUIRE_EQUAL( second.size(), 1u );
+      BOOST_CHECK( second[0].trx->id() == b.id() );
+   }
+
+   BOOST_AUTO_TEST_CASE(torn_and_corrupt_records_are_truncated) {
+      fc::temp_directory tempdir;
+      const fc::path file = tempdir.path() / "pending_transactions.log";
+      const auto expiration = fc::time_point::now() + fc::hours( 1 );
+      const auto a = make_trx( expiration, 1 );
+      const auto b = make_trx( expiration, 2 );
+      uint64_t a_end = 0;
+      {
+         pending_transaction_log log( file );
+         log.add( a.id(), a, false );
+         log.flush();
+         a_end = fc::file_size( file );
+         log.add( b.id(), b, false );
+         log.flush();
+      }
+
+      // a crash in the middle of writing b
+      boost::filesystem::resize_file( file, fc::file_size( file ) - 3 );
+      {
+         pending_transaction_log log( file );
+         BOOST_CHECK_EQUAL( log.size(), 1u );
+         BOOST_CHECK( log.contains( a.id() ) );
+         BOOST_CHECK_EQUAL( fc::file_size( file ), a_end );
+
+         // appends continue after the last good record
+         log.add( b.id(), b, true );
+         log.flush();
+      }
+      {
+         pending_transaction_log log( file );
+         BOOST_REQUIRE_EQUAL( log.size(), 2u );
+         const auto logged = read_all( log );
+         BOOST_REQUIRE_EQUAL( logged.size(), 2u );
+         BOOST_CHECK( logged[1].trx->id() == b.id() );
+         BOOST_CHECK( logged[1].persist_until_expired );
+      }
+
+      // a flipped byte in the payload of a fails its checksum, a and everything after it is dropped
+      {
+         std::fstream f( file.generic_string(), std::ios::binary | std::ios::in | std::ios::out );
+         f.seekg( 12 );
+         char byte = 0;
+         f.read( &byte, 1 );
+         byte ^= 0x5a;
+         f.seekp( 12 );
+         f.write( &byte, 1 );
+      }
+      pending_transaction_log log( file );
+      BOOST_CHECK_EQUAL( log.size(), 0u );
+      BOOST_CHECK_EQUAL( fc::file_size( file ), 0u );
+   }
+
+   BOOST_AUTO_TEST_CASE(expired_transactions_are_dropped) {
+      fc::temp_directory tempdir;
+      const fc::path file = tempdir.path() / "pending_transactions.log";
+      const auto now = fc::time_point::now();
+      const auto soon = make_trx( now + fc::seconds( 10 ), 1 );
+      const auto later = make_trx( now + fc::hours( 1 ), 2 );
+
+      pending_transaction_log log( file );
+      log.add( soon.id(), soon, false );
+      log.add( later.id(), later, false );
+
+      log.drop_expired( now );
+      BOOST_CHECK_EQUAL( log.size(), 2u );
+
+      log.compact( now + fc::minutes( 1 ) );
+      BOOST_REQUIRE_EQUAL( log.size(), 1u );
+      BOOST_CHECK( !log.contains( soon.id() ) );
+      BOOST_CHECK( log.contains( later.id() ) );
+
+      const auto logged = read_all( log );
+      BOOST_REQUIRE_EQUAL( logged.size(), 1u );
+      BOOST_CHECK( logged[0].trx->id() == later.id() );
+   }
+
+   BOOST_AUTO_TEST_CASE(rewrite_keeps_records_logged_while_copying) {
+      fc::temp_directory tempdir;
+      const fc::path file = tempdir.path() / "pending_transactions.log";
+      const auto now = fc::time_point::now();
+      const auto expiration = now + fc::hours( 1 );
+
+      std::vector<packed_transaction> trxs;
+      for( uint32_t i = 0; i < 200; ++i ) {
+         trxs.push_back( make_trx( expiration, i, 8 * 1024 ) );
+      }
+      const auto added = make_trx( expiration, 1000 );
+      {
+         pending_transaction_log log( file );
+         for( const auto& t : trxs ) {
+            log.add( t.id(), t, false );
+         }
+         for( size_t i = 2; i < trxs.size(); ++i ) {
+            log.remove( trxs[i].id() );
+         }
+         const uint64_t before = fc::file_size( file );
+
+         log.compact( now );
+         // logged after the live records were snapshot, these land after the copied ones
+         log.remove( trxs[0].id() );
+         log.add( added.id(), added, true );
+
+         for( int i = 0; i < 1000 && fc::file_size( file ) >= before; ++i ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            log.compact( now );
+         }
+         BOOST_REQUIRE_LT( fc::file_size( file ), before / 10 );
+         BOOST_CHECK( !fc::exists( file.string() + ".tmp" ) );
+
+         const auto logged = read_all( log );
+         BOOST_REQUIRE_EQUAL( logged.size(), 2u );
+         BOOST_CHECK( logged[0].trx->id() == trxs[1].id() );
+         BOOST_CHECK( logged[1].trx->id() == added.id() );
+         BOOST_CHECK( logged[1].persist_until_expired );
+      }
+
+      pending_transaction_log log( file );
+      BOOST_REQUIRE_EQUAL( log.size(), 2u );
+      BOOST_CHECK( !log.contains( trxs[0].id() ) );
+      BOOST_CHECK( log.contains( trxs[1].id() ) );
+      BOOST_CHECK( log.contains( added.id() ) );
+   }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include <eosio/chain/abi_serializer.hpp>
 #include <eosio/chain/permission_object.hpp>
 #include <eosio/chain/authorization_manager.hpp>
+#include <eosio/chain/authority_checker.hpp>
 
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/resource_limits_private.hpp>
@@ -564,5 +565,107 @@ BOOST_AUTO_TEST_SUITE(auth_tests)
         } FC_LOG_AND_RETHROW()
     }
 
+    // Caching authorities and authorization results within a block must not change the outcome of any check, including
+    // whether keys are irrelevant: not when permissions change in the block, nor when such changes are undone.
+    BOOST_AUTO_TEST_CASE(authorization_cache_equivalence) {
+        try {
+            TESTER chain;
+            chain.create_accounts({"alice", "bob", "carol"});
+            chain.produce_block();
+
+            // carol's active permission needs two of a key, alice's owner permission and bob's active permission
+            auto carol_active = [&](const char *role) {
+                return authority(2, {{chain.get_public_key("carol", role), 1}},
+                                 {{{N(alice), config::owner_name}, 1},
+                                  {{N(bob),   config::active_name}, 1}});
+            };
+            chain.set_authority("carol", "active", carol_active("active"));
+            // and alice's active permission is satisfied by carol's
+            chain.set_authority("alice", "active", authority(1, {{chain.get_public_key("alice", "active"), 1}},
+                                                             {{{N(carol), config::active_name}, 1}}));
+
+            const vector<public_key_type> all_keys = {
+                    chain.get_public_key("alice", "owner"), chain.get_public_key("alice", "active"),
+                    chain.get_public_key("bob", "owner"), chain.get_public_key("bob", "active"),
+                    chain.get_public_key("carol", "active"), chain.get_public_key("dave", "active")
+            };
+            const vector<vector<permission_level>> declared = {
+                    {{N(alice), config::active_name}},
+                    {{N(alice), config::owner_name}},
+                    {{N(bob),   config::active_name}},
+                    {{N(carol), config::active_name}},
+                    {{N(alice), config::active_name}, {N(bob), config::active_name}},
+                    {{N(carol), config::active_name}, {N(carol), config::owner_name}}
+            };
+
+            enum outcome {
+                satisfied, unsatisfied, irrelevant_keys
+            };
+
+            const auto &mgr = chain.control->get_authorization_manager();
+
+            // checks authorization as authorization_manager did before it cached anything
+            auto check_uncached = [&](const vector<permission_level> &levels, const flat_set<public_key_type> &keys) {
+                auto checker = make_auth_checker([&](const permission_level &p) { return mgr.get_permission(p).auth; },
+                                                 chain.control->get_global_properties().configuration.max_authority_depth,
+                                                 keys, {}, fc::microseconds(0), authorization_manager::_noop_checktime);
+                for (const auto &level : flat_set<permission_level>(levels.begin(), levels.end())) {
+                    if (!checker.satisfied(level))
+                        return unsatisfied;
+                }
+                return checker.all_keys_used() ? satisfied : irrelevant_keys;
+            };
+
+            auto check = [&](const vector<permission_level> &levels, const flat_set<public_key_type> &keys) {
+                try {
+                    mgr.check_authorization({action(levels, N(alice), N(doit), bytes())}, keys);
+                    return satisfied;
+                } catch (const unsatisfied_authorization &) {
+                    return unsatisfied;
+                } catch (const tx_irrelevant_sig &) {
+                    return irrelevant_keys;
+                }
+            };
+
+            auto check_all = [&]() {
+                // the second round is answered from the cache
+                for (int round = 0; round < 2; ++round) {
+                    for (const auto &levels : declared) {
+                        for (uint32_t subset = 0; subset < (1u << all_keys.size()); ++subset) {
+                            flat_set<public_key_type> keys;
+                            for (size_t i = 0; i < all_keys.size(); ++i) {
+                                if (subset & (1u << i))
+                                    keys.insert(all_keys[i]);
+                            }
+                            BOOST_REQUIRE_EQUAL(check_uncached(levels, keys), check(levels, keys));
+                        }
+                    }
+                }
+            };
+
+            check_all();
+
+            // carol's key changes in the same block
+            chain.set_authority("carol", "active", carol_active("owner"));
+            check_all();
+
+            // bob's key changes and the change is undone, with checks in between, as when a transaction that changed
+            // it fails later on
+            eosio::chain::database &db = const_cast<eosio::chain::database &>(chain.control->db());
+            {
+                auto session = db.start_undo_session(true);
+                chain.control->get_mutable_authorization_manager().modify_permission(
+                        mgr.get_permission({N(bob), config::active_name}), authority(chain.get_public_key("bob", "owner")));
+                check_all();
+                session.undo();
+            }
+            check_all();
+
+            chain.produce_block();
+            check_all();
+
+        } FC_LOG_AND_RETHROW()
+    }
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
 #include <eosio/chain/authority.hpp>
 #include <eosio/chain/authority_checker.hpp>
 #include <eosio/chain/chain_config.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/testing/tester.hpp>
@@ -930,6 +931,68 @@ namespace eosio {
             } FC_LOG_AND_RETHROW()
         }
 
+        BOOST_AUTO_TEST_CASE(signature_recovery_cache_test) {
+            try {
+                auto key = [](const char *seed) {
+                    return private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string(seed)));
+                };
+                const auto digest1 = digest_type::hash(std::string("digest1"));
+                const auto digest2 = digest_type::hash(std::string("digest2"));
+                const auto sig_a = key("a").sign(digest1);
+                const auto sig_b = key("b").sign(digest1);
+                const auto sig_c = key("c").sign(digest1);
+
+                signature_recovery_cache cache(2);
+                cache.add(digest1, sig_a, key("a").get_public_key(), fc::microseconds(1));
+                cache.add(digest1, sig_b, key("b").get_public_key(), fc::microseconds(2));
+                BOOST_REQUIRE(cache.get(digest1, sig_a));
+                BOOST_CHECK_EQUAL(key("a").get_public_key(), cache.get(digest1, sig_a)->first);
+                BOOST_CHECK_EQUAL(1, cache.get(digest1, sig_a)->second.count());
+
+                // a signature is only found with the digest it was recovered from
+                BOOST_CHECK(!cache.get(digest2, sig_a));
+
+                // sig_a was used last, so adding sig_c evicts sig_b
+                cache.add(digest1, sig_c, key("c").get_public_key(), fc::microseconds(3));
+                BOOST_CHECK_EQUAL(2u, cache.size());
+                BOOST_CHECK(cache.get(digest1, sig_a));
+                BOOST_CHECK(!cache.get(digest1, sig_b));
+                BOOST_CHECK(cache.get(digest1, sig_c));
+
+                // adding an entry again doesn't duplicate it
+                cache.add(digest1, sig_a, key("a").get_public_key(), fc::microseconds(1));
+                BOOST_CHECK_EQUAL(2u, cache.size());
+
+                cache.set_capacity(1);
+                BOOST_CHECK_EQUAL(1u, cache.size());
+                BOOST_CHECK(cache.get(digest1, sig_a));
+
+                cache.set_capacity(0);
+                cache.add(digest1, sig_b, key("b").get_public_key(), fc::microseconds(2));
+                BOOST_CHECK_EQUAL(0u, cache.size());
+
+                // transactions that only differ in their context free data have the same id but different digests,
+                // a signature of one must not recover to the signer's key for the other
+                signed_transaction trx;
+                trx.expiration = fc::time_point_sec(fc::time_point::now()) + 60;
+                trx.context_free_data.emplace_back(bytes{'a'});
+                const chain_id_type chain_id = fc::sha256::hash(std::string("chain"));
+                trx.sign(key("a"), chain_id);
+                signed_transaction other = trx;
+                other.context_free_data[0] = bytes{'b'};
+                BOOST_REQUIRE_EQUAL(trx.id(), other.id());
+
+                flat_set<public_key_type> keys;
+                trx.get_signature_keys(chain_id, fc::time_point::maximum(), keys);
+                BOOST_CHECK_EQUAL(key("a").get_public_key(), *keys.begin());
+                other.get_signature_keys(chain_id, fc::time_point::maximum(), keys);
+                BOOST_CHECK(key("a").get_public_key() != *keys.begin());
+                trx.get_signature_keys(chain_id, fc::time_point::maximum(), keys);
+                BOOST_CHECK_EQUAL(key("a").get_public_key(), *keys.begin());
+
+            } FC_LOG_AND_RETHROW()
+        }
+
         BOOST_AUTO_TEST_CASE(reflector_init_test) {
             try {
 
@@ -2,6 +2,7 @@
  *  @file
  *  @copyright defined in fio/LICENSE.txt
  */
+#include <algorithm>
 #include <array>
 #include <utility>
 
@@ -10,13 +11,18 @@
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
+#include <eosio/chain/webassembly/wavm_object_cache.hpp>
 #include <eosio/testing/tester.hpp>
 
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
 #include <Runtime/Runtime.h>
 
 #include <boost/test/unit_test.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <fc/filesystem.hpp>
 #include <fc/io/fstream.hpp>
 #include <fc/io/json.hpp>
 #include <fc/variant_object.hpp>
@@ -1900,4 +1906,261 @@ BOOST_AUTO_TEST_SUITE(wasm_tests)
     } FC_LOG_AND_RETHROW()
 #endif
 
+    // A contract that spins for a while in apply and calls one of its functions through its table. Each id yields
+    // different code, which has to be compiled anew.
+    static std::string busy_wast(uint32_t id) {
+        const uint32_t num_funcs = 16;
+        std::string wast = "(module\n"
+                           " (type $t (func (param i32) (result i32)))\n"
+                           " (table " + std::to_string(num_funcs) + " anyfunc)\n"
+                           " (elem (i32.const 0)";
+        for (uint32_t i = 0; i < num_funcs; ++i)
+            wast += " $f" + std::to_string(i);
+        wast += ")\n"
+                " (memory 1)\n"
+                " (export \"apply\" (func $apply))\n"
+                " (func $apply (param i64 i64 i64)\n"
+                "  (local $i i32)\n"
+                "  (loop $busy\n"
+                "   (set_local $i (i32.add (get_local $i) (i32.const 1)))\n"
+                "   (br_if $busy (i32.lt_u (get_local $i) (i32.const 100000))))\n"
+                "  (i32.store (i32.const 0) (call_indirect (type $t) (i32.const " + std::to_string(id) + ")"
+                " (i32.const " + std::to_string(id % num_funcs) + "))))\n";
+        for (uint32_t i = 0; i < num_funcs; ++i)
+            wast += " (func $f" + std::to_string(i) + " (type $t) (param i32) (result i32)"
+                    " (i32.add (get_local 0) (i32.const " + std::to_string(id * num_funcs + i) + ")))\n";
+        return wast + ")";
+    }
+
+    // setcode compiles the new code on another thread while the main thread goes on running contracts. Meant to be
+    // run under ThreadSanitizer as well, which reports the runtime state the two threads would share.
+    BOOST_FIXTURE_TEST_CASE(setcode_while_running, TESTER) try {
+        produce_blocks(2);
+
+        create_accounts({N(running), N(compiled)});
+        produce_block();
+
+        set_code(N(running), busy_wast(0).c_str());
+        produce_block();
+
+        uint64_t nonce = 0;
+        auto run = [&](account_name account) {
+            signed_transaction trx;
+            action act;
+            act.account = account;
+            act.name = name(++nonce);
+            act.authorization = vector<permission_level>{{account, config::active_name}};
+            trx.actions.push_back(act);
+            set_transaction_headers(trx);
+            trx.sign(get_private_key(account, "active"), control->get_chain_id());
+            auto result = push_transaction(trx);
+            BOOST_CHECK_EQUAL(result->receipt->status, transaction_receipt::executed);
+        };
+
+        for (uint32_t id = 1; id <= 20; ++id) {
+            set_code(N(compiled), busy_wast(id).c_str());
+            for (uint32_t i = 0; i < 5; ++i)
+                run(N(running));
+            run(N(compiled));
+            if (id % 5 == 0)
+                produce_block();
+        }
+        produce_block();
+        run(N(running));
+        run(N(compiled));
+    } FC_LOG_AND_RETHROW()
+
+    // Runs a contract on wavm with its object code kept in cache_dir, on a chain of its own each time.
+    struct wavm_cache_tester {
+        fc::temp_directory tempdir;
+        std::unique_ptr<tester> chain;
+
+        explicit wavm_cache_tester(const fc::path &cache_dir) {
+            controller::config cfg;
+            cfg.blocks_dir = tempdir.path() / config::default_blocks_dir_name;
+            cfg.state_dir = tempdir.path() / config::default_state_dir_name;
+            cfg.state_size = 1024 * 1024 * 8;
+            cfg.state_guard_size = 0;
+            cfg.reversible_cache_size = 1024 * 1024 * 8;
+            cfg.reversible_guard_size = 0;
+            cfg.genesis.initial_timestamp = fc::time_point::from_iso_string("2020-01-01T00:00:00.000");
+            cfg.genesis.initial_key = tester::get_public_key(config::system_account_name, "active");
+            cfg.wasm_runtime = chain::wasm_interface::vm_type::wavm;
+            cfg.wasm_cache_dir = cache_dir;
+            chain = std::make_unique<tester>(cfg);
+        }
+
+        void run(account_name account, const std::string &wast) {
+            chain->create_accounts({account});
+            chain->set_code(account, wast.c_str());
+            chain->produce_block();
+
+            signed_transaction trx;
+            action act;
+            act.account = account;
+            act.name = N(run);
+            act.authorization = vector<permission_level>{{account, config::active_name}};
+            trx.actions.push_back(act);
+            chain->set_transaction_headers(trx);
+            trx.sign(tester::get_private_key(account, "active"), chain->control->get_chain_id());
+            auto result = chain->push_transaction(trx);
+            BOOST_CHECK_EQUAL(result->receipt->status, transaction_receipt::executed);
+            chain->produce_block();
+        }
+    };
+
+    static digest_type wast_code_hash(const std::string &wast) {
+        const std::vector<uint8_t> wasm = wast_to_wasm(wast);
+        return fc::sha256::hash((const char *) wasm.data(), wasm.size());
+    }
+
+    // The object code of a contract is stored when it's compiled and loaded on a later run. An entry filed under
+    // another code hash is dropped when the cache is opened, and object code of another contract under a contract's
+    // key is compiled over instead of being linked against it.
+    BOOST_AUTO_TEST_CASE(wavm_object_cache) try {
+        using webassembly::wavm::object_cache;
+        fc::temp_directory cache_dir;
+        const fc::path entries_dir = cache_dir.path() / ("v" + std::to_string(object_cache::format_version));
+        auto entry_file = [&](const digest_type &code_hash) {
+            return entries_dir / (code_hash.str() + "-0-0.obj");
+        };
+
+        const std::string busy = busy_wast(1);
+        const std::string empty = "(module (export \"apply\" (func $apply)) (func $apply (param i64 i64 i64)))";
+        const digest_type busy_hash = wast_code_hash(busy);
+        const digest_type empty_hash = wast_code_hash(empty);
+
+        { wavm_cache_tester(cache_dir.path()).run(N(busy), busy); }
+        BOOST_REQUIRE(fc::exists(entry_file(busy_hash)));
+        const auto busy_object = object_cache(cache_dir.path()).get(busy_hash, 0, 0);
+        BOOST_REQUIRE(busy_object);
+        BOOST_REQUIRE(!busy_object->empty());
+
+        // loaded from the cache by a restarted node
+        { wavm_cache_tester(cache_dir.path()).run(N(busy), busy); }
+        {
+            const auto reloaded = object_cache(cache_dir.path()).get(busy_hash, 0, 0);
+            BOOST_REQUIRE(reloaded);
+            BOOST_CHECK(*reloaded == *busy_object);
+        }
+
+        // an entry whose header names another code hash than its file
+        fc::copy(entry_file(busy_hash), entry_file(empty_hash));
+        {
+            object_cache cache(cache_dir.path());
+            BOOST_CHECK(!fc::exists(entry_file(empty_hash)));
+            BOOST_CHECK(!cache.get(empty_hash, 0, 0));
+            BOOST_CHECK(cache.get(busy_hash, 0, 0));
+        }
+
+        // object code that defines functions the contract doesn't have
+        object_cache(cache_dir.path()).put(empty_hash, 0, 0, *busy_object);
+        { wavm_cache_tester(cache_dir.path()).run(N(empty), empty); }
+        const auto empty_object = object_cache(cache_dir.path()).get(empty_hash, 0, 0);
+        BOOST_REQUIRE(empty_object);
+        BOOST_CHECK(*empty_object != *busy_object);
+
+        { wavm_cache_tester(cache_dir.path()).run(N(empty), empty); }
+        const auto empty_reloaded = object_cache(cache_dir.path()).get(empty_hash, 0, 0);
+        BOOST_REQUIRE(empty_reloaded);
+        BOOST_CHECK(*empty_reloaded == *empty_object);
+    } FC_LOG_AND_RETHROW()
+
+    static std::vector<uint8_t> initial_memory_image(const std::vector<uint8_t> &wasm, IR::MemoryType &type) {
+        IR::Module module;
+        Serialization::MemoryInputStream stream(wasm.data(), wasm.size());
+        WASM::serialize(stream, module);
+        BOOST_REQUIRE(module.memories.defs.size());
+        type = module.memories.defs[0].type;
+
+        std::vector<uint8_t> image;
+        for (const IR::DataSegment &segment : module.dataSegments) {
+            const uint32_t offset = segment.baseOffset.i32;
+            if (offset + segment.data.size() > image.size())
+                image.resize(offset + segment.data.size());
+            memcpy(image.data() + offset, segment.data.data(), segment.data.size());
+        }
+        return image;
+    }
+
+    // Times resetting a contract's memory between actions that each write to a few pages, by copying its initial
+    // memory as wavm did before, and by restoring a snapshot of it. The FIO contracts aren't built in this tree, so
+    // eosio.token stands in for fio.token, and eosio.system, which like fio.address carries a lot of data, for it.
+    BOOST_AUTO_TEST_CASE(memory_snapshot_reset) try {
+        const uint32_t num_actions = 1000;
+        const uint32_t num_written_pages = 4;
+        const uint64_t page_size = 1 << IR::numBytesPerPageLog2;
+
+        Runtime::MemoryInstance *memory = Runtime::createMemory(IR::MemoryType(false, {1, 1024}));
+        BOOST_REQUIRE(memory);
+        uint8_t *base = Runtime::getMemoryBaseAddress(memory);
+
+        const std::pair<const char *, std::vector<uint8_t>> apply_paths[] = {
+                {"fio.token",   contracts::eosio_token_wasm()},
+                {"fio.address", contracts::eosio_system_wasm()}
+        };
+        for (const auto &[name, wasm] : apply_paths) {
+            IR::MemoryType type;
+            const std::vector<uint8_t> image = initial_memory_image(wasm, type);
+            const uint64_t memory_size = type.size.min * page_size;
+
+            Runtime::MemorySnapshot *snapshot = Runtime::createMemorySnapshot(type, image);
+            if (!snapshot) {
+                BOOST_TEST_MESSAGE("memory snapshots aren't supported on this platform");
+                return;
+            }
+
+            // an action writes to its stack at the top of the initial memory, and to a few pages of data and heap
+            auto run_action = [&]() {
+                for (uint32_t i = 0; i < num_written_pages; ++i)
+                    base[(memory_size - 1) - i * (memory_size / num_written_pages)] ^= 0xff;
+            };
+
+            auto start = fc::time_point::now();
+            for (uint32_t i = 0; i < num_actions; ++i) {
+                Runtime::resetMemory(memory, type);
+                memcpy(base, image.data(), image.size());
+                run_action();
+            }
+            const auto copy_time = fc::time_point::now() - start;
+
+            start = fc::time_point::now();
+            for (uint32_t i = 0; i < num_actions; ++i) {
+                Runtime::restoreMemorySnapshot(memory, snapshot);
+                run_action();
+            }
+            const auto snapshot_time = fc::time_point::now() - start;
+
+            BOOST_TEST_MESSAGE(name << ": " << image.size() << " bytes of data in " << type.size.min
+                                    << " pages, reset by copying in " << copy_time.count() / num_actions
+                                    << "us, by restoring a snapshot in " << snapshot_time.count() / num_actions
+                                    << "us per action");
+
+            // what the actions wrote, and memory they grew, is gone after restoring the snapshot
+            const bool can_grow = type.size.max > type.size.min;
+            if (can_grow) {
+                BOOST_REQUIRE_NE(Runtime::growMemory(memory, 1), -1);
+                base[memory_size] = 1;
+            }
+            Runtime::restoreMemorySnapshot(memory, snapshot);
+            BOOST_CHECK_EQUAL(Runtime::getMemoryNumPages(memory), type.size.min);
+            BOOST_CHECK(std::equal(image.begin(), image.end(), base));
+            BOOST_CHECK(std::all_of(base + image.size(), base + memory_size, [](uint8_t b) { return b == 0; }));
+            if (can_grow) {
+                BOOST_REQUIRE_NE(Runtime::growMemory(memory, 1), -1);
+                BOOST_CHECK_EQUAL(base[memory_size], 0);
+            }
+
+            // a module without a snapshot resets the memory instead, which mustn't bring back the snapshot's image
+            Runtime::restoreMemorySnapshot(memory, snapshot);
+            run_action();
+            IR::MemoryType reset_type = type;
+            Runtime::resetMemory(memory, reset_type);
+            BOOST_CHECK_EQUAL(Runtime::getMemoryNumPages(memory), type.size.min);
+            BOOST_CHECK(std::all_of(base, base + memory_size, [](uint8_t b) { return b == 0; }));
+
+            Runtime::destroyMemorySnapshot(snapshot);
+        }
+    } FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()